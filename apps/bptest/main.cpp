@@ -0,0 +1,211 @@
+/**
+ * bptest
+ *
+ * check the debugger's breakpoint condition language.
+ */
+
+/**
+ * Combines:
+ * BreakCondition (compiler and evaluator)
+ * CPU module (6502), for EADDR and DATA from real instructions
+ * MMU: II MMU with every page mapped to plain RAM, so the video scanner the CPU clocks has something to read.
+ *
+ * To use:
+ * /path/to/bptest
+ *
+ * Each condition is compiled and evaluated against a fixed machine state and
+ * must give the expected result; each bad condition must fail to compile.
+ * Then a few instructions are run with the trace off, and EADDR / DATA must
+ * describe each one. Exits nonzero if anything fails.
+ */
+#include <SDL3/SDL.h>
+
+#include "gs2.hpp"
+#include "cpu.hpp"
+#include "mmus/mmu.hpp"
+#include "mmus/mmu_ii.hpp"
+#include "display/VideoScannerII.hpp"
+#include "debugger/Breakpoints.hpp"
+#include "opcodes.hpp"
+
+gs2_app_t gs2_app_values;
+
+uint8_t memory[65536];
+
+uint64_t debug_level = 0;
+
+struct condition_record {
+    std::string text;
+    bool expected;
+};
+
+/**
+ * Against A=$15 X=$01 Y=$02 N and C set, [$10]=$34 [$11]=$12 [$1234]=$80.
+ */
+condition_record condition_records[] = {
+    // bitwise binds tighter than comparison
+    { "A&$0F==5", true },
+    { "A & $0F == $15", false },
+    { "(A&$0F)==5", true },
+    { "A&($0F==5)", false },
+    { "A|$20==$35", true },
+    { "A^$05==$10", true },
+    { "$0F&A==5&&X==1", true },
+
+    // two-character operators aren't taken apart
+    { "A<=$15", true },
+    { "A<$15", false },
+    { "A>=$16", false },
+    { "A>$14", true },
+    { "A!=$15", false },
+    { "!X", false },
+    { "!!X", true },
+    { "X==1&&Y==2", true },
+    { "X==2&&Y==2", false },
+    { "X==2||Y==2", true },
+    { "X==2||Y==3", false },
+    { "A&1&&X", true },
+    { "A&2&&X", false },
+    { "A|0||0", true },
+    { "0|0||X&2", false },
+    { "A<=$15&&X<2", true },
+
+    // peeks
+    { "[$10]==$34", true },
+    { "[$10+1]==$12", true },
+    { "{$10}==$1234", true },
+    { "[{$10}]==$80", true },
+    { "[{$10}]&$80==$80", true },
+    { "{ $10 } == 4660", true },
+
+    // flags, arithmetic
+    { "N&&C&&!Z", true },
+    { "V||D", false },
+    { "-1==0-1", true },
+    { "X+Y==3", true },
+    { "a==$15", true },
+};
+
+int condition_records_count = sizeof(condition_records) / sizeof(condition_records[0]);
+
+std::string bad_conditions[] = {
+    "A=5", "A==", "A&&", "A<<2", "[A", "{A", "(A", "B==1", "A==$", "A 1",
+};
+
+int bad_conditions_count = sizeof(bad_conditions) / sizeof(bad_conditions[0]);
+
+struct last_insn_record {
+    std::string description;
+    uint8_t op[3];
+    std::string condition;  // must be true after op runs
+};
+
+/**
+ * Run one after another from $1000, with Y=2, [$10]=$34 [$11]=$12 [$1234]=$80 [$1236]=$5A.
+ */
+last_insn_record last_insn_records[] = {
+    { "LDA $1234", { OP_LDA_ABS, 0x34, 0x12 }, "EADDR==$1234&&DATA==$80" },
+    { "TAX", { OP_TAX_IMP }, "EADDR==0&&DATA==$80" },   // a transfer's DATA is the value moved
+    { "LDA ($10),Y", { OP_LDA_IND_Y, 0x10 }, "EADDR==$1236&&DATA==$5A" },
+    { "STA $20", { OP_STA_ZP, 0x20 }, "EADDR==$20" },
+    { "INX", { OP_INX_IMP }, "EADDR==0&&DATA==0" },
+};
+
+int last_insn_records_count = sizeof(last_insn_records) / sizeof(last_insn_records[0]);
+
+/**
+ * ------------------------------------------------------------------------------------
+ * Main
+ */
+
+int main(int argc, char **argv) {
+
+    printf("Starting breakpoint condition test...\n");
+
+    gs2_app_values.base_path = "./";
+    gs2_app_values.pref_path = gs2_app_values.base_path;
+    gs2_app_values.console_mode = false;
+
+    // create MMU, map all pages to our "ram"
+    MMU_II *mmu = new MMU_II(256, 48*1024, new uint8_t[12*1024]());
+    for (int i = 0; i < 256; i++) {
+        mmu->map_page_both(i, &memory[i*256], "TEST RAM");
+    }
+
+    cpu_state *cpu = new cpu_state();
+    cpu->set_processor(PROCESSOR_6502);
+    cpu->set_mmu(mmu);
+    cpu->set_video_scanner(new VideoScannerII(mmu));
+    cpu->trace = false;
+
+    mmu->write(0x0010, 0x34);
+    mmu->write(0x0011, 0x12);
+    mmu->write(0x1234, 0x80);
+    mmu->write(0x1236, 0x5A);
+
+    int failedtests = 0;
+
+    cpu->a = 0x15;
+    cpu->x = 0x01;
+    cpu->y = 0x02;
+    cpu->p = FLAG_N | FLAG_C;
+    for (int i = 0; i < condition_records_count; i++) {
+        BreakCondition cond;
+        std::string error;
+        printf("%-30s ", condition_records[i].text.c_str());
+        if (!cond.compile(condition_records[i].text, error)) {
+            printf("FAILED [%s]\n", error.c_str());
+            failedtests++;
+            continue;
+        }
+        bool result = cond.evaluate(cpu, nullptr);
+        printf("%s", result ? "true" : "false");
+        if (result != condition_records[i].expected) {
+            printf(" FAILED");
+            failedtests++;
+        }
+        printf("\n");
+    }
+
+    for (int i = 0; i < bad_conditions_count; i++) {
+        BreakCondition cond;
+        std::string error;
+        printf("%-30s ", bad_conditions[i].c_str());
+        if (cond.compile(bad_conditions[i], error)) {
+            printf("FAILED [compiled]\n");
+            failedtests++;
+            continue;
+        }
+        printf("error: %s\n", error.c_str());
+    }
+
+    // the trace is off, as when the debugger hasn't turned it on.
+    cpu->pc = 0x1000;
+    cpu->y = 0x02;
+    uint16_t addr = 0x1000;
+    for (int i = 0; i < last_insn_records_count; i++) {
+        for (int j = 0; j < 3; j++) {
+            mmu->write(addr + j, last_insn_records[i].op[j]);
+        }
+        (cpu->execute_next)(cpu);
+        addr = cpu->pc;
+
+        BreakCondition cond;
+        std::string error;
+        printf("%-30s %-30s ", last_insn_records[i].description.c_str(), last_insn_records[i].condition.c_str());
+        if (!cond.compile(last_insn_records[i].condition, error)) {
+            printf("FAILED [%s]\n", error.c_str());
+            failedtests++;
+            continue;
+        }
+        if (!cond.evaluate(cpu, &cpu->trace_entry)) {
+            printf("FAILED [EADDR=$%04X DATA=$%02X]", cpu->trace_entry.eaddr, cpu->trace_entry.data);
+            failedtests++;
+        }
+        printf("\n");
+    }
+
+    printf("Failed tests: %d\n", failedtests);
+
+    return failedtests ? 1 : 0;
+}
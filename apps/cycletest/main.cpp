@@ -7,7 +7,7 @@
 /**
  * Combines: 
  * CPU module (6502 or 65c02)
- * MMU: Base MMU with no Apple-II specific features.
+ * MMU: II MMU with every page mapped to plain RAM, so the video scanner the CPU clocks has something to read.
  * 
  * To use: 
  * cd 6502_65c02_functional_tests/bin_files
@@ -19,12 +19,19 @@
  * You may need to review the 6502_functional_test.lst file to understand the test suite, if it should fail.
  * on a test failure, the suite will execute an instruction that jumps to itself. Our main loop tests for this
  * condition and exits with the PC of the failed test.
+ *
+ * After the cycle counts, the countdown loops fast_forward_loop() knows are run once interpreted and once
+ * fast-forwarded from the same state, and must agree on registers, flags and cycles wherever they're compared.
  */
 #include <SDL3/SDL.h>
 
 #include "gs2.hpp"
 #include "cpu.hpp"
 #include "mmus/mmu.hpp"
+#include "mmus/mmu_ii.hpp"
+#include "display/VideoScannerII.hpp"
+#include "cpus/fast_forward.hpp"
+#include "opcodes.hpp"
 
 gs2_app_t gs2_app_inues;
 
@@ -1282,6 +1289,164 @@ bool test_instruction(cpu_state *cpu, test_record *testrec) {
     return true;
 }
 
+/**
+ * ------------------------------------------------------------------------------------
+ * Fast-forwarded loops
+ */
+
+struct loop_record {
+    std::string description;
+
+    uint16_t pc;            // the loop's first instruction
+    uint8_t code[4];
+    int code_size;          // the loop ends when PC gets past this
+
+    uint8_t a_in = 0;
+    uint8_t x_in = 0;
+    uint8_t y_in = 0;
+    uint8_t p_in = 0;
+
+    uint32_t bus_cycles_in = 0;
+    uint64_t next_event = UINT64_MAX;
+};
+
+loop_record loop_records[] = {
+    {
+        "DEX/BNE",
+        0x1000, {OP_DEX_IMP, OP_BNE_REL, 0xFD}, 3,
+        0, 0xFF, 0, 0
+    },
+    {
+        "DEY/BNE",
+        0x1000, {OP_DEY_IMP, OP_BNE_REL, 0xFD}, 3,
+        0, 0, 0x80, 0
+    },
+    {
+        "DEX/BNE across a page",
+        0x10FF, {OP_DEX_IMP, OP_BNE_REL, 0xFD}, 3,   // BNE at $1100 back to $10FF: 4 cycles
+        0, 0xFF, 0, 0
+    },
+    {
+        "DEX/BNE stopped by event",
+        0x1000, {OP_DEX_IMP, OP_BNE_REL, 0xFD}, 3,   // skip ends with X >= $80: N set
+        0, 0xFF, 0, 0,
+        0, 40
+    },
+    {
+        "DEY/BNE stopped by frame end",
+        0x1000, {OP_DEY_IMP, OP_BNE_REL, 0xFD}, 3,
+        0, 0, 0xFF, 0,
+        17000
+    },
+    {
+        "SBC #1/BNE",
+        0x1000, {OP_SBC_IMM, 0x01, OP_BNE_REL, 0xFC}, 4,
+        0xFF, 0, 0, FLAG_C
+    },
+    {
+        "SBC #1/BNE from A=$00",
+        0x1000, {OP_SBC_IMM, 0x01, OP_BNE_REL, 0xFC}, 4,
+        0x00, 0, 0, FLAG_C
+    },
+    {
+        "SBC #1/BNE from A=$81",
+        0x1000, {OP_SBC_IMM, 0x01, OP_BNE_REL, 0xFC}, 4,   // first skip starts at A=$80
+        0x81, 0, 0, FLAG_C
+    },
+    {
+        "SBC #1/BNE ending on A=$80",
+        0x1000, {OP_SBC_IMM, 0x01, OP_BNE_REL, 0xFC}, 4,   // one pass to $84, then the event stops
+        0x85, 0, 0, FLAG_C,                                 // the skip on $80 -> $7F: V set
+        0, 31
+    },
+    {
+        "SBC #1/BNE across a page",
+        0x10FE, {OP_SBC_IMM, 0x01, OP_BNE_REL, 0xFC}, 4,
+        0xFF, 0, 0, FLAG_C
+    },
+};
+
+int loop_records_count = sizeof(loop_records) / sizeof(loop_records[0]);
+
+/** One instruction, with the frame loop's bus cycle wrap. */
+void run_instruction(cpu_state *cpu) {
+    (cpu->execute_next)(cpu);
+    if (cpu->bus_cycles >= 17030) {
+        cpu->bus_cycles -= 17030;
+        cpu->get_video_scanner()->end_video_cycle();
+    }
+}
+
+bool same_state(cpu_state *interpreted, cpu_state *skipped) {
+    if (interpreted->pc == skipped->pc && interpreted->a_lo == skipped->a_lo
+        && interpreted->x_lo == skipped->x_lo && interpreted->y_lo == skipped->y_lo
+        && interpreted->N == skipped->N && interpreted->V == skipped->V
+        && interpreted->Z == skipped->Z && interpreted->C == skipped->C
+        && interpreted->cycles == skipped->cycles && interpreted->bus_cycles == skipped->bus_cycles) {
+        return true;
+    }
+    cpu_state *cpus[2] = { interpreted, skipped };
+    for (int i = 0; i < 2; i++) {
+        printf("\n    %s PC:%04X A:%02X X:%02X Y:%02X NVZC:%d%d%d%d cycles:%llu bus_cycles:%u",
+            i == 0 ? "interpreted:   " : "fast-forwarded:",
+            cpus[i]->pc, cpus[i]->a_lo, cpus[i]->x_lo, cpus[i]->y_lo,
+            cpus[i]->N, cpus[i]->V, cpus[i]->Z, cpus[i]->C,
+            (unsigned long long)cpus[i]->cycles, cpus[i]->bus_cycles);
+    }
+    return false;
+}
+
+/**
+ * Runs the loop to its end twice, once interpreted and once letting
+ * fast_forward_loop() skip where it can. At every skip the interpreted
+ * run is caught up to the same cycle, and the two have to match there
+ * and at the end. A loop that never gets skipped fails too.
+ */
+bool test_loop(MMU *mmu, cpu_state *interpreted, cpu_state *skipped, loop_record *rec) {
+    for (int i = 0; i < rec->code_size; i++) {
+        mmu->write(rec->pc + i, rec->code[i]);
+    }
+    cpu_state *cpus[2] = { interpreted, skipped };
+    for (int i = 0; i < 2; i++) {
+        cpus[i]->pc = rec->pc;
+        cpus[i]->a = rec->a_in;
+        cpus[i]->x = rec->x_in;
+        cpus[i]->y = rec->y_in;
+        cpus[i]->p = rec->p_in;
+        cpus[i]->cycles = 0;
+        cpus[i]->bus_cycles = rec->bus_cycles_in;
+        cpus[i]->ns_since_bus_cycle = 0;
+        cpus[i]->loop_hint = 0;
+    }
+    uint16_t end = rec->pc + rec->code_size;
+
+    int skips = 0;
+    while (skipped->pc != end) {
+        run_instruction(skipped);
+        if (skipped->loop_hint) {
+            uint64_t before = skipped->cycles;
+            fast_forward_loop(skipped, rec->next_event);
+            if (skipped->cycles != before) {
+                skips++;
+                while (interpreted->cycles < skipped->cycles) {
+                    run_instruction(interpreted);
+                }
+                if (!same_state(interpreted, skipped)) return false;
+            }
+        }
+    }
+    while (interpreted->pc != end) {
+        run_instruction(interpreted);
+    }
+    if (!same_state(interpreted, skipped)) return false;
+    if (skips == 0) {
+        printf("\n    never skipped");
+        return false;
+    }
+    printf("%d skips, ended at %llu cycles", skips, (unsigned long long)skipped->cycles);
+    return true;
+}
+
 /**
  * ------------------------------------------------------------------------------------
  * Main
@@ -1301,7 +1466,7 @@ int main(int argc, char **argv) {
 
 
 // create MMU, map all pages to our "ram"
-    MMU *mmu = new MMU(256);
+    MMU_II *mmu = new MMU_II(256, 48*1024, new uint8_t[12*1024]());
     for (int i = 0; i < 256; i++) {
         mmu->map_page_both(i, &memory[i*256], "TEST RAM");
     }
@@ -1311,6 +1476,7 @@ int main(int argc, char **argv) {
     //cpu->init();
     cpu->trace = trace_on;
     cpu->set_mmu(mmu);
+    cpu->set_video_scanner(new VideoScannerII(mmu));
 
     uint64_t start_time = SDL_GetTicksNS();
 
@@ -1348,7 +1514,25 @@ int main(int argc, char **argv) {
         printf("\n");
     }
 
+    // trace left at its default, as the emulator runs
+    cpu_state *interpreted = new cpu_state();
+    cpu_state *skipped = new cpu_state();
+    cpu_state *loop_cpus[2] = { interpreted, skipped };
+    for (int i = 0; i < 2; i++) {
+        loop_cpus[i]->set_processor(PROCESSOR_6502);
+        loop_cpus[i]->set_mmu(mmu);
+        loop_cpus[i]->set_video_scanner(new VideoScannerII(mmu));
+    }
+    for (int i = 0; i < loop_records_count; i++) {
+        printf("%-30s ", loop_records[i].description.c_str());
+        if (!test_loop(mmu, interpreted, skipped, &loop_records[i])) {
+            printf("\nFAILED");
+            failedtests++;
+        }
+        printf("\n");
+    }
+
     printf("Failed tests: %d\n", failedtests);
 
-    return 0;
+    return failedtests ? 1 : 0;
 }
@@ -0,0 +1,133 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+
+#include "util/media.hpp"
+#include "util/MappedFile.hpp"
+#include "util/ChunkedImage.hpp"
+
+/**
+ * gscpack - convert between flat block images (.hdv, .po, .2mg) and
+ * the sparse/compressed .gsc container.
+ */
+
+void print_usage(const char* program_name) {
+    fprintf(stderr, "Usage: %s [-c chunk_kb] input_image output.gsc\n", program_name);
+    fprintf(stderr, "       %s -x input.gsc output.hdv\n", program_name);
+    fprintf(stderr, "       %s -r image.gsc\n", program_name);
+    fprintf(stderr, "  -c chunk_kb   Chunk size in KB (default: %d)\n", GSC_DEFAULT_CHUNK_SIZE / 1024);
+    fprintf(stderr, "  -x            Expand a .gsc back to a flat image\n");
+    fprintf(stderr, "  -r            Repack a .gsc in place, dropping space left by rewritten chunks\n");
+    exit(1);
+}
+
+int pack(const char *input_filename, const char *output_filename, uint32_t chunk_size) {
+    media_descriptor md;
+    md.filename = input_filename;
+    if (identify_media(md) != 0) {
+        std::cerr << "Failed to identify media: " << input_filename << std::endl;
+        return 1;
+    }
+    if (md.container != CONTAINER_FLAT || md.media_type == MEDIA_PRENYBBLE) {
+        std::cerr << "Can only pack flat block images: " << input_filename << std::endl;
+        return 1;
+    }
+
+    MappedFile src;
+    if (!src.open(md.filename, true)) return 1;
+    if (md.data_offset + (uint64_t)md.block_size * md.block_count > src.size()) {
+        std::cerr << "Image is shorter than its header says: " << input_filename << std::endl;
+        return 1;
+    }
+    if (!ChunkedImage::create(output_filename, src.data() + md.data_offset, md.block_size, md.block_count, chunk_size)) {
+        return 1;
+    }
+
+    gsc_header_t hdr;
+    ChunkedImage::read_header(output_filename, hdr);
+    media_descriptor out;
+    out.filename = output_filename;
+    identify_media(out);
+    printf("%s: %u blocks of %u bytes, %u chunks, %llu -> %llu bytes\n", output_filename,
+        hdr.block_count, hdr.block_size, hdr.chunk_count,
+        (unsigned long long)md.file_size, (unsigned long long)out.file_size);
+    return 0;
+}
+
+int expand(const char *input_filename, const char *output_filename) {
+    ChunkedImage img;
+    if (!img.open(input_filename, true)) return 1;
+
+    FILE *out = fopen(output_filename, "wb");
+    if (out == nullptr) {
+        std::cerr << "Could not create " << output_filename << std::endl;
+        return 1;
+    }
+    gsc_header_t hdr;
+    ChunkedImage::read_header(input_filename, hdr);
+    bool ok = true;
+    for (uint32_t b = 0; b < img.get_block_count() && ok; b++) {
+        ok = img.read_block(b, [&](const uint8_t *data) {
+            ok = fwrite(data, 1, hdr.block_size, out) == hdr.block_size;
+        }) && ok;
+    }
+    ok = (fclose(out) == 0) && ok;
+    if (!ok) {
+        std::cerr << "Error writing " << output_filename << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t chunk_size = GSC_DEFAULT_CHUNK_SIZE;
+    bool do_expand = false;
+    bool do_repack = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:xr")) != -1) {
+        switch (opt) {
+            case 'c':
+                chunk_size = (uint32_t)atoi(optarg) * 1024;
+                if (chunk_size == 0) print_usage(argv[0]);
+                break;
+            case 'x':
+                do_expand = true;
+                break;
+            case 'r':
+                do_repack = true;
+                break;
+            default:
+                print_usage(argv[0]);
+        }
+    }
+    if (do_repack) {
+        if (optind + 1 != argc) print_usage(argv[0]);
+        return ChunkedImage::compact(argv[optind]) ? 0 : 1;
+    }
+    if (optind + 2 != argc) {
+        print_usage(argv[0]);
+    }
+
+    if (do_expand) return expand(argv[optind], argv[optind + 1]);
+    return pack(argv[optind], argv[optind + 1], chunk_size);
+}
@@ -1,12 +1,136 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include "debugger/trace.hpp"
+#include "debugger/TraceFile.hpp"
+#include "debugger/TraceQuery.hpp"
+
+/**
+ * gstrace - search and decode .gstrace files.
+ *
+ *   gstrace trace.gstrace addr C0xx write cycles 1000000-2000000
+ *
+ * With no query terms and a terminal on stdin, reads queries interactively.
+ */
+
+void print_usage(const char* program_name) {
+    fprintf(stderr, "Usage: %s [-j threads] [-r] tracefile [query...]\n", program_name);
+    fprintf(stderr, "  -j threads    Worker threads for indexing and decoding (default: one per core)\n");
+    fprintf(stderr, "  -r            Rebuild the sidecar index\n");
+    fprintf(stderr, "Query terms (all must match):\n");
+    fprintf(stderr, "  cycles A-B    Cycle range; either end may be omitted\n");
+    fprintf(stderr, "  pc RANGE      PC range, e.g. 0300-03FF or FDxx\n");
+    fprintf(stderr, "  addr RANGE    Effective address range, e.g. C0xx\n");
+    fprintf(stderr, "  op OP         Mnemonic (STA) or opcode byte (8D); may be repeated\n");
+    fprintf(stderr, "  read | write  Only instructions that read / write addr\n");
+    fprintf(stderr, "  limit N       Stop after N matches\n");
+    fprintf(stderr, "  info          Print trace file statistics\n");
+    exit(1);
+}
+
+void print_info(TraceFileReader &reader) {
+    uint64_t nblocks = reader.get_block_count();
+    printf("%llu entries in %llu blocks, %llu bytes%s\n", (unsigned long long)reader.get_entry_count(),
+        (unsigned long long)nblocks, (unsigned long long)reader.get_file_size(),
+        reader.is_complete() ? "" : " (no index, recovered by scanning)");
+    if (nblocks) {
+        printf("cycles %llu - %llu\n", (unsigned long long)reader.get_block_info(0).first_cycle,
+            (unsigned long long)reader.get_block_info(nblocks - 1).last_cycle);
+    }
+}
+
+bool run_query(TraceFileReader &reader, TraceQuery &query, const std::vector<std::string> &terms) {
+    if (terms.size() == 1 && terms[0] == "info") {
+        print_info(reader);
+        return true;
+    }
+    trace_query_t q;
+    std::string error;
+    if (!q.parse(terms, error)) {
+        std::cerr << error << std::endl;
+        return false;
+    }
+    uint64_t matched = query.run(q, [](const std::string &line) {
+        fputs(line.c_str(), stdout);
+        fputc('\n', stdout);
+    });
+    fflush(stdout);
+    fprintf(stderr, "%llu matches\n", (unsigned long long)matched);
+    return true;
+}
 
 int main(int argc, char **argv) {
-    system_trace_buffer trace_buffer(100000);
-    trace_buffer.read_from_file("trace.bin");
+    unsigned int threads = 0;
+    bool rebuild = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:r")) != -1) {
+        switch (opt) {
+            case 'j':
+                threads = (unsigned int)atoi(optarg);
+                break;
+            case 'r':
+                rebuild = true;
+                break;
+            default:
+                print_usage(argv[0]);
+        }
+    }
+    if (optind >= argc) {
+        print_usage(argv[0]);
+    }
+    std::string filename = argv[optind++];
+
+    TraceFileReader reader;
+    if (!reader.open(filename)) {
+        return 1;
+    }
+    TraceQuery query(reader, threads);
+    if (!query.load_index(filename, rebuild)) {
+        std::cerr << "Failed to index " << filename << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> terms(argv + optind, argv + argc);
+    if (!terms.empty() || !isatty(fileno(stdin))) {
+        return run_query(reader, query, terms) ? 0 : 1;
+    }
 
-    for (size_t i = 0; i < trace_buffer.size; i++) {
-        system_trace_entry_t *entry = trace_buffer.get_entry(i);
-        trace_buffer.decode_trace_entry(entry);
+    print_info(reader);
+    std::string line;
+    while (true) {
+        printf("gstrace> ");
+        fflush(stdout);
+        if (!std::getline(std::cin, line)) break;
+        std::istringstream iss(line);
+        std::vector<std::string> words;
+        std::string w;
+        while (iss >> w) words.push_back(w);
+        if (words.empty()) continue;
+        if (words[0] == "quit" || words[0] == "q") break;
+        run_query(reader, query, words);
     }
+    return 0;
 }
@@ -0,0 +1,98 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <inttypes.h>
+
+#include "util/media.hpp"
+#include "util/MediaIndex.hpp"
+
+/**
+ * mediaindex - build and query a catalog of disk images.
+ */
+
+void print_usage(const char* program_name) {
+    fprintf(stderr, "Usage: %s [-i index] [-j threads] scan dir [dir...]\n", program_name);
+    fprintf(stderr, "       %s [-i index] find text\n", program_name);
+    fprintf(stderr, "       %s [-i index] dups\n", program_name);
+    fprintf(stderr, "       %s [-i index] list\n", program_name);
+    fprintf(stderr, "  -i index      Index file (default: media.index)\n");
+    fprintf(stderr, "  -j threads    Worker threads for scan (default: one per core)\n");
+    exit(1);
+}
+
+void print_entry(const media_index_entry_t *e) {
+    printf("%-10s %-6s %6u x %-4u %-16s %016" PRIx64 " %016" PRIx64 "  %s\n",
+        get_media_type_name(e->media_type), get_interleave_name(e->interleave),
+        e->block_count, e->block_size, e->volume_name.c_str(),
+        e->content_hash, e->boot_fingerprint, e->path.c_str());
+}
+
+int main(int argc, char *argv[]) {
+    const char *index_filename = "media.index";
+    unsigned int threads = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:j:")) != -1) {
+        switch (opt) {
+            case 'i':
+                index_filename = optarg;
+                break;
+            case 'j':
+                threads = (unsigned int)atoi(optarg);
+                break;
+            default:
+                print_usage(argv[0]);
+        }
+    }
+    if (optind >= argc) {
+        print_usage(argv[0]);
+    }
+    std::string cmd = argv[optind++];
+
+    MediaIndex index(index_filename);
+    index.load();
+
+    if (cmd == "scan") {
+        if (optind >= argc) print_usage(argv[0]);
+        std::vector<std::string> roots(argv + optind, argv + argc);
+        media_scan_stats_t st = index.scan(roots, threads);
+        printf("%d images: %d indexed, %d unchanged, %d failed, %d removed\n",
+            st.found, st.indexed, st.unchanged, st.failed, st.removed);
+        if (!index.save()) {
+            std::cerr << "Failed to save index " << index_filename << std::endl;
+            return 1;
+        }
+    } else if (cmd == "find") {
+        if (optind >= argc) print_usage(argv[0]);
+        for (const media_index_entry_t *e : index.find(argv[optind])) print_entry(e);
+    } else if (cmd == "dups") {
+        for (auto &group : index.duplicates()) {
+            for (const media_index_entry_t *e : group) print_entry(e);
+            printf("\n");
+        }
+    } else if (cmd == "list") {
+        for (const media_index_entry_t *e : index.find("")) print_entry(e);
+    } else {
+        print_usage(argv[0]);
+    }
+    return 0;
+}
@@ -28,6 +28,7 @@ typedef enum {
     CLOCK_1_024MHZ,
     CLOCK_2_8MHZ,
     CLOCK_4MHZ,
+    CLOCK_CUSTOM,       // rate given with -c, e.g. to model an accelerator card. Unused until set.
     NUM_CLOCK_MODES
 } clock_mode_t;
 
@@ -37,7 +38,8 @@ typedef struct {
     uint64_t cycles_per_burst;
 } clock_mode_info_t;
 
-extern clock_mode_info_t clock_mode_info[NUM_CLOCK_MODES];
+/** Power-on values. Each cpu_state gets its own copy, since free-run mode retunes it. */
+extern const clock_mode_info_t default_clock_mode_info[NUM_CLOCK_MODES];
 
 //void emulate_clock_cycle(cpu_state *cpu) ;
 
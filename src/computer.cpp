@@ -1,3 +1,4 @@
+#include <cstring>
 #include <iostream>
 
 #include "gs2.hpp"
@@ -7,12 +8,15 @@
 #include "debugger/debugwindow.hpp"
 #include "util/EventDispatcher.hpp"
 #include "util/EventTimer.hpp"
+#include "util/Snapshot.hpp"
+#include "util/InputLog.hpp"
+#include "util/Timeline.hpp"
 #include "videosystem.hpp"
 #include "util/mount.hpp"
 #include "platforms.hpp"
 #include "mbus/MessageBus.hpp"
 
-computer_t::computer_t() {
+computer_t::computer_t(bool headless) : headless(headless) {
     // lots of stuff is going to need this.
     event_queue = new EventQueue();
     if (!event_queue) {
@@ -22,8 +26,15 @@ computer_t::computer_t() {
 
     event_timer = new EventTimer();
 
+    input_log = new InputLog();
+    input_log->register_handler(INPUT_RESET, [this](const input_event_t &event) {
+        reset(event.data != 0);
+    });
+
     mbus = new MessageBus();
 
+    metrics = new FrameMetrics();
+
     sys_event = new EventDispatcher(); // different queue for "system" events that get processed first.
     dispatch = new EventDispatcher(); // has to be very first thing, devices etc are going to immediately register handlers.
     device_frame_dispatcher = new DeviceFrameDispatcher();
@@ -31,26 +42,50 @@ computer_t::computer_t() {
     cpu = new cpu_state();
     //cpu->init();
 
-    mounts = new Mounts(cpu);
+    mounts = new Mounts(cpu, input_log);
+
+    // logged mounts go through whatever Mounts the machine ended up with.
+    input_log->register_handler(INPUT_MOUNT, [this](const input_event_t &event) {
+        disk_mount_t disk_mount;
+        disk_mount.slot = (int)(event.data >> 8);
+        disk_mount.drive = (int)(event.data & 0xFF);
+        disk_mount.filename = event.text;
+        mounts->mount_media(disk_mount);
+    });
+    input_log->register_handler(INPUT_UNMOUNT, [this](const input_event_t &event) {
+        mounts->unmount_media(event.data, DISCARD); // the live run already wrote the image back
+    });
+    input_log->register_handler(INPUT_CLOCK, [this](const input_event_t &event) {
+        memcpy(&cpu->cycle_duration_ns, &event.data, sizeof(cpu->cycle_duration_ns));
+    });
 
     video_system = new video_system_t(this);
-    debug_window = new debug_window_t(this);
+    if (!headless) {
+        debug_window = new debug_window_t(this);
+    }
 
     sys_event->registerHandler(SDL_EVENT_KEY_DOWN, [this](const SDL_Event &event) {
         int key = event.key.key;
         SDL_Keymod mod = event.key.mod;
         if ((mod & SDL_KMOD_CTRL) && (key == SDLK_F10)) {
-            if (mod & SDL_KMOD_ALT) {
-                reset(true); 
-            } else {
-                reset(false); 
-            }
+            if (input_log->is_replaying()) return true;
+            bool cold_start = (mod & SDL_KMOD_ALT) != 0;
+            reset(cold_start);
+            input_log->record(cpu->cycles, INPUT_RESET, cold_start);
             return true;
         }
         if (key == SDLK_F12) { 
             cpu->halt = HLT_USER; 
             return true;
         }
+        if (key == SDLK_F8 && (mod & SDL_KMOD_SHIFT)) {
+            std::string path = gs2_app_values.timeline_path.empty() ? gs2_app_values.pref_path + "timeline.json" : gs2_app_values.timeline_path;
+            if (timeline_write(path)) {
+                snprintf(message, sizeof(message), "Timeline saved to %s", path.c_str());
+                event_queue->addEvent(new Event(EVENT_SHOW_MESSAGE, 0, message));
+            }
+            return true;
+        }
         if (key == SDLK_F9) { 
             toggle_clock_mode(cpu);
             send_clock_mode_message();
@@ -74,6 +109,8 @@ computer_t::~computer_t() {
     delete video_system;
     delete debug_window;
     delete event_timer;
+    delete input_log;
+    delete metrics;
     delete sys_event;
     delete dispatch;
     delete device_frame_dispatcher;
@@ -87,6 +124,65 @@ void computer_t::register_shutdown_handler(ShutdownHandler handler) {
     shutdown_handlers.push_back(handler);
 }
 
+void computer_t::register_snapshot_handler(SnapshotSaveHandler save, SnapshotRestoreHandler restore) {
+    snapshot_handlers.push_back({save, restore});
+}
+
+uint64_t computer_t::history_floor() const {
+    uint64_t floor = UINT64_MAX;
+    for (auto& hold : history_holds) {
+        if (hold.second < floor) floor = hold.second;
+    }
+    return floor;
+}
+
+void computer_t::save_snapshot(SnapshotWriter &w) {
+    w.begin(platform->id);
+    cpu->save_state(w);
+    mmu->save_state(w);
+    event_timer->saveState(w);
+    if (video_scanner) video_scanner->save_state(w);
+    for (auto& handler : snapshot_handlers) {
+        handler.save(w);
+    }
+}
+
+bool computer_t::restore_snapshot(SnapshotReader &r) {
+    if (r.platform_id() != (uint32_t)platform->id) {
+        fprintf(stderr, "Snapshot is for platform %u, this machine is %d\n", r.platform_id(), platform->id);
+        return false;
+    }
+    for (const std::string &card : unsnapshotted_cards) {
+        fprintf(stderr, "Snapshot: %s has no snapshot state; not restoring\n", card.c_str());
+    }
+    if (!snapshots_complete()) return false;
+    bool ok = true;
+    if (!mmu->restore_state(r)) {
+        fprintf(stderr, "Snapshot: MMU state missing or doesn't fit this machine\n");
+        return false; // nothing else can be trusted without memory.
+    }
+    if (!cpu->restore_state(r)) { fprintf(stderr, "Snapshot: no CPU state\n"); ok = false; }
+    if (!event_timer->restoreState(r)) { fprintf(stderr, "Snapshot: no event timer state\n"); ok = false; }
+    if (video_scanner && !video_scanner->restore_state(r)) { fprintf(stderr, "Snapshot: no video scanner state\n"); ok = false; }
+    for (auto& handler : snapshot_handlers) {
+        if (!handler.restore(r)) ok = false;
+    }
+    event_timer->endRestore();
+    return ok;
+}
+
+bool computer_t::save_snapshot_file(const std::string &filename) {
+    SnapshotWriter w;
+    save_snapshot(w);
+    return w.save_file(filename);
+}
+
+bool computer_t::restore_snapshot_file(const std::string &filename) {
+    SnapshotReader r;
+    if (!r.load_file(filename)) return false;
+    return restore_snapshot(r);
+}
+
 void computer_t::reset(bool cold_start) {
 
     if (cold_start) {
@@ -166,7 +262,6 @@ void computer_t::set_slot_irq(uint8_t slot, bool irq) {
 
 // TODO: should live inside a reconstituted clock class.
 void computer_t::send_clock_mode_message() {
-    static char buffer[256];
     const char *clock_mode_names[] = {
         "Ludicrous Speed",
         "1.0205MHz",
@@ -174,6 +269,10 @@ void computer_t::send_clock_mode_message() {
         "4.0 MHz"
     };
 
-    snprintf(buffer, sizeof(buffer), "Clock Mode Set to %s", clock_mode_names[cpu->clock_mode]);
-    event_queue->addEvent(new Event(EVENT_SHOW_MESSAGE, 0, buffer));
+    if (cpu->clock_mode == CLOCK_CUSTOM) {
+        snprintf(message, sizeof(message), "Clock Mode Set to %.4g MHz", cpu->clock_mode_info[CLOCK_CUSTOM].hz_rate / 1.0E6);
+    } else {
+        snprintf(message, sizeof(message), "Clock Mode Set to %s", clock_mode_names[cpu->clock_mode]);
+    }
+    event_queue->addEvent(new Event(EVENT_SHOW_MESSAGE, 0, message));
 }
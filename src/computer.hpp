@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+#include <string>
 #include <vector>
 
 #include "mmus/mmu_ii.hpp"
@@ -8,6 +10,7 @@
 #include "util/EventDispatcher.hpp"
 #include "util/EventQueue.hpp"
 #include "util/DeviceFrameDispatcher.hpp"
+#include "util/FrameMetrics.hpp"
 #include "platforms.hpp"
 #include "mbus/MessageBus.hpp"
 
@@ -17,6 +20,9 @@ struct video_system_t; // same.
 class Mounts;
 class EventTimer;
 class VideoScannerII;
+class SnapshotWriter;
+class SnapshotReader;
+class InputLog;
 
 /* typedef void (*reset_handler_t)(void *context);
 
@@ -29,6 +35,13 @@ struct computer_t {
 
     using ResetHandler = std::function<bool ()>;
     using ShutdownHandler = std::function<bool ()>;
+    using SnapshotSaveHandler = std::function<void (SnapshotWriter &)>;
+    using SnapshotRestoreHandler = std::function<bool (SnapshotReader &)>;
+
+    struct snapshot_handler_t {
+        SnapshotSaveHandler save;
+        SnapshotRestoreHandler restore;
+    };
 
     cpu_state *cpu = nullptr;
     MMU_II *mmu = nullptr;
@@ -44,19 +57,30 @@ struct computer_t {
 
     EventTimer *event_timer = nullptr;
 
+    InputLog *input_log = nullptr;
+
+    FrameMetrics *metrics = nullptr;
+
     EventQueue *event_queue = nullptr;
 
     DeviceFrameDispatcher *device_frame_dispatcher = nullptr;
 
     Mounts *mounts = nullptr;
 
+    bool headless = false; // no window, renderer, audio device or debugger
+
+    char message[256]; // text for EVENT_SHOW_MESSAGE; the event keeps the pointer
+
     std::vector<ResetHandler> reset_handlers;
     std::vector<ShutdownHandler> shutdown_handlers;
+    std::vector<snapshot_handler_t> snapshot_handlers;
+    std::vector<std::string> unsnapshotted_cards;  // slot cards that registered no snapshot handler
+    std::map<const void *, uint64_t> history_holds; // holder -> cycle its oldest snapshot was taken at
     
     void *module_store[MODULE_NUM_MODULES];
     SlotData *slot_store[NUM_SLOTS];
 
-    computer_t();
+    computer_t(bool headless = false);
     ~computer_t();
     void set_mmu(MMU_II *mmu) { this->mmu = mmu; }
     void set_platform(platform_info *platform) { this->platform = platform; }
@@ -65,6 +89,38 @@ struct computer_t {
     void register_reset_handler(ResetHandler handler);
     void register_shutdown_handler(ShutdownHandler handler);
 
+    /**
+     * Devices register a pair of handlers that write and read their own chunks.
+     * Restore runs them in registration order, after the CPU, MMU, video
+     * scanner and event timer, so a device can remap pages from its soft
+     * switches and re-arm its timers. Restore never replays I/O.
+     */
+    void register_snapshot_handler(SnapshotSaveHandler save, SnapshotRestoreHandler restore);
+    void save_snapshot(SnapshotWriter &w);
+    bool restore_snapshot(SnapshotReader &r);
+    bool save_snapshot_file(const std::string &filename);
+    bool restore_snapshot_file(const std::string &filename);
+
+    /**
+     * False if a slot card keeps state that snapshots don't cover. Restore
+     * refuses such a machine, and features that roll the machine back
+     * (rewind, run-ahead, checkpoints, reverse stepping) stay off.
+     */
+    bool snapshots_complete() const { return unsnapshotted_cards.empty(); }
+
+    /**
+     * Whoever keeps snapshots to restore later in this session (the rewind
+     * buffer, the debugger's checkpoints) holds history back to the cycle its
+     * oldest was taken at, and releases it when it drops them all. Devices
+     * that have to keep something to roll back to a snapshot - the ProDOS
+     * block device's overwritten blocks - keep it back to the oldest hold,
+     * and keep nothing while there's none.
+     */
+    void hold_history(const void *holder, uint64_t oldest_cycle) { history_holds[holder] = oldest_cycle; }
+    void release_history(const void *holder) { history_holds.erase(holder); }
+    bool history_held() const { return !history_holds.empty(); }
+    uint64_t history_floor() const;
+
     void *get_module_state( module_id_t module_id);
     void set_module_state( module_id_t module_id, void *state);
 
@@ -18,9 +18,13 @@
 #include <cstdio>
 #include <time.h>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #include "cpu.hpp"
+#include "debugger/Profiler.hpp"
+#include "debugger/Coverage.hpp"
+#include "util/Snapshot.hpp"
 
 // 59.9227434
 #define CLK_28MHZ 28.63636E6
@@ -38,11 +42,12 @@
 #define CLK_IIGS (CLK_28MHZ / 10)
 #define CLK_4MHZ (4 *CLK_1MHZ)
 
-clock_mode_info_t clock_mode_info[NUM_CLOCK_MODES] = {
+const clock_mode_info_t default_clock_mode_info[NUM_CLOCK_MODES] = {
     { CLK_4MHZ, (1.0E9 / CLK_4MHZ), 4*NUM_1MHZ_CYCLES_PER_FRAME },
     { CLK_1MHZ, (1.0E9 / CLK_1MHZ), NUM_1MHZ_CYCLES_PER_FRAME },
     { CLK_IIGS, (1.0E9 / CLK_IIGS), (uint64_t)(NUM_1MHZ_CYCLES_PER_FRAME*CLK_IIGS/CLK_1MHZ) },
-    { CLK_4MHZ, (1.0E9 / CLK_4MHZ), 4*NUM_1MHZ_CYCLES_PER_FRAME }
+    { CLK_4MHZ, (1.0E9 / CLK_4MHZ), 4*NUM_1MHZ_CYCLES_PER_FRAME },
+    { 0, 0, 0 }
 };
 
 void set_clock_mode(cpu_state *cpu, clock_mode_t mode) {
@@ -50,16 +55,37 @@ void set_clock_mode(cpu_state *cpu, clock_mode_t mode) {
     // immediately in order to avoid weird calculations around.
     // So add a "speedshift" cpu flag.
 
-    cpu->HZ_RATE = clock_mode_info[mode].hz_rate;
+    cpu->HZ_RATE = cpu->clock_mode_info[mode].hz_rate;
     // Lookup time per emulated cycle
-    cpu->cycle_duration_ns = clock_mode_info[mode].cycle_duration_ns;
+    cpu->cycle_duration_ns = cpu->clock_mode_info[mode].cycle_duration_ns;
 
     cpu->clock_mode = mode;
     fprintf(stdout, "Clock mode: %d HZ_RATE: %llu cycle_duration_ns: %g \n", cpu->clock_mode, cpu->HZ_RATE, cpu->cycle_duration_ns);
 }
 
+/**
+ * Set the rate for CLOCK_CUSTOM and switch to it. The video scanner, audio
+ * and everything else clocked off the 1MHz bus keep their own rate - only the
+ * CPU runs faster - so hz can't be slower than the bus.
+ */
+bool set_custom_clock_rate(cpu_state *cpu, double hz) {
+    if (hz < CLK_1MHZ) {
+        fprintf(stderr, "Clock rate %g Hz is slower than the %g Hz bus\n", hz, CLK_1MHZ);
+        return false;
+    }
+    cpu->clock_mode_info[CLOCK_CUSTOM].hz_rate = hz;
+    cpu->clock_mode_info[CLOCK_CUSTOM].cycle_duration_ns = 1.0E9 / hz;
+    cpu->clock_mode_info[CLOCK_CUSTOM].cycles_per_burst = (uint64_t)(NUM_1MHZ_CYCLES_PER_FRAME * hz / CLK_1MHZ);
+    set_clock_mode(cpu, CLOCK_CUSTOM);
+    return true;
+}
+
 void toggle_clock_mode(cpu_state *cpu) {
-    set_clock_mode(cpu, (clock_mode_t)((cpu->clock_mode + 1) % NUM_CLOCK_MODES));
+    clock_mode_t mode = (clock_mode_t)((cpu->clock_mode + 1) % NUM_CLOCK_MODES);
+    if (mode == CLOCK_CUSTOM && cpu->clock_mode_info[CLOCK_CUSTOM].hz_rate == 0) {
+        mode = (clock_mode_t)((mode + 1) % NUM_CLOCK_MODES);
+    }
+    set_clock_mode(cpu, mode);
     fprintf(stdout, "Clock mode: %d HZ_RATE: %llu\n", cpu->clock_mode, cpu->HZ_RATE);
 }
 
@@ -127,6 +153,7 @@ cpu_state::cpu_state() {
     cycles = 0;
     last_tick = 0;
     bus_cycles = 0;
+    memcpy(clock_mode_info, default_clock_mode_info, sizeof(clock_mode_info));
     
     trace = true;
     trace_buffer = new system_trace_buffer(100000);
@@ -150,10 +177,43 @@ void cpu_state::reset() {
     halt = 0; // if we were STPed etc.
     I = 1; // set interrupt flag.
     pc = read_word(RESET_VECTOR);
+    PROFILE(if (profiler) profiler->reset_stack();)
+}
+
+void cpu_state::save_state(SnapshotWriter &w) {
+    w.begin_chunk("CPU ", 1);
+    w.put(full_pc);
+    w.put(db);
+    w.put(sp);
+    w.put(a);
+    w.put(x);
+    w.put(y);
+    w.put(d);
+    w.put(p);
+    w.put(halt);
+    w.put(cycles);
+    w.put(bus_cycles);
+    w.put(irq_asserted);
+    w.put(ns_since_bus_cycle);
+    w.end_chunk();
+}
+
+bool cpu_state::restore_state(SnapshotReader &r) {
+    if (!r.find("CPU ")) return false;
+    bool ok = r.get(full_pc) && r.get(db) && r.get(sp) && r.get(a) && r.get(x) && r.get(y) && r.get(d) && r.get(p)
+        && r.get(halt) && r.get(cycles) && r.get(bus_cycles) && r.get(irq_asserted) && r.get(ns_since_bus_cycle);
+    PROFILE(if (profiler) profiler->reset_stack();)
+    return ok;
 }
 
 cpu_state::~cpu_state() {
     if (trace_buffer != nullptr) {
         delete trace_buffer;
     }
+    if (profiler != nullptr) {
+        delete profiler;
+    }
+    if (coverage != nullptr) {
+        delete coverage;
+    }
 }
\ No newline at end of file
@@ -29,11 +29,11 @@
 //#include "devices.hpp"
 #include "SlotData.hpp"
 #include "debugger/trace.hpp"
+#include "util/FrameMetrics.hpp"
 //#include "mmus/mmu_ii.hpp"
 #include "display/VideoScannerII.hpp"
 #include "Module_ID.hpp"
 
-#define MAX_CPUS 1
 #define MAX_NUM_BUS_CYCLE_ITEMS 4
 
 #define BRK_VECTOR 0xFFFE
@@ -69,6 +69,10 @@ struct addr_t {
 struct cpu_state;
 class Mounts;
 struct debug_window_t;
+class Profiler;
+class Coverage;
+class SnapshotWriter;
+class SnapshotReader;
 
 typedef int (*execute_next_fn)(cpu_state *cpu);
 
@@ -199,6 +203,7 @@ struct cpu_state {
     double cycle_duration_ns;
     uint64_t HZ_RATE;
     clock_mode_t clock_mode = CLOCK_FREE_RUN;
+    clock_mode_info_t clock_mode_info[NUM_CLOCK_MODES];
     float e_mhz = 0;
 
     double ns_since_bus_cycle = 0;
@@ -213,8 +218,14 @@ struct cpu_state {
     bool trace = false;
     system_trace_buffer *trace_buffer = nullptr;
     system_trace_entry_t trace_entry;
+    Profiler *profiler = nullptr;
+    Coverage *coverage = nullptr;
     execution_modes_t execution_mode = EXEC_NORMAL;
     uint64_t instructions_left = 0;
+    bool speculative = false; // run-ahead frames that will be rolled back: devices skip writes to disk, printer and audio
+    bool replaying = false;   // debugger re-executing history it has already shown: devices skip printer and audio
+    uint8_t loop_hint = 0;    // LOOP_HINT_*: the last instruction may be in a loop fast_forward_loop() can skip
+    frame_counters_t counters; // this frame's tallies for FrameMetrics; not saved in snapshots
 
     //void init();
     cpu_state();
@@ -222,6 +233,10 @@ struct cpu_state {
 
     void set_processor(int processor_type);
     void reset();
+
+    /* Registers and cycle counters. Clock mode is a host setting and is left alone. */
+    void save_state(SnapshotWriter &w);
+    bool restore_state(SnapshotReader &r);
     
     void set_mmu(MMU *mmu) { this->mmu = mmu; }
     void set_video_scanner(VideoScannerII *video_scanner) { this->video_scanner = video_scanner; }
@@ -286,11 +301,10 @@ struct cpu_state {
 #define FLAG_V        0b01000000 /* 0x40 */
 #define FLAG_N        0b10000000 /* 0x80 */
 
-extern struct cpu_state *CPUs[MAX_CPUS];
-
 void toggle_clock_mode(cpu_state *cpu);
 
 void set_clock_mode(cpu_state *cpu, clock_mode_t mode);
+bool set_custom_clock_rate(cpu_state *cpu, double hz);
 
 const char* processor_get_name(int processor_type);
 
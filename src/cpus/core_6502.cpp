@@ -35,8 +35,11 @@
  */
 
 #include "opcodes.hpp"
+#include "debugger/Profiler.hpp"
+#include "debugger/Coverage.hpp"
 
 #include "core_6502.hpp"
+#include "fast_forward.hpp"
 
 /**
  * References: 
@@ -55,8 +58,11 @@ namespace cpu_6502 {
 int execute_next(cpu_state *cpu) {
 
     system_trace_entry_t *tb = &cpu->trace_entry;
+    // breakpoint conditions read EADDR and DATA whether or not the trace is on.
+    tb->eaddr = 0;
+    tb->data = 0;
     TRACE(
-    if (cpu->trace) {
+    if (cpu->trace || cpu->coverage) {
     tb->cycle = cpu->cycles;
     tb->pc = cpu->pc;
     tb->a = cpu->a_lo;
@@ -67,9 +73,10 @@ int execute_next(cpu_state *cpu) {
     tb->p = cpu->p;
     tb->db = cpu->db;
     tb->pb = cpu->pb;
-    tb->eaddr = 0;
     }
     )
+    PROFILE(if (cpu->profiler) cpu->profiler->begin(cpu->pc, cpu->cycles);)
+    TRACE(if (cpu->coverage) cpu->coverage->begin(cpu->pc);)
 
 #if 0
     if (DEBUG(DEBUG_CLOCK)) {
@@ -89,6 +96,8 @@ int execute_next(cpu_state *cpu) {
         cpu->pc = cpu->read_word(IRQ_VECTOR);
         cpu->incr_cycles();
         cpu->incr_cycles();
+        cpu->counters.irqs++;
+        PROFILE(if (cpu->profiler) cpu->profiler->interrupt(cpu->pc, cpu->sp, cpu->cycles);)
         return 0;
     }
 
@@ -283,6 +292,8 @@ int execute_next(cpu_state *cpu) {
             {
                 byte_t N = get_operand_relative(cpu);
                 branch_if(cpu, N, cpu->Z == 0);
+                // taken back to the instruction before it: a countdown fast_forward_loop() may skip.
+                if (cpu->Z == 0 && (N == 0xFD || N == 0xFC)) cpu->loop_hint |= LOOP_HINT_COUNTDOWN;
             }
             break;
 
@@ -1250,6 +1261,8 @@ int execute_next(cpu_state *cpu) {
             break;
     }
 
+    PROFILE(if (cpu->profiler) cpu->profiler->end(opcode, cpu->pc, cpu->sp, cpu->cycles);)
+    TRACE(if (cpu->coverage) cpu->coverage->end(cpu->trace_entry);)
     TRACE(if (cpu->trace) cpu->trace_buffer->add_entry(cpu->trace_entry);)
 
     return 0;
@@ -0,0 +1,197 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "cpu.hpp"
+#include "opcodes.hpp"
+#include "mmus/mmu.hpp"
+#include "cpus/fast_forward.hpp"
+
+// 17030 bus cycles == 1 video frame == 1/59.9227434 sec.
+#define FRAME_BUS_CYCLES 17030
+
+/**
+ * Code is read without bus side effects; anything that isn't plain memory
+ * reads as floating bus and won't match.
+ */
+static inline uint8_t peek(cpu_state *cpu, uint16_t address) {
+    return cpu->mmu->read_raw(address);
+}
+
+/**
+ * Cycles for the branch at pc, as core_6502 counts them: 2, plus 1 if
+ * taken, plus 1 more if the target is on another page.
+ */
+static inline int branch_cycles(uint16_t pc, uint8_t offset, bool taken) {
+    if (!taken) return 2;
+    uint16_t next = pc + 2;
+    uint16_t target = next + (int8_t)offset;
+    return ((next & 0xFF00) != (target & 0xFF00)) ? 4 : 3;
+}
+
+/**
+ * BIT, LDA, LDX or LDY absolute of the keyboard: 4 cycles, and when no key
+ * is waiting, N clear and every other flag and register the same each time.
+ */
+static inline bool is_keyboard_poll(cpu_state *cpu, uint16_t address) {
+    uint8_t opcode = peek(cpu, address);
+    if (opcode != OP_BIT_ABS && opcode != OP_LDA_ABS && opcode != OP_LDX_ABS && opcode != OP_LDY_ABS) return false;
+    uint16_t operand = peek(cpu, address + 1) | (peek(cpu, address + 2) << 8);
+    return (operand & 0xFFF0) == 0xC000;
+}
+
+/**
+ * How many CPU cycles can go by before the end of the frame or the next
+ * event, less one: the interpreter has to be the one to get there. Bus cycles
+ * never run ahead of CPU cycles, so the frame limit is safe at any clock.
+ */
+static inline uint64_t cycles_to_deadline(cpu_state *cpu, uint64_t next_event) {
+    uint64_t room = (cpu->bus_cycles < FRAME_BUS_CYCLES) ? FRAME_BUS_CYCLES - 1 - cpu->bus_cycles : 0;
+    uint64_t to_event = (next_event > cpu->cycles) ? next_event - 1 - cpu->cycles : 0;
+    return (to_event < room) ? to_event : room;
+}
+
+static inline void skip_cycles(cpu_state *cpu, uint64_t cycles) {
+    for (uint64_t i = 0; i < cycles; i++) {
+        cpu->incr_cycles();
+    }
+}
+
+/**
+ * A keyboard poll loop, entered just after the poll with no key waiting:
+ * we're on the branch back.
+ */
+static void skip_poll_loop(cpu_state *cpu, uint64_t next_event) {
+    uint16_t pc = cpu->pc;
+    if (peek(cpu, pc) != OP_BPL_REL) return;
+    uint8_t offset = peek(cpu, pc + 1);
+    uint16_t top = pc + 2 + (int8_t)offset;
+    int branch = branch_cycles(pc, offset, true);
+    uint64_t room = cycles_to_deadline(cpu, next_event);
+
+    /*
+     * wait:   LDA KBD
+     *         BPL wait
+     */
+    if (top == (uint16_t)(pc - 3) && is_keyboard_poll(cpu, top)) {
+        uint64_t iteration = branch + 4;
+        uint64_t skipped = (room / iteration) * iteration;
+        skip_cycles(cpu, skipped);
+        return;
+    }
+
+    /*
+     * The monitor's KEYIN ($FD1B), which stirs the random seed while it waits:
+     *
+     * KEYIN:  INC RNDL
+     *         BNE KEYIN2
+     *         INC RNDH
+     * KEYIN2: BIT KBD
+     *         BPL KEYIN
+     *
+     * BIT sets N, V and Z itself, so only RNDL/RNDH change.
+     */
+    if (top == (uint16_t)(pc - 9) && peek(cpu, top) == OP_INC_ZP
+        && peek(cpu, top + 2) == OP_BNE_REL && peek(cpu, top + 3) == 0x02
+        && peek(cpu, top + 4) == OP_INC_ZP && peek(cpu, top + 5) == (uint8_t)(peek(cpu, top + 1) + 1)
+        && is_keyboard_poll(cpu, top + 6)) {
+        uint8_t rnd_lo = peek(cpu, top + 1);
+        uint8_t rnd_hi = rnd_lo + 1;
+        uint8_t lo = cpu->mmu->read(rnd_lo);
+        uint8_t hi = cpu->mmu->read(rnd_hi);
+        uint64_t no_carry = branch + 5 + branch_cycles(top + 2, 0x02, true) + 4;
+        uint64_t carry = branch + 5 + 2 + 5 + 4;
+
+        uint64_t skipped = 0;
+        while (true) {
+            uint64_t iteration = (lo == 0xFF) ? carry : no_carry;
+            if (skipped + iteration > room) break;
+            skipped += iteration;
+            if (++lo == 0) hi++;
+        }
+        if (skipped) {
+            skip_cycles(cpu, skipped);
+            cpu->mmu->write(rnd_lo, lo);
+            cpu->mmu->write(rnd_hi, hi);
+        }
+    }
+}
+
+/**
+ * A register countdown, entered just after its BNE was taken: we're on the
+ * decrement at the top. All but the last iteration, which falls through,
+ * go in one step; what they leave behind is the count, and the flags from
+ * the last decrement.
+ *
+ *         DEX / DEY          2 cycles
+ *         BNE *-1
+ *
+ *         SBC #1             2 cycles, binary mode with carry set only: A
+ *         BNE *-2            is then just A-1 and carry stays set (the
+ *                            monitor's WAIT at $FCA8 is two of these)
+ */
+static void skip_countdown_loop(cpu_state *cpu, uint64_t next_event) {
+    uint16_t pc = cpu->pc;
+    uint8_t opcode = peek(cpu, pc);
+    uint8_t *count;
+    uint16_t branch_pc;
+
+    if ((opcode == OP_DEX_IMP || opcode == OP_DEY_IMP) && peek(cpu, pc + 1) == OP_BNE_REL && peek(cpu, pc + 2) == 0xFD) {
+        count = (opcode == OP_DEX_IMP) ? &cpu->x_lo : &cpu->y_lo;
+        branch_pc = pc + 1;
+    } else if (opcode == OP_SBC_IMM && peek(cpu, pc + 1) == 0x01 && peek(cpu, pc + 2) == OP_BNE_REL && peek(cpu, pc + 3) == 0xFC
+        && cpu->C && !cpu->D) {
+        count = &cpu->a_lo;
+        branch_pc = pc + 2;
+    } else {
+        return;
+    }
+    if (*count < 2) return; // the next iteration is the last
+
+    uint64_t iteration = 2 + branch_cycles(branch_pc, peek(cpu, branch_pc + 1), true);
+    uint64_t iterations = cycles_to_deadline(cpu, next_event) / iteration;
+    if (iterations > (uint64_t)(*count - 1)) iterations = *count - 1;
+    if (iterations == 0) return;
+
+    skip_cycles(cpu, iterations * iteration);
+    uint8_t before = *count - (uint8_t)(iterations - 1);
+    *count -= (uint8_t)iterations;
+    cpu->Z = 0;
+    cpu->N = (*count & 0x80) != 0;
+    if (count == &cpu->a_lo) {
+        cpu->V = (before == 0x80); // $80 - 1 overflows
+    }
+}
+
+void fast_forward_loop(cpu_state *cpu, uint64_t next_event) {
+    uint8_t hint = cpu->loop_hint;
+    cpu->loop_hint = 0;
+
+    /*
+     * A pending IRQ is taken at the next instruction; profile, coverage and a
+     * trace streamed to file want to see every one. The in-memory trace (on
+     * by default) just doesn't get the skipped iterations, which are all
+     * alike anyway.
+     */
+    if ((!cpu->I && cpu->irq_asserted) || cpu->profiler || cpu->coverage) return;
+    if (cpu->trace && cpu->trace_buffer && cpu->trace_buffer->is_streaming()) return;
+
+    if (hint & LOOP_HINT_POLL) {
+        skip_poll_loop(cpu, next_event);
+    } else if (hint & LOOP_HINT_COUNTDOWN) {
+        skip_countdown_loop(cpu, next_event);
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "cpu.hpp"
+
+/**
+ * Skipping guest loops without interpreting them.
+ *
+ * Instructions that may be part of a loop we know set a hint in
+ * cpu->loop_hint, and the frame loop calls fast_forward_loop() right after
+ * them. It checks the code at PC, and if it is one of these loops, works out
+ * in closed form what the iterations do and clocks the bus (and so the video
+ * scanner) through their cycles, as the interpreter would have:
+ *
+ * LOOP_HINT_POLL: the keyboard was read with no key waiting. What it returns
+ * can't change until input arrives, and input only arrives between frames,
+ * so every iteration of a poll loop from here to the end of the frame is the
+ * same. The frame then finishes early and the host sleeps until it's due,
+ * as it would after any frame.
+ *
+ * LOOP_HINT_COUNTDOWN: a BNE was taken back to the instruction before it,
+ * as in DEX/BNE, DEY/BNE and SBC #1/BNE delay loops.
+ *
+ * Skipping stops short of the end of the frame and of next_event, so the
+ * interpreter gets to both at the same instruction and cycle it would have
+ * anyway. Nothing is skipped with an IRQ pending, with profile or coverage
+ * on, or while the trace is streaming to a file; the in-memory trace just
+ * misses the skipped iterations. The guest can't tell.
+ */
+
+#define LOOP_HINT_POLL      0x01
+#define LOOP_HINT_COUNTDOWN 0x02
+
+void fast_forward_loop(cpu_state *cpu, uint64_t next_event);
@@ -0,0 +1,389 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+#include "debugger/Breakpoints.hpp"
+#include "mmus/mmu.hpp"
+
+/**
+ * Recursive descent over the condition text, emitting postfix code.
+ * Bitwise operators bind tighter than comparisons, so "[$C000]&$80==$80"
+ * means what it looks like.
+ *
+ *   or   := and ( "||" and )*
+ *   and  := cmp ( "&&" cmp )*
+ *   cmp  := bor ( ("=="|"!="|"<"|"<="|">"|">=") bor )?
+ *   bor  := bxor ( "|" bxor )*
+ *   bxor := band ( "^" band )*
+ *   band := sum ( "&" sum )*
+ *   sum  := unary ( ("+"|"-") unary )*
+ *   unary:= ("!"|"-") unary | primary
+ */
+class ConditionParser {
+public:
+    ConditionParser(const std::string &text, std::vector<bp_insn_t> &code) : s(text), code(code) {}
+
+    bool parse(std::string &error) {
+        if (!parse_or()) {
+            error = err;
+            return false;
+        }
+        skip_ws();
+        if (pos < s.size()) {
+            error = "unexpected '" + s.substr(pos) + "'";
+            return false;
+        }
+        return true;
+    }
+
+protected:
+    const std::string &s;
+    std::vector<bp_insn_t> &code;
+    size_t pos = 0;
+    int depth = 0;
+    std::string err;
+
+    void skip_ws() {
+        while (pos < s.size() && isspace((unsigned char)s[pos])) pos++;
+    }
+
+    bool accept(const char *tok) {
+        skip_ws();
+        size_t n = strlen(tok);
+        if (s.compare(pos, n, tok) != 0) return false;
+        // don't take "<" out of "<=", "&" out of "&&", "|" out of "||", "!" out of "!="
+        if (n == 1 && pos + 1 < s.size()) {
+            char c = s[pos + 1];
+            if ((tok[0] == '<' || tok[0] == '>' || tok[0] == '!') && c == '=') return false;
+            if ((tok[0] == '&' || tok[0] == '|') && c == tok[0]) return false;
+        }
+        pos += n;
+        return true;
+    }
+
+    bool fail(const std::string &msg) {
+        if (err.empty()) err = msg;
+        return false;
+    }
+
+    bool emit(bp_opcode_t op, uint32_t imm = 0) {
+        // binary ops pop two and push one; loads push one; unary ops and peeks are stack-neutral.
+        switch (op) {
+            case BP_OP_NOT: case BP_OP_NEG: case BP_OP_PEEK: case BP_OP_PEEKW:
+                break;
+            case BP_OP_CONST: case BP_OP_A: case BP_OP_X: case BP_OP_Y: case BP_OP_SP: case BP_OP_P:
+            case BP_OP_PC: case BP_OP_FLAG: case BP_OP_CYCLES: case BP_OP_EADDR: case BP_OP_DATA:
+                if (++depth > BP_STACK_DEPTH) return fail("expression too complex");
+                break;
+            default:
+                depth--;
+                break;
+        }
+        code.push_back({op, imm});
+        return true;
+    }
+
+    bool parse_or() {
+        if (!parse_and()) return false;
+        while (accept("||")) {
+            if (!parse_and() || !emit(BP_OP_LOR)) return false;
+        }
+        return true;
+    }
+
+    bool parse_and() {
+        if (!parse_cmp()) return false;
+        while (accept("&&")) {
+            if (!parse_cmp() || !emit(BP_OP_LAND)) return false;
+        }
+        return true;
+    }
+
+    bool parse_cmp() {
+        if (!parse_bor()) return false;
+        static const struct { const char *tok; bp_opcode_t op; } ops[] = {
+            { "==", BP_OP_EQ }, { "!=", BP_OP_NE }, { "<=", BP_OP_LE },
+            { ">=", BP_OP_GE }, { "<", BP_OP_LT }, { ">", BP_OP_GT },
+        };
+        for (auto &o : ops) {
+            if (accept(o.tok)) {
+                return parse_bor() && emit(o.op);
+            }
+        }
+        return true;
+    }
+
+    bool parse_bor() {
+        if (!parse_bxor()) return false;
+        while (accept("|")) {
+            if (!parse_bxor() || !emit(BP_OP_BOR)) return false;
+        }
+        return true;
+    }
+
+    bool parse_bxor() {
+        if (!parse_band()) return false;
+        while (accept("^")) {
+            if (!parse_band() || !emit(BP_OP_BXOR)) return false;
+        }
+        return true;
+    }
+
+    bool parse_band() {
+        if (!parse_sum()) return false;
+        while (accept("&")) {
+            if (!parse_sum() || !emit(BP_OP_BAND)) return false;
+        }
+        return true;
+    }
+
+    bool parse_sum() {
+        if (!parse_unary()) return false;
+        while (true) {
+            if (accept("+")) {
+                if (!parse_unary() || !emit(BP_OP_ADD)) return false;
+            } else if (accept("-")) {
+                if (!parse_unary() || !emit(BP_OP_SUB)) return false;
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool parse_unary() {
+        if (accept("!")) return parse_unary() && emit(BP_OP_NOT);
+        if (accept("-")) return parse_unary() && emit(BP_OP_NEG);
+        return parse_primary();
+    }
+
+    bool parse_primary() {
+        skip_ws();
+        if (pos >= s.size()) return fail("unexpected end of condition");
+
+        if (accept("(")) {
+            if (!parse_or()) return false;
+            return accept(")") ? true : fail("expected ')'");
+        }
+        if (accept("[")) {
+            if (!parse_or()) return false;
+            if (!accept("]")) return fail("expected ']'");
+            return emit(BP_OP_PEEK);
+        }
+        if (accept("{")) {
+            if (!parse_or()) return false;
+            if (!accept("}")) return fail("expected '}'");
+            return emit(BP_OP_PEEKW);
+        }
+
+        char c = s[pos];
+        if (c == '$' || isdigit((unsigned char)c)) {
+            bool hex = (c == '$');
+            if (hex) pos++;
+            size_t start = pos;
+            while (pos < s.size() && (hex ? isxdigit((unsigned char)s[pos]) : isdigit((unsigned char)s[pos]))) pos++;
+            if (pos == start) return fail("bad number");
+            unsigned long v = strtoul(s.substr(start, pos - start).c_str(), nullptr, hex ? 16 : 10);
+            return emit(BP_OP_CONST, (uint32_t)v);
+        }
+
+        if (isalpha((unsigned char)c)) {
+            size_t start = pos;
+            while (pos < s.size() && isalnum((unsigned char)s[pos])) pos++;
+            std::string name = s.substr(start, pos - start);
+
+            static const struct { const char *name; bp_opcode_t op; uint32_t imm; } names[] = {
+                { "A", BP_OP_A, 0 }, { "X", BP_OP_X, 0 }, { "Y", BP_OP_Y, 0 },
+                { "SP", BP_OP_SP, 0 }, { "S", BP_OP_SP, 0 }, { "P", BP_OP_P, 0 }, { "PC", BP_OP_PC, 0 },
+                { "N", BP_OP_FLAG, FLAG_N }, { "V", BP_OP_FLAG, FLAG_V }, { "D", BP_OP_FLAG, FLAG_D },
+                { "I", BP_OP_FLAG, FLAG_I }, { "Z", BP_OP_FLAG, FLAG_Z }, { "C", BP_OP_FLAG, FLAG_C },
+                { "CYCLES", BP_OP_CYCLES, 0 }, { "EADDR", BP_OP_EADDR, 0 }, { "DATA", BP_OP_DATA, 0 },
+            };
+            for (auto &n : names) {
+                if (strcasecmp(n.name, name.c_str()) == 0) return emit(n.op, n.imm);
+            }
+            return fail("unknown name '" + name + "'");
+        }
+        return fail(std::string("unexpected '") + c + "'");
+    }
+};
+
+bool BreakCondition::compile(const std::string &text, std::string &error) {
+    code.clear();
+    ConditionParser parser(text, code);
+    if (!parser.parse(error)) {
+        code.clear();
+        return false;
+    }
+    return true;
+}
+
+bool BreakCondition::evaluate(cpu_state *cpu, const system_trace_entry_t *last) const {
+    int64_t stack[BP_STACK_DEPTH];
+    int sp = -1;
+
+    for (const bp_insn_t &insn : code) {
+        switch (insn.op) {
+            case BP_OP_CONST:  stack[++sp] = insn.imm; break;
+            case BP_OP_A:      stack[++sp] = cpu->a_lo; break;
+            case BP_OP_X:      stack[++sp] = cpu->x_lo; break;
+            case BP_OP_Y:      stack[++sp] = cpu->y_lo; break;
+            case BP_OP_SP:     stack[++sp] = cpu->sp & 0xFF; break;
+            case BP_OP_P:      stack[++sp] = cpu->p; break;
+            case BP_OP_PC:     stack[++sp] = cpu->pc; break;
+            case BP_OP_FLAG:   stack[++sp] = (cpu->p & insn.imm) != 0; break;
+            case BP_OP_CYCLES: stack[++sp] = (int64_t)cpu->cycles; break;
+            case BP_OP_EADDR:  stack[++sp] = last ? (last->eaddr & 0xFFFF) : 0; break;
+            case BP_OP_DATA:   stack[++sp] = last ? (last->data & 0xFF) : 0; break;
+            case BP_OP_PEEK:
+                stack[sp] = cpu->mmu->read_raw(stack[sp] & 0xFFFF);
+                break;
+            case BP_OP_PEEKW: {
+                uint16_t a = stack[sp] & 0xFFFF;
+                stack[sp] = cpu->mmu->read_raw(a) | (cpu->mmu->read_raw((uint16_t)(a + 1)) << 8);
+                break;
+            }
+            case BP_OP_NOT:    stack[sp] = !stack[sp]; break;
+            case BP_OP_NEG:    stack[sp] = -stack[sp]; break;
+            case BP_OP_ADD:    sp--; stack[sp] = stack[sp] + stack[sp + 1]; break;
+            case BP_OP_SUB:    sp--; stack[sp] = stack[sp] - stack[sp + 1]; break;
+            case BP_OP_BAND:   sp--; stack[sp] = stack[sp] & stack[sp + 1]; break;
+            case BP_OP_BOR:    sp--; stack[sp] = stack[sp] | stack[sp + 1]; break;
+            case BP_OP_BXOR:   sp--; stack[sp] = stack[sp] ^ stack[sp + 1]; break;
+            case BP_OP_EQ:     sp--; stack[sp] = stack[sp] == stack[sp + 1]; break;
+            case BP_OP_NE:     sp--; stack[sp] = stack[sp] != stack[sp + 1]; break;
+            case BP_OP_LT:     sp--; stack[sp] = stack[sp] < stack[sp + 1]; break;
+            case BP_OP_LE:     sp--; stack[sp] = stack[sp] <= stack[sp + 1]; break;
+            case BP_OP_GT:     sp--; stack[sp] = stack[sp] > stack[sp + 1]; break;
+            case BP_OP_GE:     sp--; stack[sp] = stack[sp] >= stack[sp + 1]; break;
+            case BP_OP_LAND:   sp--; stack[sp] = stack[sp] && stack[sp + 1]; break;
+            case BP_OP_LOR:    sp--; stack[sp] = stack[sp] || stack[sp + 1]; break;
+        }
+    }
+    return sp < 0 || stack[0] != 0;
+}
+
+Breakpoints::Breakpoints() {
+    memset(armed, 0, sizeof(armed));
+}
+
+int Breakpoints::add(bp_kind_t kind, uint16_t lo, uint16_t hi, const std::string &condition, std::string &error) {
+    breakpoint_t bp;
+    bp.kind = kind;
+    bp.lo = lo;
+    bp.hi = hi;
+    bp.condition_text = condition;
+    if (!condition.empty() && !bp.condition.compile(condition, error)) {
+        return -1;
+    }
+    bp.id = next_id++;
+    list.push_back(bp);
+    rebuild();
+    return bp.id;
+}
+
+int Breakpoints::add(bp_kind_t kind, const std::string &spec, std::string &error) {
+    size_t start = spec.find_first_not_of(" \t");
+    if (start == std::string::npos) {
+        error = "missing address";
+        return -1;
+    }
+    size_t end = spec.find_first_of(" \t", start);
+    std::string where = spec.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+    if (where[0] == '$') where = where.substr(1);
+    size_t dot = where.find('.');
+    std::string slo = where.substr(0, dot);
+    std::string shi = (dot == std::string::npos) ? slo : where.substr(dot + 1);
+    char *end_lo, *end_hi;
+    unsigned long lo = strtoul(slo.c_str(), &end_lo, 16);
+    unsigned long hi = strtoul(shi.c_str(), &end_hi, 16);
+    if (slo.empty() || shi.empty() || *end_lo || *end_hi || lo > 0xFFFF || hi > 0xFFFF || lo > hi) {
+        error = "bad address: " + where;
+        return -1;
+    }
+
+    std::string condition;
+    size_t rest = (end == std::string::npos) ? std::string::npos : spec.find_first_not_of(" \t", end);
+    if (rest != std::string::npos) {
+        if (spec.compare(rest, 2, "if") != 0 || (rest + 2 < spec.size() && !isspace((unsigned char)spec[rest + 2]))) {
+            error = "expected 'if' before condition";
+            return -1;
+        }
+        size_t cond = spec.find_first_not_of(" \t", rest + 2);
+        if (cond == std::string::npos) {
+            error = "missing condition after 'if'";
+            return -1;
+        }
+        condition = spec.substr(cond, spec.find_last_not_of(" \t") + 1 - cond);
+    }
+    return add(kind, (uint16_t)lo, (uint16_t)hi, condition, error);
+}
+
+bool Breakpoints::remove(int id) {
+    for (auto it = list.begin(); it != list.end(); ++it) {
+        if (it->id == id) {
+            list.erase(it);
+            rebuild();
+            return true;
+        }
+    }
+    return false;
+}
+
+void Breakpoints::clear() {
+    list.clear();
+    rebuild();
+}
+
+void Breakpoints::reset_hits() {
+    for (breakpoint_t &bp : list) bp.hits = 0;
+}
+
+std::vector<uint64_t> Breakpoints::save_hits() const {
+    std::vector<uint64_t> hits;
+    for (const breakpoint_t &bp : list) hits.push_back(bp.hits);
+    return hits;
+}
+
+void Breakpoints::restore_hits(const std::vector<uint64_t> &hits) {
+    for (size_t i = 0; i < list.size() && i < hits.size(); i++) list[i].hits = hits[i];
+}
+
+void Breakpoints::rebuild() {
+    memset(armed, 0, sizeof(armed));
+    for (const breakpoint_t &bp : list) {
+        for (uint32_t a = bp.lo; a <= bp.hi; a++) {
+            armed[a >> 3] |= 1 << (a & 7);
+        }
+    }
+}
+
+bool Breakpoints::check_slow(cpu_state *cpu, const system_trace_entry_t *last) {
+    uint16_t pc = cpu->pc;
+    bool stop = false;
+    for (breakpoint_t &bp : list) {
+        if (pc < bp.lo || pc > bp.hi) continue;
+        if (!bp.condition.empty() && !bp.condition.evaluate(cpu, last)) continue;
+        bp.hits++;
+        if (bp.kind == BP_KIND_BREAK) stop = true;
+    }
+    return stop;
+}
@@ -0,0 +1,150 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cpu.hpp"
+#include "debugger/trace.hpp"
+
+enum bp_opcode_t : uint8_t {
+    BP_OP_CONST,    // push imm
+    BP_OP_A,
+    BP_OP_X,
+    BP_OP_Y,
+    BP_OP_SP,
+    BP_OP_P,
+    BP_OP_PC,
+    BP_OP_FLAG,     // push (P & imm) != 0
+    BP_OP_CYCLES,
+    BP_OP_EADDR,    // effective address of the instruction that just ran
+    BP_OP_DATA,     // data byte of the instruction that just ran
+    BP_OP_PEEK,     // pop addr, push byte at addr
+    BP_OP_PEEKW,    // pop addr, push little-endian word at addr
+    BP_OP_NOT,
+    BP_OP_NEG,
+    BP_OP_ADD,
+    BP_OP_SUB,
+    BP_OP_BAND,
+    BP_OP_BOR,
+    BP_OP_BXOR,
+    BP_OP_EQ,
+    BP_OP_NE,
+    BP_OP_LT,
+    BP_OP_LE,
+    BP_OP_GT,
+    BP_OP_GE,
+    BP_OP_LAND,
+    BP_OP_LOR,
+};
+
+struct bp_insn_t {
+    bp_opcode_t op;
+    uint32_t imm;
+};
+
+// deepest expression stack a compiled condition may need.
+#define BP_STACK_DEPTH 16
+
+/**
+ * A breakpoint condition, compiled once into a short stack program.
+ *
+ *   A X Y SP P PC           registers
+ *   N V D I Z C             flags (0 or 1)
+ *   CYCLES EADDR DATA       cycle counter; eaddr/data of the last instruction
+ *   [expr] {expr}           byte / little-endian word at address (no I/O side effects)
+ *   $FF 255                 hex with $, otherwise decimal
+ *   ( ) ! - + & | ^ == != < <= > >= && ||
+ */
+class BreakCondition {
+public:
+    bool compile(const std::string &text, std::string &error);
+    bool empty() const { return code.empty(); }
+    bool evaluate(cpu_state *cpu, const system_trace_entry_t *last) const;
+
+protected:
+    std::vector<bp_insn_t> code;
+};
+
+enum bp_kind_t {
+    BP_KIND_BREAK,      // stop execution
+    BP_KIND_COUNT,      // count hits and keep running
+};
+
+struct breakpoint_t {
+    int id;
+    bp_kind_t kind;
+    uint16_t lo;
+    uint16_t hi;
+    std::string condition_text;
+    BreakCondition condition;
+    uint64_t hits = 0;
+};
+
+/**
+ * Conditional breakpoints and counting tracepoints, keyed by the address
+ * of the next instruction to execute. A bitmap of armed addresses keeps
+ * the per-instruction cost to one load and test when nothing matches.
+ */
+class Breakpoints {
+public:
+    Breakpoints();
+
+    /**
+     * Returns the new breakpoint's id, or -1 with error set.
+     */
+    int add(bp_kind_t kind, uint16_t lo, uint16_t hi, const std::string &condition, std::string &error);
+
+    /**
+     * Same, from "addr[.hi] [if cond]" as typed in the monitor or on the command line.
+     */
+    int add(bp_kind_t kind, const std::string &spec, std::string &error);
+
+    bool remove(int id);
+    void clear();
+    void reset_hits();
+
+    /**
+     * Tracepoint counts, so instructions the debugger re-executes aren't counted twice.
+     */
+    std::vector<uint64_t> save_hits() const;
+    void restore_hits(const std::vector<uint64_t> &hits);
+
+    /**
+     * Called after each instruction with the trace entry it filled in.
+     * Returns true if a stopping breakpoint fired at the new PC.
+     */
+    inline bool check(cpu_state *cpu, const system_trace_entry_t *last) {
+        uint16_t pc = cpu->pc;
+        if (!(armed[pc >> 3] & (1 << (pc & 7)))) return false;
+        return check_slow(cpu, last);
+    }
+
+    const std::vector<breakpoint_t> &get_list() const { return list; }
+    size_t size() const { return list.size(); }
+
+protected:
+    std::vector<breakpoint_t> list;
+    uint8_t armed[65536 / 8];
+    int next_id = 1;
+
+    bool check_slow(cpu_state *cpu, const system_trace_entry_t *last);
+    void rebuild();
+};
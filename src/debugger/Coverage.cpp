@@ -0,0 +1,205 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "debugger/Coverage.hpp"
+#include "debugger/TraceQuery.hpp"
+#include "debugger/trace_opcodes.hpp"
+
+#define COVERAGE_MAGIC "GS2C"
+#define COVERAGE_VERSION 1
+
+struct coverage_file_header_t {
+    char magic[4];
+    uint32_t version;
+    uint32_t page_count;
+    uint32_t reserved;
+};
+
+struct coverage_file_page_t {
+    char bank[23];          // NUL-padded
+    uint8_t cpu_page;
+    uint8_t flags[256];
+};
+
+Coverage::Coverage(MMU *mmu) : mmu(mmu) {
+    for (int op = 0; op < 256; op++) {
+        op_size[op] = address_mode_formats[disasm_table[op].mode].size;
+        op_access[op] = trace_opcode_access((uint8_t)op);
+    }
+}
+
+Coverage::~Coverage() {
+    for (auto &p : pages) delete p.second;
+}
+
+void Coverage::end(const system_trace_entry_t &entry) {
+    uint16_t pc = entry.pc;
+    uint8_t size = op_size[entry.opcode];
+
+    if (exec_page) {
+        exec_page->flags[pc & 0xFF] |= COV_EXEC;
+        for (int i = 1; i < size; i++) {
+            uint16_t a = pc + i;
+            if ((a >> 8) == (pc >> 8)) exec_page->flags[a & 0xFF] |= COV_OPERAND;
+            else mark(a, COV_OPERAND);
+        }
+    }
+
+    uint8_t acc = op_access[entry.opcode];
+    if (acc & TRACE_ACCESS_READ) mark(entry.eaddr, COV_READ);
+    if (acc & TRACE_ACCESS_WRITE) mark(entry.eaddr, COV_WRITE);
+}
+
+Coverage::cov_page_t *Coverage::find_or_add(const std::string &bank, uint8_t cpu_page) {
+    cov_page_t *&cov = pages[{bank, cpu_page}];
+    if (cov == nullptr) {
+        cov = new cov_page_t;
+        cov->bank = bank;
+        cov->cpu_page = cpu_page;
+    }
+    return cov;
+}
+
+Coverage::cov_page_t *Coverage::resolve(const uint8_t *host, const char *tag, uint8_t cpu_page) {
+    auto it = by_host.find(host);
+    if (it != by_host.end()) return it->second;
+
+    // II/II+ and IIe name main memory differently; keep one name so files merge.
+    std::string bank = tag ? tag : "?";
+    if (bank == "MAIN_RAM") bank = "MAIN";
+    if (bank.size() > sizeof(coverage_file_page_t::bank)) bank.resize(sizeof(coverage_file_page_t::bank));
+
+    cov_page_t *cov = find_or_add(bank, cpu_page);
+    cov->host = host;
+    by_host[host] = cov;
+    return cov;
+}
+
+bool Coverage::load(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) return true;
+
+    coverage_file_header_t hdr;
+    if (!file.read((char *)&hdr, sizeof(hdr)) || memcmp(hdr.magic, COVERAGE_MAGIC, 4) != 0 || hdr.version != COVERAGE_VERSION) {
+        printf("Not a coverage file: %s\n", filename.c_str());
+        return false;
+    }
+    coverage_file_page_t fp;
+    for (uint32_t i = 0; i < hdr.page_count; i++) {
+        if (!file.read((char *)&fp, sizeof(fp))) {
+            printf("Coverage file %s is truncated\n", filename.c_str());
+            return false;
+        }
+        cov_page_t *cov = find_or_add(std::string(fp.bank, strnlen(fp.bank, sizeof(fp.bank))), fp.cpu_page);
+        for (int b = 0; b < 256; b++) cov->flags[b] |= fp.flags[b];
+    }
+    return true;
+}
+
+bool Coverage::save(const std::string &filename) {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        printf("Failed to open coverage file: %s\n", filename.c_str());
+        return false;
+    }
+    coverage_file_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, COVERAGE_MAGIC, 4);
+    hdr.version = COVERAGE_VERSION;
+    hdr.page_count = (uint32_t)pages.size();
+    file.write((const char *)&hdr, sizeof(hdr));
+
+    for (auto &p : pages) {
+        coverage_file_page_t fp;
+        memset(&fp, 0, sizeof(fp));
+        memcpy(fp.bank, p.second->bank.data(), p.second->bank.size());
+        fp.cpu_page = p.second->cpu_page;
+        memcpy(fp.flags, p.second->flags, 256);
+        file.write((const char *)&fp, sizeof(fp));
+    }
+    return (bool)file;
+}
+
+static void flag_string(uint8_t flags, char *out) {
+    out[0] = (flags & COV_EXEC) ? 'X' : (flags & COV_OPERAND) ? 'x' : ' ';
+    out[1] = (flags & COV_READ) ? 'R' : ' ';
+    out[2] = (flags & COV_WRITE) ? 'W' : ' ';
+    out[3] = '\0';
+}
+
+bool Coverage::save_listing(const std::string &filename) {
+    FILE *f = fopen(filename.c_str(), "w");
+    if (!f) {
+        printf("Failed to open coverage listing file: %s\n", filename.c_str());
+        return false;
+    }
+
+    for (auto &p : pages) {
+        cov_page_t *cov = p.second;
+        int counts[4] = {0};
+        for (int b = 0; b < 256; b++) {
+            for (int k = 0; k < 4; k++) if (cov->flags[b] & (1 << k)) counts[k]++;
+        }
+        if (!counts[0] && !counts[1] && !counts[2] && !counts[3]) continue;
+
+        fprintf(f, "; %s $%02X00-$%02XFF  exec %d  operand %d  read %d  write %d\n",
+            cov->bank.c_str(), cov->cpu_page, cov->cpu_page, counts[0], counts[1], counts[2], counts[3]);
+        if (cov->host == nullptr) {
+            fprintf(f, ";   (not mapped this run)\n\n");
+            continue;
+        }
+
+        const uint8_t *mem = cov->host;
+        char fl[4];
+        int b = 0;
+        while (b < 256) {
+            uint16_t addr = (cov->cpu_page << 8) | b;
+            if (cov->flags[b] == 0) {
+                while (b < 256 && cov->flags[b] == 0) b++;
+                fprintf(f, "       %04X-%04X  untouched\n", addr, (cov->cpu_page << 8) | (b - 1));
+                continue;
+            }
+            flag_string(cov->flags[b], fl);
+
+            const disasm_entry *da = &disasm_table[mem[b]];
+            int size = op_size[mem[b]];
+            if ((cov->flags[b] & COV_EXEC) && b + size <= 256) {
+                uint32_t operand = (size > 1 ? mem[b + 1] : 0) | (size > 2 ? mem[b + 2] << 8 : 0);
+                char bytes[16], text[32];
+                snprintf(bytes, sizeof(bytes), size == 1 ? "%02X" : size == 2 ? "%02X %02X" : "%02X %02X %02X",
+                    mem[b], size > 1 ? mem[b + 1] : 0, size > 2 ? mem[b + 2] : 0);
+                if (da->mode == REL) {
+                    snprintf(text, sizeof(text), "$%04X", (uint16_t)(addr + 2 + (int8_t)operand));
+                } else {
+                    snprintf(text, sizeof(text), address_mode_formats[da->mode].format, operand);
+                }
+                fprintf(f, "  %s  %04X: %-9s  %s %s\n", fl, addr, bytes, da->opcode ? da->opcode : "???", text);
+                b += size;
+            } else {
+                fprintf(f, "  %s  %04X: %02X         .byte $%02X\n", fl, addr, mem[b], mem[b]);
+                b++;
+            }
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    return true;
+}
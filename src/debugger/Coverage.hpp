@@ -0,0 +1,123 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <map>
+#include <unordered_map>
+
+#include "mmus/mmu.hpp"
+#include "debugger/trace.hpp"
+
+#define COV_EXEC    0x01    // first byte of an executed instruction
+#define COV_OPERAND 0x02    // operand byte of an executed instruction
+#define COV_READ    0x04    // data read
+#define COV_WRITE   0x08    // data written
+
+/**
+ * Code and data coverage, tracked per physical bank.
+ *
+ * Coverage follows the host memory behind each page table entry, so main
+ * and aux RAM, both language card banks, ROM and each card's slot ROM are
+ * counted separately even though they share CPU addresses. Pages are named
+ * by the page table's read_d/write_d tag and CPU page (e.g. "LC_BANK2:D4",
+ * or "ALT_LC_BANK2:D4" for the IIe's aux copy; tags must differ per bank),
+ * which is stable from run to run, so coverage files can be merged.
+ *
+ * Fed from the TRACE hooks in the CPU core. Each access costs a page table
+ * lookup, a pointer compare and an OR.
+ */
+class Coverage {
+public:
+    Coverage(MMU *mmu);
+    ~Coverage();
+
+    /**
+     * Called before the instruction at pc is fetched, so instruction bytes
+     * are charged to the bank they were fetched from even if the
+     * instruction switches banks.
+     */
+    inline void begin(uint16_t pc) {
+        exec_page = read_page(pc >> 8);
+    }
+
+    /**
+     * Called after the instruction has executed, with the filled-in trace entry.
+     */
+    void end(const system_trace_entry_t &entry);
+
+    /**
+     * Merge a coverage file into the current counts. A missing file is not an error.
+     */
+    bool load(const std::string &filename);
+    bool save(const std::string &filename);
+
+    /**
+     * Disassembly of every page seen this run, each line flagged with how it was touched.
+     */
+    bool save_listing(const std::string &filename);
+
+protected:
+    struct cov_page_t {
+        std::string bank;
+        uint8_t cpu_page;
+        const uint8_t *host = nullptr;  // the bytes, if seen this run
+        uint8_t flags[256] = {0};
+    };
+    struct cache_t {
+        const uint8_t *host;
+        cov_page_t *cov;
+    };
+
+    MMU *mmu;
+    cov_page_t *exec_page = nullptr;
+    cache_t read_cache[256] = {};
+    cache_t write_cache[256] = {};
+    uint8_t op_size[256];
+    uint8_t op_access[256];
+
+    std::map<std::pair<std::string, uint8_t>, cov_page_t *> pages;
+    std::unordered_map<const uint8_t *, cov_page_t *> by_host;
+
+    inline cov_page_t *read_page(uint8_t page) {
+        const page_table_entry_t *pte = mmu->get_page_entry(page);
+        if (pte->read_p == nullptr) return nullptr; // I/O
+        if (pte->read_p != read_cache[page].host) {
+            read_cache[page] = {pte->read_p, resolve(pte->read_p, pte->read_d, page)};
+        }
+        return read_cache[page].cov;
+    }
+
+    inline cov_page_t *write_page(uint8_t page) {
+        const page_table_entry_t *pte = mmu->get_page_entry(page);
+        if (pte->write_p == nullptr) return nullptr;
+        if (pte->write_p != write_cache[page].host) {
+            write_cache[page] = {pte->write_p, resolve(pte->write_p, pte->write_d, page)};
+        }
+        return write_cache[page].cov;
+    }
+
+    inline void mark(uint16_t address, uint8_t flag) {
+        cov_page_t *cov = (flag & COV_WRITE) ? write_page(address >> 8) : read_page(address >> 8);
+        if (cov) cov->flags[address & 0xFF] |= flag;
+    }
+
+    cov_page_t *resolve(const uint8_t *host, const char *tag, uint8_t cpu_page);
+    cov_page_t *find_or_add(const std::string &bank, uint8_t cpu_page);
+};
@@ -4,14 +4,16 @@
 #include <sstream>
 #include <vector>
 #include <iomanip>
+#include <cstdlib>
 #include "debugger/MemoryWatch.hpp"
 
-ExecuteCommand::ExecuteCommand(MMU *mmu, MonitorCommand *cmd, MemoryWatch *watches, MemoryWatch *breaks, Disassembler *disasm) {
+ExecuteCommand::ExecuteCommand(MMU *mmu, MonitorCommand *cmd, MemoryWatch *watches, MemoryWatch *breaks, Disassembler *disasm, Breakpoints *cond_breaks) {
     this->mmu = mmu;
     this->cmd = cmd;
     this->memory_watches = watches;
     this->breaks = breaks;
     this->disasm = disasm;
+    this->cond_breaks = cond_breaks;
 }
 
 ExecuteCommand::~ExecuteCommand() {
@@ -164,6 +166,11 @@ void ExecuteCommand::execute() {
         }
         addOutput(disasm->disassemble(30));
     }
+    if (cond_breaks && (node0.type == MON_NODE_TYPE_COMMAND) &&
+        (node0.val_cmd == MON_CMD_BREAK || node0.val_cmd == MON_CMD_COUNT || node0.val_cmd == MON_CMD_NOBREAK)) {
+        execute_break(node0.val_cmd);
+        return;
+    }
     if ((node0.type == MON_NODE_TYPE_COMMAND) && (node0.val_cmd == MON_CMD_HELP)) {
         addOutput("watch range_lo:range_hi      - watch memory range");
         addOutput("watch                        - list watches");
@@ -171,6 +178,13 @@ void ExecuteCommand::execute() {
         addOutput("bp range_lo:range_hi         - set breakpoint");
         addOutput("bp                           - list breakpoints");
         addOutput("nobp address                 - remove breakpoint");
+        addOutput("break addr[.hi] [if cond]    - stop before addr when cond is true");
+        addOutput("count addr[.hi] [if cond]    - count hits at addr without stopping");
+        addOutput("break                        - list conditional breaks with hit counts");
+        addOutput("break reset                  - zero hit counts");
+        addOutput("nobreak id | all             - remove conditional break");
+        addOutput("  cond: A X Y SP P PC N V D I Z C CYCLES EADDR DATA [addr] {addr}");
+        addOutput("        $hex decimal ( ) ! - + & | ^ == != < <= > >= && ||");
         addOutput("set address value [value...] - set memory values");
         addOutput("address:value [value...]     - set memory values");
         addOutput("list (l) address             - disassemble instructions from address");
@@ -306,3 +320,55 @@ void ExecuteCommand::execute() {
         addFormattedOutput("Moved %d bytes from %04X to %04X", node1.val_range.hi - node1.val_range.lo + 1, node1.val_range.lo, node2.val_number);
     }
 }
+
+/**
+ * break / count / nobreak. Conditions aren't monitor tokens, so these work
+ * from the raw command text.
+ */
+void ExecuteCommand::execute_break(mon_cmd_type_t which) {
+    std::istringstream iss(cmd->command);
+    std::string keyword, where;
+    iss >> keyword >> where;
+
+    if (which == MON_CMD_NOBREAK) {
+        if (where == "all") {
+            cond_breaks->clear();
+            addOutput("All conditional breaks removed");
+        } else if (where.empty() || !cond_breaks->remove(atoi(where.c_str()))) {
+            addOutput("Usage: nobreak id | all");
+        }
+        return;
+    }
+
+    if (where.empty() || where == "reset") {
+        if (where == "reset") cond_breaks->reset_hits();
+        if (cond_breaks->size() == 0) {
+            addOutput("No conditional breaks");
+            return;
+        }
+        for (const breakpoint_t &bp : cond_breaks->get_list()) {
+            std::string cond = bp.condition_text.empty() ? "" : " if " + bp.condition_text;
+            if (bp.lo == bp.hi) {
+                addFormattedOutput("#%-3d %-5s %04X%s  hits %llu", bp.id, bp.kind == BP_KIND_BREAK ? "break" : "count",
+                    bp.lo, cond.c_str(), (unsigned long long)bp.hits);
+            } else {
+                addFormattedOutput("#%-3d %-5s %04X.%04X%s  hits %llu", bp.id, bp.kind == BP_KIND_BREAK ? "break" : "count",
+                    bp.lo, bp.hi, cond.c_str(), (unsigned long long)bp.hits);
+            }
+        }
+        return;
+    }
+
+    std::string error;
+    bp_kind_t kind = (which == MON_CMD_BREAK) ? BP_KIND_BREAK : BP_KIND_COUNT;
+    std::string spec;
+    std::getline(iss, spec);
+    int id = cond_breaks->add(kind, where + spec, error);
+    if (id < 0) {
+        addFormattedOutput("Error: %s", error.c_str());
+        return;
+    }
+    const breakpoint_t &bp = cond_breaks->get_list().back();
+    addFormattedOutput("#%d %s %04X.%04X%s%s", id, kind == BP_KIND_BREAK ? "break" : "count", bp.lo, bp.hi,
+        bp.condition_text.empty() ? "" : " if ", bp.condition_text.c_str());
+}
@@ -6,6 +6,7 @@
 #include <vector>
 #include "debugger/MemoryWatch.hpp"
 #include "debugger/disasm.hpp"
+#include "debugger/Breakpoints.hpp"
 
 class ExecuteCommand {
   private:
@@ -15,6 +16,7 @@ class ExecuteCommand {
     MemoryWatch *memory_watches = nullptr;
     MemoryWatch *breaks = nullptr;
     Disassembler *disasm = nullptr;
+    Breakpoints *cond_breaks = nullptr;
 
 
     void addOutput(const std::vector<std::string>& lines) {
@@ -35,9 +37,11 @@ class ExecuteCommand {
     }
 
     public:
-        ExecuteCommand(MMU *mmu, MonitorCommand *cmd, MemoryWatch *watches, MemoryWatch *breaks, Disassembler *disasm);
+        ExecuteCommand(MMU *mmu, MonitorCommand *cmd, MemoryWatch *watches, MemoryWatch *breaks, Disassembler *disasm, Breakpoints *cond_breaks = nullptr);
         ~ExecuteCommand();
         const std::vector<std::string>& getOutput() const;
         void clearOutput();
         void execute();
+    protected:
+        void execute_break(mon_cmd_type_t which);
 };
\ No newline at end of file
@@ -62,6 +62,9 @@ mon_cmd_type_t MonitorCommand::lookup_cmd(const std::string &cmd) {
     if (cmd == "list") return MON_CMD_LIST;
     if (cmd == "l") return MON_CMD_LIST;
     if (cmd == "map") return MON_CMD_MAP;
+    if (cmd == "break") return MON_CMD_BREAK;
+    if (cmd == "count") return MON_CMD_COUNT;
+    if (cmd == "nobreak") return MON_CMD_NOBREAK;
     return MON_CMD_UNKNOWN;
 }
 
@@ -30,6 +30,9 @@ enum mon_cmd_type_t {
     MON_CMD_NOBP,
     MON_CMD_LIST,
     MON_CMD_MAP,
+    MON_CMD_BREAK,
+    MON_CMD_COUNT,
+    MON_CMD_NOBREAK,
 };
 
 struct mon_node_entry_t {
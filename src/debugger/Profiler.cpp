@@ -0,0 +1,197 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+
+#include "debugger/Profiler.hpp"
+#include "debugger/disasm.hpp"
+#include "opcodes.hpp"
+
+Profiler::Profiler(MMU *mmu) : mmu(mmu) {
+    pc_cycles = new uint64_t[65536];
+    pc_count = new uint64_t[65536];
+    root = new node_t{0, false, nullptr};
+    clear();
+}
+
+Profiler::~Profiler() {
+    free_node(root);
+    delete[] pc_cycles;
+    delete[] pc_count;
+}
+
+void Profiler::free_node(node_t *node) {
+    for (auto &child : node->children) free_node(child.second);
+    delete node;
+}
+
+void Profiler::clear() {
+    memset(pc_cycles, 0, 65536 * sizeof(uint64_t));
+    memset(pc_count, 0, 65536 * sizeof(uint64_t));
+    for (auto &child : root->children) free_node(child.second);
+    root->children.clear();
+    root->self_cycles = 0;
+    reset_stack();
+}
+
+void Profiler::reset_stack() {
+    frames.clear();
+    current = root;
+}
+
+void Profiler::push(uint16_t addr, bool interrupt, uint8_t sp) {
+    if (frames.size() >= PROFILER_MAX_DEPTH) return;
+
+    uint32_t key = addr | (interrupt ? 0x10000 : 0);
+    node_t *&child = current->children[key];
+    if (child == nullptr) {
+        child = new node_t{addr, interrupt, current};
+    }
+    child->calls++;
+    frames.push_back({child, sp});
+    current = child;
+}
+
+void Profiler::unwind(uint8_t sp) {
+    // pop every frame whose return address is now above the stack pointer.
+    while (!frames.empty() && frames.back().sp < sp) {
+        frames.pop_back();
+    }
+    current = frames.empty() ? root : frames.back().node;
+}
+
+void Profiler::end(uint8_t opcode, uint16_t pc, uint8_t sp, uint64_t cycles) {
+    uint64_t spent = cycles - start_cycles;
+    pc_cycles[start_pc] += spent;
+    pc_count[start_pc]++;
+    current->self_cycles += spent;
+
+    switch (opcode) {
+        case OP_JSR_ABS:
+            push(pc, false, sp);
+            break;
+        case OP_BRK_IMP:
+            push(pc, true, sp);
+            break;
+        case OP_RTS_IMP:
+        case OP_RTI_IMP:
+            unwind(sp);
+            break;
+    }
+}
+
+void Profiler::interrupt(uint16_t pc, uint8_t sp, uint64_t cycles) {
+    push(pc, true, sp);
+    current->self_cycles += cycles - start_cycles;
+}
+
+std::string Profiler::node_name(const node_t *node) {
+    if (node == root) return "root";
+    char buf[16];
+    snprintf(buf, sizeof(buf), node->interrupt ? "IRQ_%04X" : "%04X", node->addr);
+    return buf;
+}
+
+bool Profiler::save_folded(const std::string &filename) {
+    FILE *f = fopen(filename.c_str(), "w");
+    if (!f) {
+        printf("Failed to open profile output file: %s\n", filename.c_str());
+        return false;
+    }
+
+    struct item_t { const node_t *node; std::string path; };
+    std::vector<item_t> todo;
+    todo.push_back({root, node_name(root)});
+    while (!todo.empty()) {
+        item_t it = std::move(todo.back());
+        todo.pop_back();
+        if (it.node->self_cycles) {
+            fprintf(f, "%s %llu\n", it.path.c_str(), (unsigned long long)it.node->self_cycles);
+        }
+        for (auto &child : it.node->children) {
+            todo.push_back({child.second, it.path + ";" + node_name(child.second)});
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+bool Profiler::save_report(const std::string &filename) {
+    FILE *f = fopen(filename.c_str(), "w");
+    if (!f) {
+        printf("Failed to open profile output file: %s\n", filename.c_str());
+        return false;
+    }
+
+    struct routine_t { uint32_t key; uint64_t calls = 0; uint64_t inclusive = 0; uint64_t exclusive = 0; };
+    std::unordered_map<uint32_t, routine_t> routines;
+    std::unordered_map<uint32_t, int> active; // routine already on the path: don't count recursion twice
+
+    // post-order walk computing inclusive cycles per node.
+    std::function<uint64_t(const node_t *)> walk = [&](const node_t *node) -> uint64_t {
+        uint32_t key = node->addr | (node->interrupt ? 0x10000 : 0);
+        if (node != root) active[key]++;
+        uint64_t inclusive = node->self_cycles;
+        for (auto &child : node->children) inclusive += walk(child.second);
+        if (node != root) {
+            routine_t &r = routines[key];
+            r.key = key;
+            r.calls += node->calls;
+            r.exclusive += node->self_cycles;
+            if (active[key] == 1) r.inclusive += inclusive;
+            active[key]--;
+        }
+        return inclusive;
+    };
+    uint64_t total = walk(root);
+
+    std::vector<routine_t> sorted;
+    for (auto &r : routines) sorted.push_back(r.second);
+    std::sort(sorted.begin(), sorted.end(), [](const routine_t &a, const routine_t &b) { return a.inclusive > b.inclusive; });
+
+    fprintf(f, "Total cycles: %llu\n\n", (unsigned long long)total);
+    fprintf(f, "Routine      Calls          Inclusive     %%         Exclusive     %%\n");
+    for (const routine_t &r : sorted) {
+        char name[16];
+        snprintf(name, sizeof(name), (r.key & 0x10000) ? "IRQ_%04X" : "%04X", r.key & 0xFFFF);
+        fprintf(f, "%-9s %9llu %18llu %6.2f %17llu %6.2f\n", name, (unsigned long long)r.calls,
+            (unsigned long long)r.inclusive, total ? 100.0 * r.inclusive / total : 0.0,
+            (unsigned long long)r.exclusive, total ? 100.0 * r.exclusive / total : 0.0);
+    }
+
+    std::vector<uint16_t> pcs;
+    for (uint32_t pc = 0; pc < 65536; pc++) {
+        if (pc_count[pc]) pcs.push_back((uint16_t)pc);
+    }
+    std::sort(pcs.begin(), pcs.end(), [this](uint16_t a, uint16_t b) { return pc_cycles[a] > pc_cycles[b]; });
+
+    Disassembler disasm(mmu);
+    fprintf(f, "\nAddress          Cycles      %%          Count  Instruction\n");
+    for (uint16_t pc : pcs) {
+        disasm.setAddress(pc);
+        std::vector<std::string> line = disasm.disassemble(1);
+        std::string text = line.empty() ? "" : line[0];
+        text.erase(text.find_last_not_of(' ') + 1);
+        fprintf(f, "%04X  %16llu %6.2f %14llu  %s\n", pc, (unsigned long long)pc_cycles[pc],
+            total ? 100.0 * pc_cycles[pc] / total : 0.0, (unsigned long long)pc_count[pc], text.c_str());
+    }
+    fclose(f);
+    return true;
+}
@@ -0,0 +1,120 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "mmus/mmu.hpp"
+
+/**
+ * Profiler hooks in the CPU core only exist when built with GS2_PROFILER
+ * (cmake -DGS2_PROFILER=ON). Otherwise PROFILE() expands to nothing.
+ */
+#ifdef GS2_PROFILER
+#define PROFILE(STMT) { STMT }
+#else
+#define PROFILE(STMT)
+#endif
+
+// deeper than this and we stop pushing frames (runaway recursion or stack games).
+#define PROFILER_MAX_DEPTH 256
+
+/**
+ * Attributes guest cycles to the PC that spent them and to a call path.
+ *
+ * A shadow call stack follows JSR/RTS, BRK/IRQ/RTI. Returns unwind by stack
+ * pointer rather than by matching calls one-for-one, so code that pops its
+ * return address or RTSes through a pushed address doesn't derail it.
+ */
+class Profiler {
+public:
+    Profiler(MMU *mmu);
+    ~Profiler();
+
+    /**
+     * Called before each instruction (or interrupt entry).
+     */
+    inline void begin(uint16_t pc, uint64_t cycles) {
+        start_pc = pc;
+        start_cycles = cycles;
+    }
+
+    /**
+     * Called after the instruction that started at begin() has executed.
+     */
+    void end(uint8_t opcode, uint16_t pc, uint8_t sp, uint64_t cycles);
+
+    /**
+     * Called after the CPU has taken an interrupt and loaded pc from the vector.
+     */
+    void interrupt(uint16_t pc, uint8_t sp, uint64_t cycles);
+
+    /**
+     * Forget the call stack (CPU reset), but keep the counts.
+     */
+    void reset_stack();
+
+    /**
+     * Discard everything collected so far.
+     */
+    void clear();
+
+    /**
+     * One line per call path, "frame;frame;frame cycles" - feed to flamegraph.pl.
+     */
+    bool save_folded(const std::string &filename);
+
+    /**
+     * Per-routine inclusive/exclusive cycles, then the per-address histogram
+     * with each address disassembled.
+     */
+    bool save_report(const std::string &filename);
+
+protected:
+    struct node_t {
+        uint16_t addr;
+        bool interrupt;
+        node_t *parent;
+        uint64_t self_cycles = 0;
+        uint64_t calls = 0;
+        std::unordered_map<uint32_t, node_t *> children;
+    };
+    struct frame_t {
+        node_t *node;
+        uint8_t sp;     // stack pointer just after the return address was pushed
+    };
+
+    MMU *mmu;
+    uint16_t start_pc = 0;
+    uint64_t start_cycles = 0;
+
+    uint64_t *pc_cycles;    // [65536]
+    uint64_t *pc_count;     // [65536]
+
+    node_t *root;
+    node_t *current;
+    std::vector<frame_t> frames;
+
+    void push(uint16_t addr, bool interrupt, uint8_t sp);
+    void unwind(uint8_t sp);
+    void free_node(node_t *node);
+    std::string node_name(const node_t *node);
+};
@@ -0,0 +1,234 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+
+#include "debugger/TimeTravel.hpp"
+#include "debugger/debugwindow.hpp"
+#include "debugger/trace.hpp"
+#include "computer.hpp"
+#include "util/EventTimer.hpp"
+#include "util/mount.hpp"
+
+TimeTravel::TimeTravel(computer_t *computer, debug_window_t *debug_window)
+    : computer(computer), debug_window(debug_window), cpu(computer->cpu), input_log(computer->input_log),
+      checkpoints(TIMETRAVEL_BUDGET) {
+    scratch_trace = new system_trace_buffer(16);
+}
+
+TimeTravel::~TimeTravel() {
+    computer->release_history(this);
+    delete scratch_trace;
+}
+
+void TimeTravel::start() {
+    drop_history();
+    media_changes = computer->mounts->changes;
+    input_log->set_recording(true);
+    next_checkpoint = cpu->cycles;
+}
+
+void TimeTravel::stop() {
+    drop_history();
+    input_log->set_recording(false);
+    next_checkpoint = UINT64_MAX;
+}
+
+void TimeTravel::drop_history() {
+    checkpoints.clear();
+    checkpoint_cycles.clear();
+    computer->release_history(this);
+}
+
+bool TimeTravel::check_media() {
+    if (computer->mounts->changes == media_changes) return true;
+    drop_history();
+    media_changes = computer->mounts->changes;
+    return false;
+}
+
+void TimeTravel::checkpoint() {
+    if (!computer->snapshots_complete()) {
+        next_checkpoint = UINT64_MAX; // nothing to go back to
+        return;
+    }
+    check_media();
+    if (checkpoint_cycles.empty() || checkpoint_cycles.back() < cpu->cycles) {
+        computer->save_snapshot(writer);
+        push(writer.data(), cpu->cycles);
+        input_log->discard_before(checkpoint_cycles.front());
+    }
+    next_checkpoint = cpu->cycles + TIMETRAVEL_INTERVAL;
+}
+
+void TimeTravel::push(const std::vector<uint8_t> &snapshot, uint64_t cycle) {
+    checkpoints.push(snapshot);
+    checkpoint_cycles.push_back(cycle);
+    // the ring drops its oldest checkpoints when over budget.
+    while (checkpoint_cycles.size() > checkpoints.size()) {
+        checkpoint_cycles.pop_front();
+    }
+    computer->hold_history(this, checkpoint_cycles.front());
+}
+
+/**
+ * Checkpoints at or after cycle are in the future once we're back before it, so
+ * they're dropped; the next one down is restored and stays as the newest.
+ */
+bool TimeTravel::load_checkpoint_before(uint64_t cycle) {
+    while (!checkpoint_cycles.empty()) {
+        uint64_t c = checkpoint_cycles.back();
+        size_t n = checkpoints.size();
+        checkpoints.step_back(state);
+        bool popped = checkpoints.size() < n; // the last one is never popped
+        if (popped) checkpoint_cycles.pop_back();
+
+        if (c < cycle) {
+            if (popped) push(state, c);
+            state_cycle = c;
+            return restore_state();
+        }
+        if (!popped) drop_history();
+    }
+    return false;
+}
+
+bool TimeTravel::restore_state() {
+    SnapshotReader r;
+    if (!r.open(state.data(), state.size()) || !computer->restore_snapshot(r)) {
+        message = "Couldn't restore checkpoint";
+        drop_history();
+        return false;
+    }
+    input_log->seek(state_cycle);
+    return true;
+}
+
+void TimeTravel::replay(uint64_t until, uint64_t &last_start, uint64_t *last_break) {
+    system_trace_buffer *trace_buffer = cpu->trace_buffer;
+    Profiler *profiler = cpu->profiler;
+    Coverage *coverage = cpu->coverage;
+    std::vector<uint64_t> hits = debug_window->cond_breaks.save_hits();
+    cpu->trace_buffer = scratch_trace;
+    cpu->profiler = nullptr;
+    cpu->coverage = nullptr;
+    cpu->replaying = true;
+
+    while (cpu->cycles < until && !cpu->halt) {
+        input_log->replay(cpu->cycles);
+        if (computer->event_timer->isEventPassed(cpu->cycles)) {
+            computer->event_timer->processEvents(cpu->cycles);
+        }
+        last_start = cpu->cycles;
+        (cpu->execute_next)(cpu);
+        if (cpu->bus_cycles >= 17030) cpu->bus_cycles -= 17030;
+        if (last_break && cpu->cycles < until
+            && (debug_window->check_breakpoint(&cpu->trace_entry) || cpu->trace_entry.opcode == 0x00)) {
+            *last_break = cpu->cycles;
+        }
+    }
+
+    cpu->replaying = false;
+    cpu->trace_buffer = trace_buffer;
+    cpu->profiler = profiler;
+    cpu->coverage = coverage;
+    debug_window->cond_breaks.restore_hits(hits);
+}
+
+void TimeTravel::finish(uint64_t cycle) {
+    cpu->trace_buffer->truncate(cycle);
+    cpu->execution_mode = EXEC_STEP_INTO;
+    cpu->instructions_left = 0;
+    next_checkpoint = checkpoint_cycles.empty() ? cpu->cycles : checkpoint_cycles.back() + TIMETRAVEL_INTERVAL;
+}
+
+bool TimeTravel::reverse_step() {
+    uint64_t now = cpu->cycles;
+    if (input_log->is_streaming()) {
+        message = "Can't go back while recording input to a file";
+        return false;
+    }
+    if (!computer->snapshots_complete()) {
+        message = "Can't go back: a slot card in this machine can't be snapshotted";
+        return false;
+    }
+    if (!check_media()) {
+        message = "History dropped at a disk change";
+        return false;
+    }
+    if (!load_checkpoint_before(now)) {
+        message = "No history before this point";
+        return false;
+    }
+
+    // find where the previous instruction started, then go there.
+    uint64_t last_start = state_cycle;
+    replay(now, last_start, nullptr);
+    if (cpu->cycles != now) {
+        message = "Replay didn't retrace the original run";
+        restore_state();
+        finish(state_cycle);
+        return false;
+    }
+    restore_state();
+    uint64_t ignored;
+    replay(last_start, ignored, nullptr);
+    finish(last_start);
+    message = "";
+    return true;
+}
+
+bool TimeTravel::reverse_continue() {
+    if (input_log->is_streaming()) {
+        message = "Can't go back while recording input to a file";
+        return false;
+    }
+    if (!computer->snapshots_complete()) {
+        message = "Can't go back: a slot card in this machine can't be snapshotted";
+        return false;
+    }
+    if (!check_media()) {
+        message = "History dropped at a disk change";
+        return false;
+    }
+    if (checkpoint_cycles.empty() || checkpoint_cycles.front() >= cpu->cycles) {
+        message = "No history before this point";
+        return false;
+    }
+
+    // search back a checkpoint interval at a time for the last stop before end.
+    uint64_t end = cpu->cycles;
+    uint64_t ignored;
+    while (!checkpoint_cycles.empty() && checkpoint_cycles.front() < end) {
+        if (!load_checkpoint_before(end)) return false;
+        uint64_t hit = 0;
+        replay(end, ignored, &hit);
+        if (hit) {
+            restore_state();
+            replay(hit, ignored, nullptr);
+            finish(hit);
+            message = "";
+            return true;
+        }
+        end = state_cycle;
+    }
+
+    restore_state();
+    finish(state_cycle);
+    message = "No breakpoint in history; stopped at the oldest checkpoint";
+    return false;
+}
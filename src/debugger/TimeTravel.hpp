@@ -0,0 +1,106 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "cpu.hpp"
+#include "util/InputLog.hpp"
+#include "util/RewindBuffer.hpp"
+#include "util/Snapshot.hpp"
+
+struct computer_t;
+struct debug_window_t;
+struct system_trace_buffer;
+
+// cycles between checkpoints; a reverse step replays at most this many.
+#define TIMETRAVEL_INTERVAL 20000
+#define TIMETRAVEL_BUDGET (64 * 1024 * 1024)
+
+/**
+ * Reverse execution for the debugger.
+ *
+ * While the debug window is open the machine is checkpointed every
+ * TIMETRAVEL_INTERVAL cycles, and external input is kept in the input log.
+ * Going backwards restores the newest checkpoint before the target and
+ * re-executes from it, feeding logged input back at the cycles it first
+ * arrived, so the replay retraces the original run. Replays don't touch the
+ * trace buffer, tracepoint counts, profiler, speaker or printer; the trace
+ * is cut back to the new position afterwards.
+ *
+ * Replays are exact at the fixed clock speeds. Free-run sets the video
+ * clock from host timing, and ProDOS block writes aren't in snapshots.
+ * A disk mount or unmount drops history, since it can't be replayed.
+ */
+class TimeTravel {
+public:
+    TimeTravel(computer_t *computer, debug_window_t *debug_window);
+    ~TimeTravel();
+
+    void start();
+    void stop();
+
+    /**
+     * Called before each instruction while the debugger has control.
+     */
+    inline void tick() {
+        input_log->replay(cpu->cycles);
+        if (cpu->cycles >= next_checkpoint) checkpoint();
+    }
+
+    /**
+     * Back up to the start of the previous instruction.
+     */
+    bool reverse_step();
+
+    /**
+     * Back up to the last place a breakpoint (or BRK) stopped, or would have
+     * stopped, execution before here.
+     */
+    bool reverse_continue();
+
+    const std::string &get_message() const { return message; }
+
+protected:
+    computer_t *computer;
+    debug_window_t *debug_window;
+    cpu_state *cpu;
+    InputLog *input_log;
+
+    RewindBuffer checkpoints;
+    std::deque<uint64_t> checkpoint_cycles;     // one per checkpoint, oldest first
+    SnapshotWriter writer;
+    std::vector<uint8_t> state;                 // the checkpoint last restored
+    uint64_t state_cycle = 0;
+    uint64_t next_checkpoint = UINT64_MAX;
+    uint64_t media_changes = 0;
+    system_trace_buffer *scratch_trace;
+    std::string message;
+
+    void checkpoint();
+    void push(const std::vector<uint8_t> &snapshot, uint64_t cycle);
+    void drop_history();
+    bool check_media();
+    bool load_checkpoint_before(uint64_t cycle);
+    bool restore_state();
+    void replay(uint64_t until, uint64_t &last_start, uint64_t *last_break);
+    void finish(uint64_t cycle);
+};
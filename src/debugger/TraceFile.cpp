@@ -0,0 +1,342 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include "debugger/TraceFile.hpp"
+#include "util/LZ.hpp"
+
+// how many segments may be waiting for the writer before we start dropping them.
+#define TRACE_MAX_QUEUED 64
+
+void trace_encode_block(const system_trace_entry_t *entries, size_t n, uint8_t *raw) {
+    const size_t es = sizeof(system_trace_entry_t);
+    system_trace_entry_t prev;
+    memset(&prev, 0, es);
+
+    for (size_t i = 0; i < n; i++) {
+        const system_trace_entry_t &cur = entries[i];
+        system_trace_entry_t d;
+        const uint8_t *cb = (const uint8_t *)&cur;
+        const uint8_t *pb = (const uint8_t *)&prev;
+        uint8_t *db = (uint8_t *)&d;
+        for (size_t b = 0; b < es; b++) db[b] = cb[b] ^ pb[b];
+        // cycle and pc mostly advance by small amounts; a difference packs better than XOR.
+        d.cycle = cur.cycle - prev.cycle;
+        d.pc = cur.pc - prev.pc;
+
+        for (size_t b = 0; b < es; b++) raw[b * n + i] = db[b];
+        prev = cur;
+    }
+}
+
+void trace_decode_block(const uint8_t *raw, size_t n, system_trace_entry_t *entries) {
+    const size_t es = sizeof(system_trace_entry_t);
+    system_trace_entry_t prev;
+    memset(&prev, 0, es);
+
+    for (size_t i = 0; i < n; i++) {
+        system_trace_entry_t d;
+        uint8_t *db = (uint8_t *)&d;
+        for (size_t b = 0; b < es; b++) db[b] = raw[b * n + i];
+
+        system_trace_entry_t &cur = entries[i];
+        uint8_t *cb = (uint8_t *)&cur;
+        const uint8_t *pb = (const uint8_t *)&prev;
+        for (size_t b = 0; b < es; b++) cb[b] = db[b] ^ pb[b];
+        cur.cycle = prev.cycle + d.cycle;
+        cur.pc = prev.pc + d.pc;
+        prev = cur;
+    }
+}
+
+bool trace_unpack_block(const trace_block_header_t &bh, const uint8_t *payload, std::vector<system_trace_entry_t> &entries) {
+    size_t raw_size = (size_t)bh.entry_count * sizeof(system_trace_entry_t);
+    entries.resize(bh.entry_count);
+
+    if (bh.flags & TRACE_BLOCK_RAW) {
+        if (bh.payload_size != raw_size) return false;
+        trace_decode_block(payload, bh.entry_count, entries.data());
+        return true;
+    }
+    std::vector<uint8_t> raw(raw_size);
+    if (!lz_decompress(payload, bh.payload_size, raw.data(), raw_size)) return false;
+    trace_decode_block(raw.data(), bh.entry_count, entries.data());
+    return true;
+}
+
+TraceFileWriter::TraceFileWriter() {
+}
+
+TraceFileWriter::~TraceFileWriter() {
+    close();
+    for (segment_t *s : free_segments) delete s;
+}
+
+bool TraceFileWriter::open(const std::string &filename, uint32_t entries_per_block) {
+    if (file.is_open()) close();
+
+    file.open(filename, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+        printf("Failed to open trace file: %s\n", filename.c_str());
+        return false;
+    }
+    this->entries_per_block = entries_per_block;
+    file_offset = 0;
+    entries_written = 0;
+    segments_dropped = 0;
+    write_error = false;
+    index.clear();
+
+    trace_file_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, TRACE_FILE_MAGIC, 4);
+    hdr.version = TRACE_FILE_VERSION;
+    hdr.entry_size = sizeof(system_trace_entry_t);
+    hdr.entries_per_block = entries_per_block;
+    write_bytes(&hdr, sizeof(hdr));
+
+    stopping = false;
+    writer_thread = std::thread(&TraceFileWriter::writer, this);
+    return !write_error;
+}
+
+void TraceFileWriter::submit(const system_trace_entry_t *entries, size_t n, uint64_t first_index) {
+    if (n == 0) return;
+    segment_t *seg;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        if (queue.size() >= TRACE_MAX_QUEUED) {
+            if (segments_dropped++ == 0) {
+                printf("Trace writer can't keep up, dropping segments\n");
+            }
+            return;
+        }
+        if (free_segments.empty()) {
+            seg = new segment_t;
+        } else {
+            seg = free_segments.back();
+            free_segments.pop_back();
+        }
+    }
+    seg->entries.assign(entries, entries + n);
+    seg->first_index = first_index;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        queue.push_back(seg);
+    }
+    work_ready.notify_one();
+}
+
+bool TraceFileWriter::close() {
+    if (!file.is_open()) return true;
+
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        stopping = true;
+    }
+    work_ready.notify_one();
+    if (writer_thread.joinable()) writer_thread.join();
+
+    uint64_t index_offset = file_offset;
+    if (!index.empty()) write_bytes(index.data(), index.size() * sizeof(trace_index_entry_t));
+
+    trace_file_trailer_t tr;
+    memset(&tr, 0, sizeof(tr));
+    memcpy(tr.magic, TRACE_TRAILER_MAGIC, 4);
+    tr.version = TRACE_FILE_VERSION;
+    tr.index_offset = index_offset;
+    tr.block_count = index.size();
+    tr.entry_count = entries_written;
+    write_bytes(&tr, sizeof(tr));
+
+    file.close();
+    if (segments_dropped) {
+        printf("Trace writer dropped %llu segments\n", (unsigned long long)segments_dropped);
+    }
+    return !write_error;
+}
+
+void TraceFileWriter::writer() {
+    std::unique_lock<std::mutex> lk(lock);
+    while (true) {
+        work_ready.wait(lk, [this]() { return stopping || !queue.empty(); });
+        if (queue.empty()) break; // stopping, and everything is written.
+
+        segment_t *seg = queue.front();
+        queue.pop_front();
+        lk.unlock();
+
+        for (size_t i = 0; i < seg->entries.size(); i += entries_per_block) {
+            size_t n = std::min((size_t)entries_per_block, seg->entries.size() - i);
+            write_block(&seg->entries[i], n, seg->first_index + i);
+        }
+
+        lk.lock();
+        free_segments.push_back(seg);
+    }
+}
+
+void TraceFileWriter::write_block(const system_trace_entry_t *entries, size_t n, uint64_t first_index) {
+    size_t raw_size = n * sizeof(system_trace_entry_t);
+    raw.resize(raw_size);
+    packed.resize(lz_compress_bound(raw_size));
+    trace_encode_block(entries, n, raw.data());
+    size_t packed_size = lz_compress(raw.data(), raw_size, packed.data());
+
+    trace_block_header_t bh;
+    memset(&bh, 0, sizeof(bh));
+    memcpy(bh.magic, TRACE_BLOCK_MAGIC, 4);
+    bh.entry_count = (uint32_t)n;
+    bh.first_index = first_index;
+    bh.first_cycle = entries[0].cycle;
+    bh.last_cycle = entries[n - 1].cycle;
+    if (packed_size >= raw_size) {
+        bh.flags |= TRACE_BLOCK_RAW;
+        bh.payload_size = (uint32_t)raw_size;
+    } else {
+        bh.payload_size = (uint32_t)packed_size;
+    }
+
+    trace_index_entry_t ie;
+    ie.offset = file_offset;
+    ie.first_index = bh.first_index;
+    ie.first_cycle = bh.first_cycle;
+    ie.last_cycle = bh.last_cycle;
+    ie.entry_count = bh.entry_count;
+    ie.payload_size = bh.payload_size;
+
+    write_bytes(&bh, sizeof(bh));
+    write_bytes((bh.flags & TRACE_BLOCK_RAW) ? raw.data() : packed.data(), bh.payload_size);
+    index.push_back(ie);
+    entries_written += n;
+}
+
+void TraceFileWriter::write_bytes(const void *data, size_t len) {
+    if (write_error) return;
+    file.write((const char *)data, len);
+    if (!file) {
+        printf("Trace file write failed\n");
+        write_error = true;
+        return;
+    }
+    file_offset += len;
+}
+
+bool TraceFileReader::is_trace_file(const std::string &filename) {
+    std::ifstream f(filename, std::ios::binary);
+    char magic[4];
+    if (!f.read(magic, 4)) return false;
+    return memcmp(magic, TRACE_FILE_MAGIC, 4) == 0;
+}
+
+bool TraceFileReader::open(const std::string &filename) {
+    close();
+    if (!map.open(filename, true)) {
+        return false;
+    }
+    const uint8_t *base = map.data();
+    uint64_t file_size = map.size();
+
+    trace_file_header_t hdr;
+    if (file_size < sizeof(hdr) || memcmp(base, TRACE_FILE_MAGIC, 4) != 0) {
+        printf("Not a trace file: %s\n", filename.c_str());
+        close();
+        return false;
+    }
+    memcpy(&hdr, base, sizeof(hdr));
+    if (hdr.version != TRACE_FILE_VERSION || hdr.entry_size != sizeof(system_trace_entry_t)) {
+        printf("Unsupported trace file version %u (entry size %u)\n", hdr.version, hdr.entry_size);
+        close();
+        return false;
+    }
+
+    trace_file_trailer_t tr;
+    if (file_size >= sizeof(hdr) + sizeof(tr)) {
+        memcpy(&tr, base + file_size - sizeof(tr), sizeof(tr));
+        if (memcmp(tr.magic, TRACE_TRAILER_MAGIC, 4) == 0
+            && tr.index_offset + tr.block_count * sizeof(trace_index_entry_t) + sizeof(tr) == file_size) {
+            index.resize(tr.block_count);
+            if (tr.block_count) memcpy(index.data(), base + tr.index_offset, tr.block_count * sizeof(trace_index_entry_t));
+            entry_count = tr.entry_count;
+            complete = true;
+            return true;
+        }
+    }
+    printf("Trace file has no index, scanning blocks\n");
+    return scan_blocks();
+}
+
+bool TraceFileReader::scan_blocks() {
+    const uint8_t *base = map.data();
+    uint64_t file_size = map.size();
+    index.clear();
+    entry_count = 0;
+    uint64_t offset = sizeof(trace_file_header_t);
+    trace_block_header_t bh;
+
+    while (offset + sizeof(bh) <= file_size) {
+        memcpy(&bh, base + offset, sizeof(bh));
+        if (memcmp(bh.magic, TRACE_BLOCK_MAGIC, 4) != 0) break;
+        if (offset + sizeof(bh) + bh.payload_size > file_size) break; // truncated block
+        trace_index_entry_t ie;
+        ie.offset = offset;
+        ie.first_index = bh.first_index;
+        ie.first_cycle = bh.first_cycle;
+        ie.last_cycle = bh.last_cycle;
+        ie.entry_count = bh.entry_count;
+        ie.payload_size = bh.payload_size;
+        index.push_back(ie);
+        entry_count += bh.entry_count;
+        offset += sizeof(bh) + bh.payload_size;
+    }
+    complete = false;
+    return true;
+}
+
+void TraceFileReader::close() {
+    map.close();
+    index.clear();
+    entry_count = 0;
+    complete = false;
+}
+
+bool TraceFileReader::read_block(size_t block, std::vector<system_trace_entry_t> &entries) {
+    if (block >= index.size()) return false;
+    const trace_index_entry_t &ie = index[block];
+
+    trace_block_header_t bh;
+    if (ie.offset + sizeof(bh) > map.size()) return false;
+    memcpy(&bh, map.data() + ie.offset, sizeof(bh));
+    if (memcmp(bh.magic, TRACE_BLOCK_MAGIC, 4) != 0 || ie.offset + sizeof(bh) + bh.payload_size > map.size()) {
+        printf("Bad trace block header at %llu\n", (unsigned long long)ie.offset);
+        return false;
+    }
+    if (!trace_unpack_block(bh, map.data() + ie.offset + sizeof(bh), entries)) {
+        printf("Corrupt trace block %zu\n", block);
+        return false;
+    }
+    return true;
+}
+
+size_t TraceFileReader::find_block(uint64_t cycle) {
+    auto it = std::lower_bound(index.begin(), index.end(), cycle,
+        [](const trace_index_entry_t &ie, uint64_t c) { return ie.last_cycle < c; });
+    return it - index.begin();
+}
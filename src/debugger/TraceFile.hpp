@@ -0,0 +1,196 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "debugger/trace.hpp"
+#include "util/MappedFile.hpp"
+
+/**
+ * .gstrace file layout (all fields little-endian):
+ *
+ *   trace_file_header_t
+ *   block: trace_block_header_t, payload
+ *   block: ...
+ *   trace_index_entry_t[block_count]
+ *   trace_file_trailer_t
+ *
+ * Each block holds up to entries_per_block entries and decodes on its own.
+ * The payload is the entries delta-encoded against the previous entry in the
+ * block (cycle and pc subtracted, everything else XORed), transposed so that
+ * byte N of every entry is contiguous, then LZ compressed. The index and
+ * trailer are written on close; a file without them (the emulator died) can
+ * still be read by walking the block headers.
+ */
+
+#define TRACE_FILE_MAGIC "GS2T"
+#define TRACE_BLOCK_MAGIC "TBLK"
+#define TRACE_TRAILER_MAGIC "GS2I"
+#define TRACE_FILE_VERSION 1
+
+#define TRACE_BLOCK_RAW 0x0001 // payload stored without LZ
+
+struct trace_file_header_t {
+    char magic[4];
+    uint16_t version;
+    uint16_t entry_size;
+    uint32_t entries_per_block;
+    uint32_t flags;
+    uint64_t reserved[2];
+};
+
+struct trace_block_header_t {
+    char magic[4];
+    uint32_t entry_count;
+    uint32_t payload_size;
+    uint32_t flags;
+    uint64_t first_index;   // sequence number of the first entry since recording started
+    uint64_t first_cycle;
+    uint64_t last_cycle;
+};
+
+struct trace_index_entry_t {
+    uint64_t offset;        // file offset of the block header
+    uint64_t first_index;
+    uint64_t first_cycle;
+    uint64_t last_cycle;
+    uint32_t entry_count;
+    uint32_t payload_size;
+};
+
+struct trace_file_trailer_t {
+    char magic[4];
+    uint32_t version;
+    uint64_t index_offset;
+    uint64_t block_count;
+    uint64_t entry_count;
+};
+
+/**
+ * Delta-encode and transpose n entries into raw (n * sizeof(system_trace_entry_t) bytes).
+ */
+void trace_encode_block(const system_trace_entry_t *entries, size_t n, uint8_t *raw);
+
+/**
+ * Inverse of trace_encode_block.
+ */
+void trace_decode_block(const uint8_t *raw, size_t n, system_trace_entry_t *entries);
+
+/**
+ * Decode one block payload (as stored in the file) into entries.
+ */
+bool trace_unpack_block(const trace_block_header_t &bh, const uint8_t *payload, std::vector<system_trace_entry_t> &entries);
+
+/**
+ * Streams trace segments to a .gstrace file. submit() copies the entries and
+ * returns; encoding, compression and file I/O happen on a background thread.
+ * If the writer falls too far behind, segments are dropped rather than
+ * stalling the caller. Dropped ranges show up as gaps in first_index.
+ */
+class TraceFileWriter {
+public:
+    TraceFileWriter();
+    ~TraceFileWriter();
+
+    bool open(const std::string &filename, uint32_t entries_per_block);
+    void submit(const system_trace_entry_t *entries, size_t n, uint64_t first_index);
+
+    /**
+     * Drain the queue, write the index and trailer, and close the file.
+     */
+    bool close();
+
+    bool is_open() { return file.is_open(); }
+    uint64_t get_entries_written() { return entries_written; }
+    uint64_t get_bytes_written() { return file_offset; }
+    uint64_t get_segments_dropped() { return segments_dropped; }
+
+protected:
+    struct segment_t {
+        std::vector<system_trace_entry_t> entries;
+        uint64_t first_index;
+    };
+
+    std::ofstream file;
+    uint32_t entries_per_block = 0;
+    uint64_t file_offset = 0;
+    uint64_t entries_written = 0;
+    uint64_t segments_dropped = 0;
+    bool write_error = false;
+    std::vector<trace_index_entry_t> index;
+
+    std::thread writer_thread;
+    std::mutex lock;
+    std::condition_variable work_ready;
+    std::deque<segment_t *> queue;
+    std::vector<segment_t *> free_segments;
+    bool stopping = false;
+
+    std::vector<uint8_t> raw;
+    std::vector<uint8_t> packed;
+
+    void writer();
+    void write_block(const system_trace_entry_t *entries, size_t n, uint64_t first_index);
+    void write_bytes(const void *data, size_t len);
+};
+
+/**
+ * Reads a .gstrace file block by block. The file is memory-mapped, and
+ * read_block() only touches the mapping, so different blocks may be decoded
+ * from several threads at once.
+ */
+class TraceFileReader {
+public:
+    bool open(const std::string &filename);
+    void close();
+
+    uint64_t get_block_count() { return index.size(); }
+    uint64_t get_entry_count() { return entry_count; }
+    uint64_t get_file_size() { return map.size(); }
+    const trace_index_entry_t &get_block_info(size_t block) { return index[block]; }
+
+    /**
+     * True if the file had an index; false if it was rebuilt by scanning.
+     */
+    bool is_complete() { return complete; }
+
+    bool read_block(size_t block, std::vector<system_trace_entry_t> &entries);
+
+    /**
+     * Index of the first block whose last_cycle >= cycle, or get_block_count().
+     */
+    size_t find_block(uint64_t cycle);
+
+    static bool is_trace_file(const std::string &filename);
+
+protected:
+    MappedFile map;
+    uint64_t entry_count = 0;
+    bool complete = false;
+    std::vector<trace_index_entry_t> index;
+
+    bool scan_blocks();
+};
@@ -0,0 +1,305 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+#include <fstream>
+#include <atomic>
+#include <algorithm>
+
+#include "debugger/TraceQuery.hpp"
+#include "debugger/trace_opcodes.hpp"
+
+#define TRACE_INDEX_MAGIC "GS2X"
+#define TRACE_INDEX_VERSION 1
+
+// blocks decoded per worker per batch when running a query.
+#define TRACE_QUERY_BATCH 4
+
+struct trace_index_file_header_t {
+    char magic[4];
+    uint32_t version;
+    uint64_t trace_size;    // the index is stale if the trace changed size
+    uint64_t block_count;
+};
+
+struct trace_access_table_t {
+    uint8_t access[256];
+
+    trace_access_table_t() {
+        static const char *writes[] = { "STA", "STX", "STY", "STZ" };
+        static const char *rmw[] = { "ASL", "LSR", "ROL", "ROR", "INC", "DEC", "TSB", "TRB" };
+        for (int i = 0; i < 256; i++) {
+            const disasm_entry &d = disasm_table[i];
+            uint8_t acc = 0;
+            if (d.opcode != nullptr && d.mode != NONE && d.mode != ACC && d.mode != IMP && d.mode != IMM && d.mode != REL
+                && strcmp(d.opcode, "JMP") != 0 && strcmp(d.opcode, "JSR") != 0) {
+                acc = TRACE_ACCESS_READ;
+                for (const char *w : writes) if (strcmp(d.opcode, w) == 0) acc = TRACE_ACCESS_WRITE;
+                for (const char *w : rmw) if (strcmp(d.opcode, w) == 0) acc = TRACE_ACCESS_READ | TRACE_ACCESS_WRITE;
+            }
+            access[i] = acc;
+        }
+    }
+};
+
+uint8_t trace_opcode_access(uint8_t opcode) {
+    static const trace_access_table_t table;
+    return table.access[opcode];
+}
+
+bool trace_query_t::matches(const system_trace_entry_t &e) const {
+    if (e.cycle < cycle_lo || e.cycle > cycle_hi) return false;
+    if (has_pc && ((e.pc & 0xFFFF) < pc_lo || (e.pc & 0xFFFF) > pc_hi)) return false;
+    if (has_opcode && !opcodes.test(e.opcode)) return false;
+    if (has_addr || access) {
+        uint8_t acc = trace_opcode_access(e.opcode);
+        if (acc == 0 || (acc & access) != access) return false;
+        if (has_addr && ((e.eaddr & 0xFFFF) < addr_lo || (e.eaddr & 0xFFFF) > addr_hi)) return false;
+    }
+    return true;
+}
+
+/**
+ * "C000-C0FF", "$C0xx" (x is a wildcard hex digit) or a single address.
+ */
+static bool parse_addr_range(const std::string &arg, uint16_t &lo, uint16_t &hi) {
+    std::string s = arg;
+    if (!s.empty() && s[0] == '$') s = s.substr(1);
+    size_t dash = s.find('-');
+    std::string slo = s, shi = s;
+    if (dash != std::string::npos) {
+        slo = s.substr(0, dash);
+        shi = s.substr(dash + 1);
+        if (!shi.empty() && shi[0] == '$') shi = shi.substr(1);
+    }
+    for (char &c : slo) if (c == 'x' || c == 'X') c = '0';
+    for (char &c : shi) if (c == 'x' || c == 'X') c = 'F';
+    if (slo.empty() || shi.empty()) return false;
+
+    char *end;
+    unsigned long l = strtoul(slo.c_str(), &end, 16);
+    if (*end) return false;
+    unsigned long h = strtoul(shi.c_str(), &end, 16);
+    if (*end) return false;
+    if (l > 0xFFFF || h > 0xFFFF || l > h) return false;
+    lo = (uint16_t)l;
+    hi = (uint16_t)h;
+    return true;
+}
+
+bool trace_query_t::parse(const std::vector<std::string> &args, std::string &error) {
+    for (size_t i = 0; i < args.size(); i++) {
+        const std::string &term = args[i];
+        bool has_value = i + 1 < args.size();
+
+        if (term == "read") {
+            access |= TRACE_ACCESS_READ;
+        } else if (term == "write") {
+            access |= TRACE_ACCESS_WRITE;
+        } else if (term == "cycles" && has_value) {
+            const std::string &v = args[++i];
+            size_t dash = v.find('-');
+            std::string slo = v.substr(0, dash);
+            std::string shi = (dash == std::string::npos) ? v : v.substr(dash + 1);
+            cycle_lo = slo.empty() ? 0 : strtoull(slo.c_str(), nullptr, 10);
+            cycle_hi = shi.empty() ? UINT64_MAX : strtoull(shi.c_str(), nullptr, 10);
+        } else if (term == "pc" && has_value) {
+            if (!parse_addr_range(args[++i], pc_lo, pc_hi)) {
+                error = "bad pc range: " + args[i];
+                return false;
+            }
+            has_pc = true;
+        } else if (term == "addr" && has_value) {
+            if (!parse_addr_range(args[++i], addr_lo, addr_hi)) {
+                error = "bad address range: " + args[i];
+                return false;
+            }
+            has_addr = true;
+        } else if (term == "op" && has_value) {
+            const std::string &v = args[++i];
+            bool found = false;
+            for (int op = 0; op < 256; op++) {
+                if (disasm_table[op].opcode && strcasecmp(disasm_table[op].opcode, v.c_str()) == 0) {
+                    opcodes.set((uint8_t)op);
+                    found = true;
+                }
+            }
+            if (!found) {
+                char *end;
+                unsigned long op = strtoul(v.c_str() + (v[0] == '$' ? 1 : 0), &end, 16);
+                if (*end || op > 0xFF) {
+                    error = "bad opcode: " + v;
+                    return false;
+                }
+                opcodes.set((uint8_t)op);
+            }
+            has_opcode = true;
+        } else if (term == "limit" && has_value) {
+            limit = strtoull(args[++i].c_str(), nullptr, 10);
+        } else {
+            error = "bad query term: " + term;
+            return false;
+        }
+    }
+    return true;
+}
+
+TraceQuery::TraceQuery(TraceFileReader &reader, unsigned int num_threads) : reader(reader), pool(num_threads) {
+}
+
+std::string TraceQuery::index_filename(const std::string &trace_filename) {
+    return trace_filename + ".idx";
+}
+
+bool TraceQuery::load_index(const std::string &trace_filename, bool rebuild) {
+    std::string idx = index_filename(trace_filename);
+    if (!rebuild && read_index(idx)) {
+        return true;
+    }
+    if (!build_index()) {
+        return false;
+    }
+    if (!save_index(idx)) {
+        printf("Could not save trace index %s\n", idx.c_str());
+    }
+    return true;
+}
+
+bool TraceQuery::read_index(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    trace_index_file_header_t hdr;
+    if (!file.read((char *)&hdr, sizeof(hdr))) return false;
+    if (memcmp(hdr.magic, TRACE_INDEX_MAGIC, 4) != 0 || hdr.version != TRACE_INDEX_VERSION
+        || hdr.trace_size != reader.get_file_size() || hdr.block_count != reader.get_block_count()) {
+        return false;
+    }
+    summaries.resize(hdr.block_count);
+    if (hdr.block_count && !file.read((char *)summaries.data(), hdr.block_count * sizeof(trace_block_summary_t))) {
+        summaries.clear();
+        return false;
+    }
+    return true;
+}
+
+bool TraceQuery::save_index(const std::string &filename) {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    trace_index_file_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, TRACE_INDEX_MAGIC, 4);
+    hdr.version = TRACE_INDEX_VERSION;
+    hdr.trace_size = reader.get_file_size();
+    hdr.block_count = summaries.size();
+    file.write((const char *)&hdr, sizeof(hdr));
+    file.write((const char *)summaries.data(), summaries.size() * sizeof(trace_block_summary_t));
+    return (bool)file;
+}
+
+bool TraceQuery::build_index() {
+    size_t nblocks = reader.get_block_count();
+    summaries.assign(nblocks, trace_block_summary_t{});
+    std::atomic<bool> ok(true);
+
+    for (size_t b = 0; b < nblocks; b++) {
+        pool.enqueue([this, b, &ok]() {
+            std::vector<system_trace_entry_t> entries;
+            if (!reader.read_block(b, entries)) {
+                ok = false;
+                return;
+            }
+            trace_block_summary_t &s = summaries[b];
+            for (const system_trace_entry_t &e : entries) {
+                s.pc_pages.set((e.pc >> 8) & 0xFF);
+                s.opcodes.set(e.opcode);
+                uint8_t acc = trace_opcode_access(e.opcode);
+                if (acc & TRACE_ACCESS_READ) s.read_pages.set((e.eaddr >> 8) & 0xFF);
+                if (acc & TRACE_ACCESS_WRITE) s.write_pages.set((e.eaddr >> 8) & 0xFF);
+            }
+        });
+    }
+    pool.wait_idle();
+    return ok;
+}
+
+std::vector<size_t> TraceQuery::candidate_blocks(const trace_query_t &q) {
+    std::vector<size_t> blocks;
+
+    trace_bitset_t pc_pages = {}, addr_pages = {};
+    pc_pages.set_range(q.pc_lo >> 8, q.pc_hi >> 8);
+    addr_pages.set_range(q.addr_lo >> 8, q.addr_hi >> 8);
+
+    for (size_t b = reader.find_block(q.cycle_lo); b < reader.get_block_count(); b++) {
+        const trace_index_entry_t &ie = reader.get_block_info(b);
+        if (ie.first_cycle > q.cycle_hi) break;
+
+        if (b < summaries.size()) {
+            const trace_block_summary_t &s = summaries[b];
+            if (q.has_pc && !s.pc_pages.intersects(pc_pages)) continue;
+            if (q.has_opcode && !s.opcodes.intersects(q.opcodes)) continue;
+            if (q.has_addr || q.access) {
+                bool r = s.read_pages.intersects(addr_pages);
+                bool w = s.write_pages.intersects(addr_pages);
+                if ((q.access & TRACE_ACCESS_READ) && !r) continue;
+                if ((q.access & TRACE_ACCESS_WRITE) && !w) continue;
+                if (!q.access && !r && !w) continue;
+            }
+        }
+        blocks.push_back(b);
+    }
+    return blocks;
+}
+
+uint64_t TraceQuery::run(const trace_query_t &q, const std::function<void(const std::string &line)> &out) {
+    std::vector<size_t> blocks = candidate_blocks(q);
+    size_t batch = pool.size() * TRACE_QUERY_BATCH;
+    std::vector<std::vector<std::string>> results(batch);
+    uint64_t matched = 0;
+
+    for (size_t start = 0; start < blocks.size(); start += batch) {
+        size_t n = std::min(batch, blocks.size() - start);
+        for (size_t j = 0; j < n; j++) {
+            size_t b = blocks[start + j];
+            std::vector<std::string> &lines = results[j];
+            lines.clear();
+            pool.enqueue([this, b, &q, &lines]() {
+                std::vector<system_trace_entry_t> entries;
+                char buffer[TRACE_LINE_SIZE];
+                if (!reader.read_block(b, entries)) return;
+                for (const system_trace_entry_t &e : entries) {
+                    if (!q.matches(e)) continue;
+                    lines.emplace_back(system_trace_buffer::format_trace_entry(&e, buffer));
+                    if (q.limit && lines.size() >= q.limit) break;
+                }
+            });
+        }
+        pool.wait_idle();
+
+        for (size_t j = 0; j < n; j++) {
+            for (const std::string &line : results[j]) {
+                out(line);
+                matched++;
+                if (q.limit && matched >= q.limit) return matched;
+            }
+        }
+    }
+    return matched;
+}
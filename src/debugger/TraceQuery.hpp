@@ -0,0 +1,120 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "debugger/TraceFile.hpp"
+#include "util/ThreadPool.hpp"
+
+#define TRACE_ACCESS_READ  0x01
+#define TRACE_ACCESS_WRITE 0x02
+
+/**
+ * How an instruction touches the memory at eaddr (TRACE_ACCESS_*), or 0 if
+ * eaddr isn't a data access (immediate, implied, branches, JMP/JSR).
+ */
+uint8_t trace_opcode_access(uint8_t opcode);
+
+/**
+ * 256-bit set, one bit per page or opcode.
+ */
+struct trace_bitset_t {
+    uint64_t bits[4];
+
+    void set(uint8_t n) { bits[n >> 6] |= 1ULL << (n & 63); }
+    bool test(uint8_t n) const { return (bits[n >> 6] >> (n & 63)) & 1; }
+    bool intersects(const trace_bitset_t &o) const {
+        return (bits[0] & o.bits[0]) | (bits[1] & o.bits[1]) | (bits[2] & o.bits[2]) | (bits[3] & o.bits[3]);
+    }
+    void set_range(uint8_t lo, uint8_t hi) { for (int n = lo; n <= hi; n++) set((uint8_t)n); }
+};
+
+/**
+ * What one trace block touched. Kept in the sidecar index (<trace>.idx)
+ * so a query only has to decompress blocks that can contain a match.
+ */
+struct trace_block_summary_t {
+    trace_bitset_t pc_pages;
+    trace_bitset_t read_pages;
+    trace_bitset_t write_pages;
+    trace_bitset_t opcodes;
+};
+
+struct trace_query_t {
+    uint64_t cycle_lo = 0;
+    uint64_t cycle_hi = UINT64_MAX;
+    bool has_pc = false;
+    uint16_t pc_lo = 0;
+    uint16_t pc_hi = 0xFFFF;
+    bool has_addr = false;
+    uint16_t addr_lo = 0;
+    uint16_t addr_hi = 0xFFFF;
+    uint8_t access = 0;         // TRACE_ACCESS_* that must be present; 0 = any
+    bool has_opcode = false;
+    trace_bitset_t opcodes = {};
+    uint64_t limit = 0;         // 0 = no limit
+
+    bool matches(const system_trace_entry_t &e) const;
+
+    /**
+     * Parse "cycles A-B", "pc 0300-03FF", "addr C0xx", "op STA", "read",
+     * "write", "limit N". Returns false and fills error on a bad term.
+     */
+    bool parse(const std::vector<std::string> &args, std::string &error);
+};
+
+/**
+ * Query engine over a .gstrace file: filters blocks with the sidecar
+ * index, then decodes and formats the survivors on a thread pool.
+ */
+class TraceQuery {
+public:
+    TraceQuery(TraceFileReader &reader, unsigned int num_threads = 0);
+
+    /**
+     * Load <trace_filename>.idx, or build and save it if it's missing, stale
+     * or rebuild is set.
+     */
+    bool load_index(const std::string &trace_filename, bool rebuild = false);
+
+    /**
+     * Blocks that may contain a match, in file order.
+     */
+    std::vector<size_t> candidate_blocks(const trace_query_t &q);
+
+    /**
+     * Run q and call out with each matching line, in trace order. Returns the
+     * number of matches.
+     */
+    uint64_t run(const trace_query_t &q, const std::function<void(const std::string &line)> &out);
+
+    static std::string index_filename(const std::string &trace_filename);
+
+protected:
+    TraceFileReader &reader;
+    ThreadPool pool;
+    std::vector<trace_block_summary_t> summaries;
+
+    bool build_index();
+    bool save_index(const std::string &filename);
+    bool read_index(const std::string &filename);
+};
@@ -1,5 +1,6 @@
 #include <SDL3/SDL.h>
 #include <iostream>
+#include <algorithm>
 
 #include "debugwindow.hpp"
 #include "cpu.hpp"
@@ -21,6 +22,7 @@
 debug_window_t::debug_window_t(computer_t *computer) {
     this->computer = computer;
     this->cpu = computer->cpu;
+    time_travel = new TimeTravel(computer, this);
 
     panel_visible[DEBUG_PANEL_TRACE] = 1; // all default to off, so enable here.
 
@@ -110,6 +112,7 @@ debug_window_t::~debug_window_t() {
     delete mon_textinput;
     if (disasm) delete disasm;
     if (step_disasm) delete step_disasm;
+    delete time_travel;
 }
 
 bool debug_window_t::check_breakpoint(system_trace_entry_t *entry) {
@@ -119,7 +122,7 @@ bool debug_window_t::check_breakpoint(system_trace_entry_t *entry) {
             return true;
         }
     }
-    return false;
+    return cond_breaks.check(cpu, entry);
 }
 
 void debug_window_t::execute_command(const std::string& command) {
@@ -127,7 +130,7 @@ void debug_window_t::execute_command(const std::string& command) {
     cmd->print();
 
     int num_mem_watches = memory_watches.size();
-    ExecuteCommand *exec = new ExecuteCommand(computer->mmu, cmd, &memory_watches, &breaks, disasm);
+    ExecuteCommand *exec = new ExecuteCommand(computer->mmu, cmd, &memory_watches, &breaks, disasm, &cond_breaks);
     exec->execute();
     
     mon_history.push_back(command); // put into the scrollback
@@ -217,7 +220,7 @@ void debug_window_t::render_pane_trace() {
     }
     text_renderer->set_color(255, 255, 255, 255);
     separator_line(DEBUG_PANEL_TRACE, 3);
-    snprintf(buffer, sizeof(buffer), "T)race: %s  SPACE: Step  RETURN: Run  Up/Dn/PgUp/PgDn/Home/End: Scroll", cpu->trace ? "ON " : "OFF");
+    snprintf(buffer, sizeof(buffer), "T)race: %s  SPACE: Step  BKSP/Shift: Back  RETURN: Run  Up/Dn/PgUp/PgDn/Home/End: Scroll", cpu->trace ? "ON " : "OFF");
     draw_text(DEBUG_PANEL_TRACE, x, 3, buffer);
   
     separator_line(DEBUG_PANEL_TRACE, 4);
@@ -270,6 +273,22 @@ void debug_window_t::render_pane_monitor() {
     mon_textinput->set_tile_position(x + 20, (buf_area_lines * font_line_height));
     mon_textinput->render(renderer);
 
+    // conditional breaks and their hit counts stay pinned above the scrollback.
+    int bp_lines = std::min((int)cond_breaks.size(), DEBUG_MONITOR_BP_LINES);
+    int i = 0;
+    for (const breakpoint_t &bp : cond_breaks.get_list()) {
+        if (i == bp_lines) break;
+        snprintf(buffer, sizeof(buffer), "#%-3d %s %04X.%04X %-10llu %s", bp.id, bp.kind == BP_KIND_BREAK ? "break" : "count",
+            bp.lo, bp.hi, (unsigned long long)bp.hits, bp.condition_text.c_str());
+        draw_text(DEBUG_PANEL_MONITOR, x, base_line + i, buffer);
+        i++;
+    }
+    if (bp_lines) {
+        base_line += bp_lines;
+        buf_area_lines -= bp_lines;
+        separator_line(DEBUG_PANEL_MONITOR, base_line);
+    }
+
     // get number of lines in mon_display_buffer
     int bufferlines = mon_display_buffer.size();
     int startline = 0;
@@ -487,6 +506,11 @@ bool debug_window_t::handle_event(SDL_Event &event) {
                     cpu->execution_mode = EXEC_STEP_INTO;
                     cpu->instructions_left = 1;
                 }
+                if (event.key.key == SDLK_BACKSPACE) {
+                    bool ok = (event.key.mod & SDL_KMOD_SHIFT) ? time_travel->reverse_continue() : time_travel->reverse_step();
+                    if (!ok) mon_display_buffer.push_back(time_travel->get_message());
+                    view_position = 0;
+                }
                 if (event.key.key == SDLK_RETURN) {
                     cpu->execution_mode = EXEC_NORMAL;
                     cpu->instructions_left = 0;
@@ -554,6 +578,7 @@ void debug_window_t::set_open() {
     disasm = new Disassembler(computer->mmu);
     step_disasm = new Disassembler(computer->mmu);
     window_open = true;
+    time_travel->start();
     computer->video_system->show(window);
     computer->video_system->raise(window);
     //SDL_ShowWindow(window);
@@ -562,6 +587,7 @@ void debug_window_t::set_open() {
 
 void debug_window_t::set_closed() {
     window_open = false;
+    time_travel->stop();
 
     computer->video_system->hide(window);
     computer->video_system->raise(computer->video_system->window); // TODO: awkward.
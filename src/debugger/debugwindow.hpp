@@ -9,6 +9,11 @@
 #include "ui/TextInput.hpp"
 #include "debugger/MemoryWatch.hpp"
 #include "debugger/disasm.hpp"
+#include "debugger/Breakpoints.hpp"
+#include "debugger/TimeTravel.hpp"
+
+// conditional breaks listed at the top of the monitor pane.
+#define DEBUG_MONITOR_BP_LINES 4
 
 struct computer_t;
 struct video_system_t;
@@ -42,6 +47,8 @@ struct debug_window_t {
     Container_t *tab_container;
     MemoryWatch memory_watches;
     MemoryWatch breaks;
+    Breakpoints cond_breaks;
+    TimeTravel *time_travel = nullptr;
     Disassembler *disasm = nullptr;
     Disassembler *step_disasm = nullptr;
 
@@ -3,6 +3,7 @@
 
 #include "util/HexDecode.hpp"
 #include "debugger/trace.hpp"
+#include "debugger/TraceFile.hpp"
 #include "debugger/trace_opcodes.hpp"
 #include "opcodes.hpp"
 
@@ -15,6 +16,7 @@
     }
 
     system_trace_buffer::~system_trace_buffer() {
+        stop_streaming();
         if (entries != nullptr) {
             delete[] entries;
         }
@@ -26,6 +28,9 @@
         if (head >= size) {
             head = 0;
         }
+        if (stream && (head % TRACE_STREAM_SEGMENT) == 0) {
+            stream_segment();
+        }
         if (head == tail) {
             tail++;
             count--;
@@ -36,26 +41,106 @@
         count++;
     }   
 
+    void system_trace_buffer::truncate(uint64_t cycle) {
+        while (count > 0 && !(stream && head == stream_mark)) {
+            size_t last = (head == 0) ? size - 1 : head - 1;
+            if (entries[last].cycle < cycle) break;
+            head = last;
+            count--;
+        }
+    }
+
     void system_trace_buffer::save_to_file(const std::string &filename) {
         printf("Saving trace to file: %s\n", filename.c_str());
         printf("Head: %zu, Tail: %zu, Size: %zu\n", head, tail, size);
-        std::ofstream file(filename);
-        size_t index = tail;
-        while (index != head) {
-            // Write the binary record to the file
-            file.write(reinterpret_cast<const char*>(&entries[index]), sizeof(system_trace_entry_t));
-            index++;
-            if (index >= size) {
-                index = 0;
-            }
+        TraceFileWriter writer;
+        if (!writer.open(filename, TRACE_STREAM_SEGMENT)) {
+            return;
+        }
+        if (head >= tail) {
+            writer.submit(&entries[tail], head - tail, 0);
+        } else {
+            writer.submit(&entries[tail], size - tail, 0);
+            writer.submit(&entries[0], head, size - tail);
         }
-        file.close();
+        writer.close();
     }
 
     void system_trace_buffer::read_from_file(const std::string &filename) {
-        std::ifstream file(filename);
-        file.read(reinterpret_cast<char*>(entries), sizeof(system_trace_entry_t) * size);
-        file.close();
+        if (!TraceFileReader::is_trace_file(filename)) {
+            // headerless dump from older versions.
+            std::ifstream file(filename, std::ios::binary);
+            file.read(reinterpret_cast<char*>(entries), sizeof(system_trace_entry_t) * size);
+            count = file.gcount() / sizeof(system_trace_entry_t);
+            head = count % size;
+            tail = 0;
+            file.close();
+            return;
+        }
+
+        TraceFileReader reader;
+        if (!reader.open(filename)) {
+            return;
+        }
+        // keep the last size entries, oldest first.
+        head = 0;
+        tail = 0;
+        count = 0;
+        uint64_t skip = reader.get_entry_count() > size ? reader.get_entry_count() - size : 0;
+        std::vector<system_trace_entry_t> block;
+        for (size_t b = 0; b < reader.get_block_count(); b++) {
+            uint32_t n = reader.get_block_info(b).entry_count;
+            if (skip >= n) {
+                skip -= n;
+                continue;
+            }
+            if (!reader.read_block(b, block)) break;
+            for (size_t i = skip; i < block.size(); i++) {
+                entries[head++] = block[i];
+                count++;
+            }
+            skip = 0;
+        }
+        if (head >= size) head = 0;
+    }
+
+    bool system_trace_buffer::start_streaming(const std::string &filename) {
+        stop_streaming();
+        stream = new TraceFileWriter();
+        if (!stream->open(filename, TRACE_STREAM_SEGMENT)) {
+            delete stream;
+            stream = nullptr;
+            return false;
+        }
+        printf("Streaming trace to file: %s\n", filename.c_str());
+        stream_mark = head;
+        stream_index = 0;
+        return true;
+    }
+
+    void system_trace_buffer::stop_streaming() {
+        if (!stream) return;
+        // hand over whatever is left of the current segment.
+        if (head > stream_mark) {
+            stream->submit(&entries[stream_mark], head - stream_mark, stream_index);
+            stream_index += head - stream_mark;
+        }
+        stream->close();
+        printf("Trace stream closed: %llu entries, %llu bytes\n",
+            (unsigned long long)stream->get_entries_written(), (unsigned long long)stream->get_bytes_written());
+        delete stream;
+        stream = nullptr;
+    }
+
+    /**
+     * head just crossed a segment boundary (or wrapped). Everything from
+     * stream_mark up to it is complete and goes to the writer.
+     */
+    void system_trace_buffer::stream_segment() {
+        size_t end = (head == 0) ? size : head;
+        stream->submit(&entries[stream_mark], end - stream_mark, stream_index);
+        stream_index += end - stream_mark;
+        stream_mark = head;
     }
 
     system_trace_entry_t *system_trace_buffer::get_entry(size_t index) {
@@ -79,10 +164,13 @@
 #define TB_DATA 76
 
     char * system_trace_buffer::decode_trace_entry(system_trace_entry_t *entry) {
-        static char buffer[256];
+        return format_trace_entry(entry, line);
+    }
+
+    char * system_trace_buffer::format_trace_entry(const system_trace_entry_t *entry, char *buffer) {
         char snpbuf[256];
 
-        size_t buffer_size = sizeof(buffer);
+        size_t buffer_size = TRACE_LINE_SIZE;
         size_t snpbuf_size = sizeof(snpbuf);
         // if in 8-bit mode
         memset(buffer, ' ', buffer_size);
@@ -30,6 +30,13 @@ struct system_trace_entry_t {
     uint32_t eaddr; // the effective memory address used.
 };
 
+class TraceFileWriter;
+
+// entries handed to the stream writer at a time while streaming.
+#define TRACE_STREAM_SEGMENT 4096
+
+#define TRACE_LINE_SIZE 256
+
 struct system_trace_buffer {
     system_trace_entry_t *entries;
     size_t size;
@@ -37,18 +44,48 @@ struct system_trace_buffer {
     size_t tail;
     size_t count;
 
+    TraceFileWriter *stream = nullptr;
+    size_t stream_mark = 0;     // ring index of the first entry not yet handed to stream
+    uint64_t stream_index = 0;  // sequence number of the entry at stream_mark
+
     system_trace_buffer(size_t capacity);
     ~system_trace_buffer();
 
     void add_entry(const system_trace_entry_t &entry);
 
+    /**
+     * Drop the newest entries, for instructions starting at or after cycle -
+     * used when the debugger steps backwards. Entries already streamed stay.
+     */
+    void truncate(uint64_t cycle);
+
     void save_to_file(const std::string &filename);
 
     void read_from_file(const std::string &filename);
 
+    /**
+     * Continuously write the trace to a .gstrace file as it's recorded.
+     */
+    bool start_streaming(const std::string &filename);
+    void stop_streaming();
+    bool is_streaming() { return stream != nullptr; }
+
     system_trace_entry_t *get_entry(size_t index);
 
+    /**
+     * Format into this buffer's line; valid until the next call on the same buffer.
+     */
     char *decode_trace_entry(system_trace_entry_t *entry);
+
+    /**
+     * Same, into a caller-supplied buffer of TRACE_LINE_SIZE chars.
+     */
+    static char *format_trace_entry(const system_trace_entry_t *entry, char *buffer);
+
+protected:
+    char line[TRACE_LINE_SIZE];
+
+    void stream_segment();
 };
 
 
@@ -166,6 +166,7 @@ In DOS at $B800 lives the "prenibble routine" . I could perhaps steal that. hehe
 #include "devices/diskii/diskii_fmt.hpp"
 #include "debug.hpp"
 #include "util/mount.hpp"
+#include "util/Snapshot.hpp"
 
 /* uint8_t diskII_firmware[256] = {
  0xA2,  0x20,  0xA0,  0x00,   0xA2,  0x03,  0x86,  0x3C,   0x8A,  0x0A,  0x24,  0x3C,   0xF0,  0x10,  0x05,  0x3C,  
@@ -543,8 +544,9 @@ uint8_t diskII_read_C0xx(void *context, uint16_t address) {
            /**
             * when Q6L is read, and Q7H was previously set (written) then we need to write the byte to the disk.
             */
-            if (seldrive.Q7 == 1 || seldrive.Q6 == 1) {
+            if ((seldrive.Q7 == 1 || seldrive.Q6 == 1) && !cpu->speculative) {
                 write_nybble(seldrive);
+                cpu->counters.disk_nibbles++;
                 //seldrive.Q7 = 0;
             }
             break;
@@ -567,7 +569,9 @@ uint8_t diskII_read_C0xx(void *context, uint16_t address) {
     /* ANY even address read will get the contents of the current nibble. */
     if (((reg & 0x01) == 0) && (seldrive.Q7 == 0 && seldrive.Q6 == 0)) {
         //seldrive.last_read_cycle = cpu->cycles;
+        uint16_t head_position = seldrive.head_position;
         uint8_t x = read_nybble(seldrive, thisSlot->motor);
+        if (seldrive.head_position != head_position) cpu->counters.disk_nibbles++;
         //printf("read_nybble: %02X\n", x);
         return x;
     }
@@ -684,6 +688,88 @@ void diskii_reset(diskII_controller *diskII_d) {
     //}
 }
 
+/**
+ * Snapshot: controller latches, and per drive the head, shift registers
+ * and nibble tracks. Tracks are only restored into the same image that was
+ * mounted when the snapshot was taken.
+ */
+void diskii_save_state(diskII_controller *diskII_d, SnapshotWriter &w) {
+    w.begin_chunk("DSK2", 1, diskII_d->_slot);
+    w.put(diskII_d->drive_select);
+    w.put(diskII_d->motor);
+    w.put(diskII_d->mark_cycles_turnoff);
+    for (int j = 0; j < 2; j++) {
+        diskII &disk = diskII_d->drive[j];
+        w.put(disk.rw_mode);
+        w.put(disk.track);
+        w.put(disk.phase0);
+        w.put(disk.phase1);
+        w.put(disk.phase2);
+        w.put(disk.phase3);
+        w.put(disk.last_phase_on);
+        w.put(disk.Q7);
+        w.put(disk.Q6);
+        w.put(disk.image_index);
+        w.put(disk.head_position);
+        w.put(disk.bit_position);
+        w.put(disk.read_shift_register);
+        w.put(disk.write_shift_register);
+        w.put(disk.last_read_cycle);
+        w.put(disk.modified);
+        w.put(disk.is_mounted);
+        w.put_string(disk.is_mounted && disk.media_d ? disk.media_d->filename : std::string());
+        if (!disk.is_mounted) continue;
+        for (int t = 0; t < 35; t++) {
+            track_t &track = disk.nibblized.tracks[t];
+            w.put(track.size);
+            w.put(track.position);
+            w.put(track.data, track.size);
+        }
+    }
+    w.end_chunk();
+}
+
+bool diskii_restore_state(diskII_controller *diskII_d, SnapshotReader &r) {
+    if (!r.find("DSK2", diskII_d->_slot)) {
+        fprintf(stderr, "Snapshot: no Disk II state for slot %d\n", diskII_d->_slot);
+        return false;
+    }
+    bool ok = r.get(diskII_d->drive_select) && r.get(diskII_d->motor) && r.get(diskII_d->mark_cycles_turnoff);
+    for (int j = 0; ok && j < 2; j++) {
+        diskII &disk = diskII_d->drive[j];
+        bool modified, is_mounted;
+        std::string filename;
+        ok = r.get(disk.rw_mode) && r.get(disk.track) && r.get(disk.phase0) && r.get(disk.phase1) && r.get(disk.phase2)
+            && r.get(disk.phase3) && r.get(disk.last_phase_on) && r.get(disk.Q7) && r.get(disk.Q6) && r.get(disk.image_index)
+            && r.get(disk.head_position) && r.get(disk.bit_position) && r.get(disk.read_shift_register)
+            && r.get(disk.write_shift_register) && r.get(disk.last_read_cycle) && r.get(modified) && r.get(is_mounted)
+            && r.get_string(filename);
+        if (!ok || !is_mounted) continue;
+
+        bool same_media = disk.is_mounted && disk.media_d && disk.media_d->filename == filename;
+        if (!same_media) {
+            fprintf(stderr, "Snapshot: slot %d drive %d had %s mounted; leaving the current disk alone\n",
+                diskII_d->_slot, j + 1, filename.c_str());
+        }
+        for (int t = 0; ok && t < 35; t++) {
+            uint16_t size, position;
+            ok = r.get(size) && r.get(position) && size <= TRACK_SIZE;
+            if (!ok) break;
+            if (same_media) {
+                track_t &track = disk.nibblized.tracks[t];
+                track.size = size;
+                track.position = position;
+                ok = r.get(track.data, size);
+            } else {
+                ok = r.skip(size);
+            }
+        }
+        // the restored tracks may differ from the image file either way.
+        if (same_media) disk.modified = disk.modified || modified;
+    }
+    if (!ok) fprintf(stderr, "Snapshot: Disk II state for slot %d is truncated\n", diskII_d->_slot);
+    return ok;
+}
 
 void init_slot_diskII(computer_t *computer, SlotType_t slot) {
     cpu_state *cpu = computer->cpu;
@@ -751,6 +837,10 @@ void init_slot_diskII(computer_t *computer, SlotType_t slot) {
             return true;
         });
 
+    computer->register_snapshot_handler(
+        [diskII_d](SnapshotWriter &w) { diskii_save_state(diskII_d, w); },
+        [diskII_d](SnapshotReader &r) { return diskii_restore_state(diskII_d, r); });
+
 }
 
 void debug_dump_disk_images(cpu_state *cpu) { // only dump slot 6.
@@ -31,6 +31,9 @@
 #include "debug.hpp"
 #include "devices/game/gamecontroller.hpp"
 #include "devices/game/mousewheel.hpp"
+#include "util/Snapshot.hpp"
+#include "util/InputLog.hpp"
+#include "util/DeviceFrameDispatcher.hpp"
 
 /**
  * this is a relatively naive implementation of game controller,
@@ -114,44 +117,85 @@ JoystickValues convertJoystickValues(int32_t x, int32_t y) {
     };
 }
 
-uint8_t strobe_game_inputs(void *context, uint16_t address) {
-    cpu_state *cpu = (cpu_state *)context;
-    gamec_state_t *ds = (gamec_state_t *)get_module_state(cpu, MODULE_GAMECONTROLLER);
+/**
+ * Read the host devices into paddle positions (0-255) and button bits, packed
+ * as logged by the input log: paddles 0-3 in bytes 0-3, buttons in byte 4.
+ * Sampled once per frame, so what the machine sees changes at a frame
+ * boundary that can be recorded and replayed.
+ */
+static uint64_t sample_game_inputs(gamec_state_t *ds) {
+    uint8_t paddle[4] = { 0, 0, 0, 0 };
+    uint8_t buttons = 0;
+    float mouse_x, mouse_y;
+    SDL_MouseButtonFlags mouse_buttons = SDL_GetMouseState(&mouse_x, &mouse_y);
 
     if (ds->gps[0].game_type == GAME_INPUT_TYPE_MOUSE) {
-        float mouse_x, mouse_y;
-        SDL_GetMouseState(&mouse_x, &mouse_y);
+        float x = std::clamp(mouse_x / WINDOW_WIDTH, 0.0f, 1.0f);
+        float y = std::clamp(mouse_y / WINDOW_HEIGHT, 0.0f, 1.0f);
         if (ds->paddle_flip_01) {
-            uint64_t x_trigger =  cpu->cycles + (GAME_INPUT_DECAY_TIME * (1.0f - (float(mouse_x) / WINDOW_WIDTH)));
-            uint64_t y_trigger = cpu->cycles + (GAME_INPUT_DECAY_TIME * (1.0f - (float(mouse_y) / WINDOW_HEIGHT)));
-
-            ds->game_input_trigger_0 = y_trigger;
-            ds->game_input_trigger_1 =x_trigger;   
+            paddle[0] = (uint8_t)(255 * (1.0f - y));
+            paddle[1] = (uint8_t)(255 * (1.0f - x));
         } else {
-            uint64_t x_trigger =  cpu->cycles + (GAME_INPUT_DECAY_TIME * (float(mouse_x) / WINDOW_WIDTH));
-            uint64_t y_trigger = cpu->cycles + (GAME_INPUT_DECAY_TIME * (float(mouse_y) / WINDOW_HEIGHT));
-
-            ds->game_input_trigger_0 = x_trigger;
-            ds->game_input_trigger_1 = y_trigger;
+            paddle[0] = (uint8_t)(255 * x);
+            paddle[1] = (uint8_t)(255 * y);
         }
-        if (DEBUG(DEBUG_GAME)) fprintf(stdout, "Strobe game inputs: %f, %f: %llu, %llu\n", mouse_x, mouse_y, ds->game_input_trigger_0, ds->game_input_trigger_1);
     } else if (ds->gps[0].game_type == GAME_INPUT_TYPE_MOUSEWHEEL) {
-        ds->game_input_trigger_0 = cpu->cycles + (GAME_INPUT_DECAY_TIME / 255) * ds->mouse_wheel_pos_0;
+        paddle[0] = (uint8_t)ds->mouse_wheel_pos_0;
     } else if (ds->gps[0].game_type == GAME_INPUT_TYPE_GAMEPAD) {
         // Scale the axes larger, to get the corners to full extent
-        
         int32_t axis0 = SDL_GetGamepadAxis(ds->gps[0].gamepad, SDL_GAMEPAD_AXIS_LEFTX);
         int32_t axis1 = SDL_GetGamepadAxis(ds->gps[0].gamepad, SDL_GAMEPAD_AXIS_LEFTY);
 
         JoystickValues jv = convertJoystickValues(axis0, axis1);
-        uint64_t x_trigger =  cpu->cycles + ((GAME_INPUT_DECAY_TIME * jv.x) / 255);
-        uint64_t y_trigger = cpu->cycles + ((GAME_INPUT_DECAY_TIME * jv.y) / 255);
+        paddle[0] = (uint8_t)jv.x;
+        paddle[1] = (uint8_t)jv.y;
+    }
 
-        ds->game_input_trigger_0 = x_trigger;
-        ds->game_input_trigger_1 = y_trigger;
+    for (int i = 0; i < 3; i++) {
+        gamepad_state_t &gp = ds->gps[i == 2 ? 1 : 0];
+        bool down;
+        if (gp.game_type == GAME_INPUT_TYPE_GAMEPAD) {
+            if (i == 1) {
+                down = SDL_GetGamepadButton(gp.gamepad, SDL_GAMEPAD_BUTTON_SOUTH)
+                    || SDL_GetGamepadButton(gp.gamepad, SDL_GAMEPAD_BUTTON_WEST)
+                    || SDL_GetGamepadButton(gp.gamepad, SDL_GAMEPAD_BUTTON_RIGHT_SHOULDER);
+            } else {
+                down = SDL_GetGamepadButton(gp.gamepad, SDL_GAMEPAD_BUTTON_EAST)
+                    || SDL_GetGamepadButton(gp.gamepad, SDL_GAMEPAD_BUTTON_NORTH)
+                    || SDL_GetGamepadButton(gp.gamepad, SDL_GAMEPAD_BUTTON_LEFT_SHOULDER);
+            }
+        } else {
+            down = (mouse_buttons & SDL_BUTTON_MASK(i == 0 ? SDL_BUTTON_LEFT : SDL_BUTTON_RIGHT)) != 0;
+        }
+        if (down) buttons |= 1 << i;
     }
+    SDL_Keymod mod = SDL_GetModState();
+    if (mod & SDL_KMOD_LGUI) buttons |= 1; // TODO: restrict to Apple IIe
+    if (mod & SDL_KMOD_RGUI) buttons |= 2;
+
+    return (uint64_t)paddle[0] | ((uint64_t)paddle[1] << 8) | ((uint64_t)paddle[2] << 16)
+        | ((uint64_t)paddle[3] << 24) | ((uint64_t)buttons << 32);
+}
+
+static void apply_game_inputs(gamec_state_t *ds, uint64_t input) {
+    ds->input = input;
+    ds->game_switch_0 = (input >> 32) & 1;
+    ds->game_switch_1 = (input >> 33) & 1;
+    ds->game_switch_2 = (input >> 34) & 1;
+}
+
+uint8_t strobe_game_inputs(void *context, uint16_t address) {
+    cpu_state *cpu = (cpu_state *)context;
+    gamec_state_t *ds = (gamec_state_t *)get_module_state(cpu, MODULE_GAMECONTROLLER);
+
+    // paddle N times out after a time proportional to its position.
+    ds->game_input_trigger_0 = cpu->cycles + (GAME_INPUT_DECAY_TIME * ((ds->input >> 0) & 0xFF)) / 255;
+    ds->game_input_trigger_1 = cpu->cycles + (GAME_INPUT_DECAY_TIME * ((ds->input >> 8) & 0xFF)) / 255;
+    ds->game_input_trigger_2 = cpu->cycles + (GAME_INPUT_DECAY_TIME * ((ds->input >> 16) & 0xFF)) / 255;
+    ds->game_input_trigger_3 = cpu->cycles + (GAME_INPUT_DECAY_TIME * ((ds->input >> 24) & 0xFF)) / 255;
+    if (DEBUG(DEBUG_GAME)) fprintf(stdout, "Strobe game inputs: %llu, %llu\n", ds->game_input_trigger_0, ds->game_input_trigger_1);
+
     return cpu->video_scanner->get_video_byte();
-    //return 0x00;xs
 }
 
 void strobe_game_inputs_w(void *context, uint16_t address, uint8_t value) {
@@ -199,63 +243,18 @@ uint8_t read_game_input_3(void *context, uint16_t address) {
 uint8_t read_game_switch_0(void *context, uint16_t address) {
     cpu_state *cpu = (cpu_state *)context;
     gamec_state_t *ds = (gamec_state_t *)get_module_state(cpu, MODULE_GAMECONTROLLER);
-    if (ds->gps[0].game_type == GAME_INPUT_TYPE_GAMEPAD) {
-        if (SDL_GetGamepadButton(ds->gps[0].gamepad, SDL_GAMEPAD_BUTTON_EAST)) {
-            ds->game_switch_0 = 1;
-        } else if (SDL_GetGamepadButton(ds->gps[0].gamepad, SDL_GAMEPAD_BUTTON_NORTH)) {
-            ds->game_switch_0 = 1;
-        } else if (SDL_GetGamepadButton(ds->gps[0].gamepad, SDL_GAMEPAD_BUTTON_LEFT_SHOULDER)) {
-            ds->game_switch_0 = 1;
-        } else {
-            ds->game_switch_0 = 0;
-        }
-    } else {
-        ds->game_switch_0 = (SDL_GetMouseState(NULL, NULL) & SDL_BUTTON_MASK(SDL_BUTTON_LEFT)) != 0;
-    }
-    if (SDL_GetModState() & SDL_KMOD_LGUI) { // TODO: restrict to Apple IIe
-        ds->game_switch_0 = 1;
-    }
     return ds->game_switch_0 ? 0x80 : 0x00;
 }
 
 uint8_t read_game_switch_1(void *context, uint16_t address) {
     cpu_state *cpu = (cpu_state *)context;
     gamec_state_t *ds = (gamec_state_t *)get_module_state(cpu, MODULE_GAMECONTROLLER);
-    if (ds->gps[0].game_type == GAME_INPUT_TYPE_GAMEPAD) {
-        if (SDL_GetGamepadButton(ds->gps[0].gamepad, SDL_GAMEPAD_BUTTON_SOUTH)) {
-            ds->game_switch_1 = 1;
-        } else if (SDL_GetGamepadButton(ds->gps[0].gamepad, SDL_GAMEPAD_BUTTON_WEST)) {
-            ds->game_switch_1 = 1;
-        } else if (SDL_GetGamepadButton(ds->gps[0].gamepad, SDL_GAMEPAD_BUTTON_RIGHT_SHOULDER)) {
-            ds->game_switch_1 = 1;
-        } else {
-            ds->game_switch_1 = 0;
-        }
-    } else {
-        ds->game_switch_1 = (SDL_GetMouseState(NULL, NULL) & SDL_BUTTON_MASK(SDL_BUTTON_RIGHT)) != 0;
-    }
-    if (SDL_GetModState() & SDL_KMOD_RGUI) { // TODO: restrict to Apple IIe
-        ds->game_switch_1 = 1;
-    }
     return ds->game_switch_1 ? 0x80 : 0x00;
 }
 
 uint8_t read_game_switch_2(void *context, uint16_t address) {
     cpu_state *cpu = (cpu_state *)context;
     gamec_state_t *ds = (gamec_state_t *)get_module_state(cpu, MODULE_GAMECONTROLLER);
-    if (ds->gps[1].game_type == GAME_INPUT_TYPE_GAMEPAD) {
-        if (SDL_GetGamepadButton(ds->gps[1].gamepad, SDL_GAMEPAD_BUTTON_EAST)) {
-            ds->game_switch_2 = 1;
-        } else if (SDL_GetGamepadButton(ds->gps[1].gamepad, SDL_GAMEPAD_BUTTON_NORTH)) {
-            ds->game_switch_2 = 1;
-        } else if (SDL_GetGamepadButton(ds->gps[1].gamepad, SDL_GAMEPAD_BUTTON_LEFT_SHOULDER)) {
-            ds->game_switch_2 = 1;
-        } else {
-            ds->game_switch_2 = 0;
-        }
-    } else {
-        ds->game_switch_2 = (SDL_GetMouseState(NULL, NULL) & SDL_BUTTON_MASK(SDL_BUTTON_RIGHT)) != 0;
-    }
     return ds->game_switch_2 ? 0x80 : 0x00;
 }
 
@@ -357,7 +356,7 @@ bool remove_gamepad(gamec_state_t *gp_d, const SDL_Event &event) {
 void init_mb_game_controller(computer_t *computer, SlotType_t slot) {
     cpu_state *cpu = computer->cpu;
     
-    SDL_InitSubSystem(SDL_INIT_GAMEPAD);
+    if (!computer->headless) SDL_InitSubSystem(SDL_INIT_GAMEPAD);
     // alloc and init display state
     gamec_state_t *ds = new gamec_state_t;
     ds->event_queue = computer->event_queue;
@@ -370,6 +369,7 @@ void init_mb_game_controller(computer_t *computer, SlotType_t slot) {
     ds->game_input_trigger_2 = 0;
     ds->game_input_trigger_3 = 0;
     ds->mouse_wheel_pos_0 = 0;
+    ds->input = 0;
     ds->paddle_flip_01 = 0; // to swap the mouse axes so Y is paddle 0
     ds->gps[0].game_type = GAME_INPUT_TYPE_MOUSE;
     ds->gps[1].game_type = GAME_INPUT_TYPE_MOUSE;
@@ -413,4 +413,43 @@ void init_mb_game_controller(computer_t *computer, SlotType_t slot) {
         handle_mouse_wheel(ds, event);
         return true;
     });
+
+    // the host devices are read once a frame; a change is logged like any other input.
+    computer->device_frame_dispatcher->registerHandler([computer, ds]() {
+        if (computer->headless || computer->input_log->is_replaying()) return true;
+        uint64_t input = sample_game_inputs(ds);
+        if (input != ds->input) {
+            apply_game_inputs(ds, input);
+            computer->input_log->record(computer->cpu->cycles, INPUT_GAME, input);
+        }
+        return true;
+    });
+    computer->input_log->register_handler(INPUT_GAME, [ds](const input_event_t &event) {
+        apply_game_inputs(ds, event.data);
+    });
+
+    // the paddle timers, and the last sample of the host devices.
+    computer->register_snapshot_handler(
+        [ds](SnapshotWriter &w) {
+            w.begin_chunk("GAME", 2);
+            w.put(ds->game_input_trigger_0);
+            w.put(ds->game_input_trigger_1);
+            w.put(ds->game_input_trigger_2);
+            w.put(ds->game_input_trigger_3);
+            w.put(ds->input);
+            w.end_chunk();
+        },
+        [ds](SnapshotReader &r) {
+            uint16_t version;
+            if (!r.find("GAME", 0, &version)) return true;
+            uint64_t input = ds->input;
+            if (!r.get(ds->game_input_trigger_0) || !r.get(ds->game_input_trigger_1)
+                || !r.get(ds->game_input_trigger_2) || !r.get(ds->game_input_trigger_3)
+                || (version >= 2 && !r.get(input))) {
+                fprintf(stderr, "Snapshot: bad game controller state\n");
+                return false;
+            }
+            apply_game_inputs(ds, input);
+            return true;
+        });
 }
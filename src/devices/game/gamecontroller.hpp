@@ -72,6 +72,7 @@ typedef struct gamec_state_t {
     uint64_t game_input_trigger_3;
 
     int mouse_wheel_pos_0; // only one wheel per mouse.
+    uint64_t input;        // last sample of the host devices, packed as INPUT_GAME
     int paddle_flip_01;
 
     gamepad_state gps[MAX_GAMEPAD_COUNT];   
@@ -28,6 +28,8 @@
 
 #include "mbus/KeyboardMessage.hpp"
 #include "mbus/MessageBus.hpp"
+#include "util/Snapshot.hpp"
+#include "util/Timeline.hpp"
 
 /**
  * First, handling the "language card" portion or what the IIe manual calls the "Bank Switch RAM".
@@ -55,7 +57,9 @@ void bsr_map_memory(iiememory_state_t *lc) {
     uint8_t *banke0 = lc->ram + banke0offset;
     uint8_t *rom = lc->mmu->get_rom_base();
 
-    const char *bank_d = (lc->FF_BANK_1 == 1) ? "LC_BANK1" : "LC_BANK2";
+    // aux banks get their own tags so the debugger and coverage can tell them from main.
+    const char *bank_d = (lc->FF_BANK_1 == 1) ? (lc->f_altzp ? "ALT_LC_BANK1" : "LC_BANK1") : (lc->f_altzp ? "ALT_LC_BANK2" : "LC_BANK2");
+    const char *bank_e = lc->f_altzp ? "ALT LC RAM" : "LC RAM";
 
     /* Map D0 - DF */
     for (int i = 0; i < 16; i++) {
@@ -78,7 +82,7 @@ void bsr_map_memory(iiememory_state_t *lc) {
     /* Map E0 - FF */
     for (int i = 0; i < 32; i++) {
         if (lc->FF_READ_ENABLE) {
-            lc->mmu->map_page_read(i+0xE0, banke0 + (i * GS2_PAGE_SIZE), "LC RAM");
+            lc->mmu->map_page_read(i+0xE0, banke0 + (i * GS2_PAGE_SIZE), bank_e);
 
         } else { // reads == READ_ROM
             // TODO: this is wrong - needs to somehow know to return to ROM D0/etc wherever that may be.
@@ -86,7 +90,7 @@ void bsr_map_memory(iiememory_state_t *lc) {
         }
 
         if (!lc->_FF_WRITE_ENABLE) {
-            lc->mmu->map_page_write(i+0xE0, banke0 + (i * GS2_PAGE_SIZE), "LC RAM");
+            lc->mmu->map_page_write(i+0xE0, banke0 + (i * GS2_PAGE_SIZE), bank_e);
         } else { // writes == WRITE_NONE - set it to the ROM and can_write = 0
             lc->mmu->map_page_write(i+0xE0, nullptr, "NONE"); // much simpler actually.. no write enable means null write pointer.
         }
@@ -256,9 +260,11 @@ void iiememory_debug(iiememory_state_t *iiememory_d) {
 }
 
 void iiememory_compose_map(iiememory_state_t *iiememory_d) {
+    TIMELINE_SCOPE("iiememory_compose_map");
     const char *TAG_MAIN = "MAIN";
     const char *TAG_ALT = "ALT";
     
+    iiememory_d->computer->cpu->counters.remaps++;
     update_display_flags(iiememory_d);
     VideoScannerII *vs = iiememory_d->computer->video_scanner;
     
@@ -581,5 +587,36 @@ void init_iiememory(computer_t *computer, SlotType_t slot) {
             reset_iiememory(iiememory_d);
             return true;
         });
+
+    // RAM itself is saved with the MMU; this is just the switches.
+    computer->register_snapshot_handler(
+        [iiememory_d](SnapshotWriter &w) {
+            w.begin_chunk("IIEM", 1);
+            w.put(iiememory_d->switch_state);
+            w.put(iiememory_d->f_80store);
+            w.put(iiememory_d->f_ramrd);
+            w.put(iiememory_d->f_ramwrt);
+            w.put(iiememory_d->f_altzp);
+            w.put(iiememory_d->s_page2);
+            w.put(iiememory_d->FF_BANK_1);
+            w.put(iiememory_d->FF_READ_ENABLE);
+            w.put(iiememory_d->FF_PRE_WRITE);
+            w.put(iiememory_d->_FF_WRITE_ENABLE);
+            w.end_chunk();
+        },
+        [iiememory_d](SnapshotReader &r) {
+            iiememory_state_t *d = iiememory_d;
+            if (!r.find("IIEM") || !r.get(d->switch_state) || !r.get(d->f_80store) || !r.get(d->f_ramrd) || !r.get(d->f_ramwrt)
+                || !r.get(d->f_altzp) || !r.get(d->s_page2) || !r.get(d->FF_BANK_1) || !r.get(d->FF_READ_ENABLE)
+                || !r.get(d->FF_PRE_WRITE) || !r.get(d->_FF_WRITE_ENABLE)) {
+                fprintf(stderr, "Snapshot: no IIe memory state\n");
+                return false;
+            }
+            // the MMU restore just put every page back to main memory; compose from there.
+            d->m_zp = d->m_text1_r = d->m_text1_w = d->m_hires1_r = d->m_hires1_w = d->m_all_r = d->m_all_w = false;
+            bsr_map_memory(d);
+            iiememory_compose_map(d);
+            return true;
+        });
 }
 
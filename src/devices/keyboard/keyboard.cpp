@@ -24,6 +24,9 @@
 #include "keyboard.hpp"
 
 #include "mbus/KeyboardMessage.hpp"
+#include "util/Snapshot.hpp"
+#include "util/InputLog.hpp"
+#include "cpus/fast_forward.hpp"
 
 // Software should be able to:
 // Read keyboard from register at $C000.
@@ -55,6 +58,8 @@ uint8_t kb_read_C00X(void *context, uint16_t address) {
         }
     }
     uint8_t key = kb_state->kb_key_strobe;
+    // nothing can change until the next input; a loop polling us can be skipped ahead.
+    if ((key & 0x80) == 0) kb_state->cpu->loop_hint |= LOOP_HINT_POLL;
     return key;
 }
 
@@ -73,17 +78,26 @@ uint8_t kb_read_C010(void *context, uint16_t address) {
     // Clear the keyboard latch
     kb_clear_strobe(kb_state);
     // AKD is "any key down". it is set instantly whenever a key is pressed.
-    // the apple ii keyboard can't report multiple keys. So, just check to see if SDL
-        // sees any key as down.
-        // alternately we can keep track of all key-down and key-up events and if there are more key down than key up, set AKD.
+    // kept up to date by the key down/up handlers (kb_update_akd).
+    return kb_state->kb_key_strobe | (kb_state->akd ? 0x80 : 0x00);
+}
+
+/**
+ * The apple ii keyboard can't report multiple keys. So, just check to see if SDL
+ * sees any key as down. Done on key events rather than on each read, so that
+ * the flag changes at a cycle that can be logged and replayed.
+ */
+static void kb_update_akd(computer_t *computer, keyboard_state_t *kb_state) {
     int numkeys;
     const bool *keyarr = SDL_GetKeyboardState(&numkeys);
     bool akd = false;
     for (int i = 0; i < numkeys; i++) {
         if (keyarr[i]) { akd = true; break; }
     }
-   
-    return kb_state->kb_key_strobe | (akd ? 0x80 : 0x00);
+    if (akd != kb_state->akd) {
+        kb_state->akd = akd;
+        computer->input_log->record(computer->cpu->cycles, INPUT_ANY_KEY, akd);
+    }
 }
 
 void kb_write_C01X(void *context, uint16_t address, uint8_t value) {
@@ -162,9 +176,45 @@ void handle_keydown_iiplus(const SDL_Event &event, keyboard_state_t *kb_state) {
     }
 }
 
+/**
+ * Latch and pending paste; a snapshot without them leaves the keyboard as it is.
+ * Key presses and pastes also go in the input log so they can be replayed.
+ */
+static void kb_register_state_handlers(computer_t *computer, keyboard_state_t *kb_state) {
+    computer->input_log->register_handler(INPUT_KEY, [kb_state](const input_event_t &event) {
+        kb_key_pressed(kb_state, (uint8_t)event.data);
+    });
+    computer->input_log->register_handler(INPUT_PASTE, [kb_state](const input_event_t &event) {
+        kb_state->paste_buffer = event.text;
+    });
+    computer->input_log->register_handler(INPUT_ANY_KEY, [kb_state](const input_event_t &event) {
+        kb_state->akd = event.data != 0;
+    });
+
+    computer->register_snapshot_handler(
+        [kb_state](SnapshotWriter &w) {
+            w.begin_chunk("KEYB", 2);
+            w.put(kb_state->kb_key_strobe);
+            w.put_string(kb_state->paste_buffer);
+            w.put(kb_state->akd);
+            w.end_chunk();
+        },
+        [kb_state](SnapshotReader &r) {
+            uint16_t version;
+            if (!r.find("KEYB", 0, &version)) return true;
+            if (!r.get(kb_state->kb_key_strobe) || !r.get_string(kb_state->paste_buffer)
+                || (version >= 2 && !r.get(kb_state->akd))) {
+                fprintf(stderr, "Snapshot: bad keyboard state\n");
+                return false;
+            }
+            return true;
+        });
+}
+
 void init_mb_iiplus_keyboard(computer_t *computer, SlotType_t slot) {
     if (DEBUG(DEBUG_KEYBOARD)) fprintf(stdout, "init_keyboard\n");
     keyboard_state_t *kb_state = new keyboard_state_t;
+    kb_state->cpu = computer->cpu;
     computer->set_module_state(MODULE_KEYBOARD, kb_state);
 
     /** Sather P31: 'The keyboard read addres sis $C00X and the strobe flip-flop reset address is $C01X. */
@@ -176,14 +226,22 @@ void init_mb_iiplus_keyboard(computer_t *computer, SlotType_t slot) {
         computer->mmu->set_C0XX_write_handler(0xC010+i, { kb_write_C01X, kb_state });
     }
 
-    computer->dispatch->registerHandler(SDL_EVENT_KEY_DOWN, [kb_state](const SDL_Event &event) {
+    computer->dispatch->registerHandler(SDL_EVENT_KEY_DOWN, [computer, kb_state](const SDL_Event &event) {
+        if (computer->input_log->is_replaying()) return false; // keys come from the recording
         if (event.key.key == SDLK_INSERT && event.key.mod & SDL_KMOD_SHIFT) {
             handle_paste(kb_state,event);
+            computer->input_log->record(computer->cpu->cycles, INPUT_PASTE, 0, kb_state->paste_buffer);
             return true;
         }
+        uint8_t strobe = kb_state->kb_key_strobe;
         handle_keydown_iiplus(event, kb_state);
+        if (kb_state->kb_key_strobe != strobe) {
+            computer->input_log->record(computer->cpu->cycles, INPUT_KEY, kb_state->kb_key_strobe & 0x7F);
+        }
         return false;
     });
+
+    kb_register_state_handlers(computer, kb_state);
 }
 
 void handle_keydown_iie(const SDL_Event &event, keyboard_state_t *kb_state) {
@@ -226,6 +284,7 @@ void handle_keydown_iie(const SDL_Event &event, keyboard_state_t *kb_state) {
 void init_mb_iie_keyboard(computer_t *computer, SlotType_t slot) {
     if (DEBUG(DEBUG_KEYBOARD)) fprintf(stdout, "init_keyboard\n");
     keyboard_state_t *kb_state = new keyboard_state_t;
+    kb_state->cpu = computer->cpu;
     computer->set_module_state(MODULE_KEYBOARD, kb_state);
 
     /** Sather P31: 'The keyboard read addres sis $C00X and the strobe flip-flop reset address is $C01X. */
@@ -243,12 +302,24 @@ void init_mb_iie_keyboard(computer_t *computer, SlotType_t slot) {
     }
     computer->mmu->set_C0XX_read_handler(0xC010, { kb_read_C010, kb_state });
 
-    computer->dispatch->registerHandler(SDL_EVENT_KEY_DOWN, [kb_state](const SDL_Event &event) {
+    computer->dispatch->registerHandler(SDL_EVENT_KEY_DOWN, [computer, kb_state](const SDL_Event &event) {
+        if (computer->input_log->is_replaying()) return false; // keys come from the recording
+        kb_update_akd(computer, kb_state);
         if (event.key.key == SDLK_INSERT && event.key.mod & SDL_KMOD_SHIFT) {
             handle_paste(kb_state,event);
+            computer->input_log->record(computer->cpu->cycles, INPUT_PASTE, 0, kb_state->paste_buffer);
             return true;
         }
+        uint8_t strobe = kb_state->kb_key_strobe;
         handle_keydown_iie(event, kb_state);
+        if (kb_state->kb_key_strobe != strobe) {
+            computer->input_log->record(computer->cpu->cycles, INPUT_KEY, kb_state->kb_key_strobe & 0x7F);
+        }
+        return false;
+    });
+    computer->dispatch->registerHandler(SDL_EVENT_KEY_UP, [computer, kb_state](const SDL_Event &event) {
+        if (computer->input_log->is_replaying()) return false;
+        kb_update_akd(computer, kb_state);
         return false;
     });
 
@@ -257,4 +328,6 @@ void init_mb_iie_keyboard(computer_t *computer, SlotType_t slot) {
     Message *msg = new KeyboardMessage(kb_state->mk);
     kb_state->mk->last_key_val = kb_state->kb_key_strobe;
     computer->mbus->send(msg);
+
+    kb_register_state_handlers(computer, kb_state);
 }
@@ -29,7 +29,9 @@
 struct keyboard_state_t {
     uint8_t kb_key_strobe = 0x41; 
     std::string paste_buffer;
+    bool akd = false;               // IIe any-key-down, as of the last key event
     message_keyboard_t *mk = nullptr;
+    cpu_state *cpu = nullptr;
 } ;
 
 /* uint8_t kb_memory_read(uint16_t address);
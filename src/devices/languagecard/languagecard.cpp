@@ -19,12 +19,15 @@
 #include "debug.hpp"
 
 #include "devices/languagecard/languagecard.hpp"
+#include "util/Snapshot.hpp"
 
 void set_memory_pages_based_on_flags(languagecard_state_t *lc) {
 
     uint8_t *bank = (lc->FF_BANK_1 == 1) ? lc->ram_bank : lc->ram_bank + 0x1000;
     const char *bank_d = (lc->FF_BANK_1 == 1) ? "LC_BANK1" : "LC_BANK2";
 
+    lc->cpu->counters.remaps++;
+
     for (int i = 0; i < 16; i++) {
         if (lc->FF_READ_ENABLE) {
             lc->mmu->map_page_read(i + 0xD0, bank + (i*GS2_PAGE_SIZE), bank_d);
@@ -45,7 +48,7 @@ void set_memory_pages_based_on_flags(languagecard_state_t *lc) {
             lc->mmu->map_page_read(i+0xE0, lc->ram_bank + 0x2000 + (i * GS2_PAGE_SIZE), "LC RAM");
 
         } else { // reads == READ_ROM
-            lc->mmu->map_page_read(i+0xE0, lc->mmu->get_rom_base() + 0x1000 + (i * GS2_PAGE_SIZE), "LC RAM");
+            lc->mmu->map_page_read(i+0xE0, lc->mmu->get_rom_base() + 0x1000 + (i * GS2_PAGE_SIZE), "SYS_ROM");
         }
 
         if (!lc->_FF_WRITE_ENABLE) {
@@ -205,6 +208,7 @@ void init_slot_languagecard(computer_t *computer, SlotType_t slot) {
 
     languagecard_state_t *lc = new languagecard_state_t();
     lc->mmu = computer->mmu;
+    lc->cpu = computer->cpu;
 
 /** At power up, the RAM card is disabled for reading and enabled for writing.
  * the pre-write flip-flop is reset, and bank 2 is selected. 
@@ -231,4 +235,24 @@ void init_slot_languagecard(computer_t *computer, SlotType_t slot) {
             reset_languagecard(lc);
             return true;
         });
+
+    computer->register_snapshot_handler(
+        [lc](SnapshotWriter &w) {
+            w.begin_chunk("LANG", 1);
+            w.put(lc->FF_BANK_1);
+            w.put(lc->FF_READ_ENABLE);
+            w.put(lc->FF_PRE_WRITE);
+            w.put(lc->_FF_WRITE_ENABLE);
+            w.put(lc->ram_bank, 0x4000);
+            w.end_chunk();
+        },
+        [lc](SnapshotReader &r) {
+            if (!r.find("LANG") || !r.get(lc->FF_BANK_1) || !r.get(lc->FF_READ_ENABLE) || !r.get(lc->FF_PRE_WRITE)
+                || !r.get(lc->_FF_WRITE_ENABLE) || !r.get(lc->ram_bank, 0x4000)) {
+                fprintf(stderr, "Snapshot: no language card state\n");
+                return false;
+            }
+            set_memory_pages_based_on_flags(lc);
+            return true;
+        });
 }
@@ -19,6 +19,7 @@
 #include "cpu.hpp"
 #include "memexp.hpp"
 #include "debug.hpp"
+#include "util/Snapshot.hpp"
 
 void memexp_write_C0x0(void *context, uint16_t addr, uint8_t data) {
     cpu_state *cpu = (cpu_state *)context;
@@ -123,6 +124,22 @@ void map_rom_memexp(void *context, SlotType_t slot) {
     }
 }
 
+/** The card's RAM and its address register. */
+void memexp_save_state(memexp_data *memexp_d, SnapshotWriter &w) {
+    w.begin_chunk("MEMX", 1, memexp_d->_slot);
+    w.put(memexp_d->addr);
+    w.put(memexp_d->data, MEMEXP_SIZE);
+    w.end_chunk();
+}
+
+bool memexp_restore_state(memexp_data *memexp_d, SnapshotReader &r) {
+    if (!r.find("MEMX", memexp_d->_slot) || !r.get(memexp_d->addr) || !r.get(memexp_d->data, MEMEXP_SIZE)) {
+        fprintf(stderr, "Snapshot: no memory expansion state for slot %d\n", memexp_d->_slot);
+        return false;
+    }
+    return true;
+}
+
 void init_slot_memexp(computer_t *computer, SlotType_t slot) {
     cpu_state *cpu = computer->cpu;
     
@@ -183,4 +200,8 @@ void init_slot_memexp(computer_t *computer, SlotType_t slot) {
  */
     /* register_C8xx_handler(cpu, slot, map_rom_memexp); */
     computer->mmu->set_C8xx_handler(slot, map_rom_memexp, memexp_d);
+
+    computer->register_snapshot_handler(
+        [memexp_d](SnapshotWriter &w) { memexp_save_state(memexp_d, w); },
+        [memexp_d](SnapshotReader &r) { return memexp_restore_state(memexp_d, r); });
 }
\ No newline at end of file
@@ -32,6 +32,8 @@
 #include "devices/speaker/speaker.hpp"
 #include "debug.hpp"
 #include "util/EventTimer.hpp"
+#include "util/Snapshot.hpp"
+#include "util/Timeline.hpp"
 
 enum AY_Registers {
     A_Tone_Low = 0,
@@ -165,6 +167,33 @@ public:
         }
     }
     
+    // Snapshot of both AY chips, the output filters and register writes not yet played.
+    void saveState(SnapshotWriter &w) {
+        w.put(chips);
+        w.put(filters);
+        w.put(current_time);
+        w.put(time_accumulator);
+        w.put(envelope_time_accumulator);
+        w.put(alpha);
+        w.put((uint32_t)pending_events.size());
+        for (const RegisterEvent& event : pending_events) {
+            w.put(event);
+        }
+    }
+
+    bool restoreState(SnapshotReader &r) {
+        uint32_t count;
+        if (!r.get(chips) || !r.get(filters) || !r.get(current_time) || !r.get(time_accumulator)
+            || !r.get(envelope_time_accumulator) || !r.get(alpha) || !r.get(count)) return false;
+        pending_events.clear();
+        for (uint32_t i = 0; i < count; i++) {
+            RegisterEvent event;
+            if (!r.get(event)) return false;
+            pending_events.push_back(event);
+        }
+        return true;
+    }
+
     // Set the audio buffer
     void setAudioBuffer(std::vector<float>* buffer) {
         audio_buffer = buffer;
@@ -1214,8 +1243,7 @@ uint8_t mb_read_Cx00(void *context, uint16_t addr) {
 }
 
 void generate_mockingboard_frame(mb_cpu_data *mb_d) {
-    static int frames = 0;
-
+    TIMELINE_SCOPE("generate_mockingboard_frame");
     // TODO: We need to calculate number of samples based on cycles. (Does the buffer management below handle this, or is this for some other reason?)
     int samples_per_frame = 735;
 
@@ -1237,18 +1265,27 @@ void generate_mockingboard_frame(mb_cpu_data *mb_d) {
 
     mb_d->mockingboard->generateSamples(samples_per_frame);
 
+    // turbo runs frames far faster than the audio device plays them. Keep the
+    // chips ticking but drop their output, and anything queued from before, so
+    // no backlog plays once we're back at speed.
+    cpu_state *cpu = mb_d->computer->cpu;
+    bool turbo = cpu->clock_mode == CLOCK_FREE_RUN && cpu->execution_mode == EXEC_NORMAL;
+    if (turbo && mb_d->stream) {
+        SDL_ClearAudioStream(mb_d->stream);
+    }
+
     // Clear the audio buffer after each frame to prevent memory buildup
     // Send the generated audio data to the SDL audio stream
     int abs = mb_d->audio_buffer.size();
-    if (abs > 0) {
+    if (abs > 0 && mb_d->stream && !turbo) {
         //printf("generate_mockingboard_frame: %zu\n", mb_d->audio_buffer.size());
         SDL_PutAudioStreamData(mb_d->stream, mb_d->audio_buffer.data(), mb_d->audio_buffer.size() * sizeof(float));
     }
     mb_d->audio_buffer.clear();
 
     if (DEBUG(DEBUG_MOCKINGBOARD)) {
-        if (frames++ > 60) {
-            frames = 0;
+        if (mb_d->status_frames++ > 60) {
+            mb_d->status_frames = 0;
             // Get the number of samples in SDL audio stream buffer
             int samples_in_buffer = 0;
             if (mb_d->stream) {
@@ -1261,6 +1298,7 @@ void generate_mockingboard_frame(mb_cpu_data *mb_d) {
 
 void insert_empty_mockingboard_frame(mb_cpu_data *mb_d) {
     const float empty_frame[736*2] = {0.0f};
+    if (!mb_d->stream) return;
     SDL_PutAudioStreamData(mb_d->stream, empty_frame, 736 * 2 * sizeof(float));
 }
 
@@ -1282,6 +1320,29 @@ void mb_reset(mb_cpu_data *mb_d) {
     mb_6522_propagate_interrupt(mb_d); // this reads the slot number and does the right IRQ thing.    
 }
 
+void mb_save_state(mb_cpu_data *mb_d, SnapshotWriter &w) {
+    w.begin_chunk("MOCK", 1, mb_d->slot);
+    w.put(mb_d->d_6522);
+    w.put(mb_d->last_cycle);
+    mb_d->mockingboard->saveState(w);
+    w.end_chunk();
+}
+
+bool mb_restore_state(mb_cpu_data *mb_d, SnapshotReader &r) {
+    if (!r.find("MOCK", mb_d->slot) || !r.get(mb_d->d_6522) || !r.get(mb_d->last_cycle)
+        || !mb_d->mockingboard->restoreState(r)) {
+        fprintf(stderr, "Snapshot: no Mockingboard state for slot %d\n", mb_d->slot);
+        return false;
+    }
+    // timers that were running pick up at the cycle they were due.
+    for (uint64_t chip = 0; chip < 2; chip++) {
+        mb_d->event_timer->rearmEvent(0x10000000 | (mb_d->slot << 8) | chip, mb_t1_timer_callback, mb_d);
+        mb_d->event_timer->rearmEvent(0x10010000 | (mb_d->slot << 8) | chip, mb_t2_timer_callback, mb_d);
+    }
+    mb_6522_propagate_interrupt(mb_d);
+    return true;
+}
+
 void init_slot_mockingboard(computer_t *computer, SlotType_t slot) {
 
     uint16_t slot_base = 0xC080 + (slot * 0x10);
@@ -1323,11 +1384,14 @@ void init_slot_mockingboard(computer_t *computer, SlotType_t slot) {
     spec.format = SDL_AUDIO_F32LE;
     spec.channels = 2;
 
-    SDL_AudioStream *stream = SDL_CreateAudioStream(&spec, NULL);
-    if (!stream) {
-        printf("Couldn't create audio stream: %s", SDL_GetError());
-    } else if (!SDL_BindAudioStream(dev_id, stream)) {  /* once bound, it'll start playing when there is data available! */
-        printf("Failed to bind stream to device: %s", SDL_GetError());
+    SDL_AudioStream *stream = nullptr;
+    if (!computer->headless) { // headless: samples are still generated, then dropped.
+        stream = SDL_CreateAudioStream(&spec, NULL);
+        if (!stream) {
+            printf("Couldn't create audio stream: %s", SDL_GetError());
+        } else if (!SDL_BindAudioStream(dev_id, stream)) {  /* once bound, it'll start playing when there is data available! */
+            printf("Failed to bind stream to device: %s", SDL_GetError());
+        }
     }
     mb_d->stream = stream;
 
@@ -1344,6 +1408,10 @@ void init_slot_mockingboard(computer_t *computer, SlotType_t slot) {
             return true;
         });
 
+    computer->register_snapshot_handler(
+        [mb_d](SnapshotWriter &w) { mb_save_state(mb_d, w); },
+        [mb_d](SnapshotReader &r) { return mb_restore_state(mb_d, r); });
+
     // register a frame processor for the mockingboard.
     computer->device_frame_dispatcher->registerHandler([mb_d]() {
         generate_mockingboard_frame(mb_d);
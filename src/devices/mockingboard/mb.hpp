@@ -105,6 +105,7 @@ struct mb_cpu_data: public SlotData {
     std::vector<float> audio_buffer;
     SDL_AudioStream *stream;
     uint64_t last_cycle;
+    int status_frames = 0;
     uint8_t slot;
     EventTimer *event_timer;
 };
@@ -2,6 +2,7 @@
 #include "cpu.hpp"
 #include "debug.hpp"
 #include "parallel.hpp"
+#include "util/Snapshot.hpp"
 
 void parallel_write_C0x0(void *context, uint16_t addr, uint8_t data) {
     cpu_state *cpu = (cpu_state *)context;
@@ -10,6 +11,7 @@ void parallel_write_C0x0(void *context, uint16_t addr, uint8_t data) {
     if (DEBUG(DEBUG_PARALLEL)) {
         printf("parallel_write_C0x0 %x\n", data);
     }
+    if (cpu->speculative || cpu->replaying) return;
 
     if (parallel_d->output == nullptr) {
         parallel_d->output = fopen("parallel.out", "a");
@@ -67,4 +69,18 @@ void init_slot_parallel(computer_t *computer, SlotType_t slot) {
             parallel_reset(cpu);
             return true;
         });
+
+    // nothing the guest can read back; the empty chunk says the card was there.
+    computer->register_snapshot_handler(
+        [parallel_d](SnapshotWriter &w) {
+            w.begin_chunk("PARL", 1, parallel_d->_slot);
+            w.end_chunk();
+        },
+        [parallel_d](SnapshotReader &r) {
+            if (!r.find("PARL", parallel_d->_slot)) {
+                fprintf(stderr, "Snapshot: no parallel card in slot %d\n", parallel_d->_slot);
+                return false;
+            }
+            return true;
+        });
 }
\ No newline at end of file
@@ -17,6 +17,7 @@
 
 //#include <stdio.h>
 #include <iostream>
+#include <cstring>
 #include "gs2.hpp"
 #include "cpu.hpp"
 #include "debug.hpp"
@@ -24,6 +25,7 @@
 #include "util/media.hpp"
 #include "util/ResourceFile.hpp"
 #include "util/mount.hpp"
+#include "util/Snapshot.hpp"
 
 void pdblock2_print_cmdbuffer(pdblock_cmd_buffer *pdb) {
     std::cout << "PD_CMD_BUFFER: ";
@@ -67,7 +69,7 @@ drive_status_t pdblock2_osd_status(cpu_state *cpu, uint64_t key) {
 
 uint8_t pdblock2_status(cpu_state *cpu, pdblock2_data *pdblock_d, uint8_t slot, uint8_t drive) {
     
-    if (pdblock_d->prodosblockdevices[slot][drive].file == nullptr) {
+    if (pdblock_d->prodosblockdevices[slot][drive].store == nullptr) {
         return 0x01; // device not ready
     }
     return 0x00; // device ready
@@ -75,57 +77,92 @@ uint8_t pdblock2_status(cpu_state *cpu, pdblock2_data *pdblock_d, uint8_t slot,
 
 /**
  * These two routines read and write a block to the media.
- * They take into account the media descriptor and the data offset.
- * They read and write memory to the cpu using the memory functions
- * that take into account the memory map, so, we can write data into
- * any bank selected as the CPU (or a 'DMA' device like us) would see it.
+ * Blocks come from the drive's BlockStore. For flat images that is a
+ * memory-mapped file behind a write-back BlockCache, so neither routine waits
+ * on the host disk: reads come from the cache or the mapping, and writes are
+ * parked in the cache until its background thread flushes them. Chunked
+ * (.gsc) images decompress on demand into an LRU of chunks.
+ * Data moves to and from the CPU address space with the MMU's DMA routines.
+ * Those honor the current memory map (so we write into whatever bank is
+ * selected, as the CPU would see it) but, like a real DMA device, don't tick cycles.
  * slot and drive here might be virtual as one physical slot can map drives
  * to a different virtual slot.
  */
-void pdblock2_read_block(cpu_state *cpu, pdblock2_data *pdblock_d, uint8_t slot, uint8_t drive, uint16_t block, uint16_t addr) {
-
-    // TODO: read the block into the address.
-    static uint8_t block_buffer[512];
-    FILE *fp = pdblock_d->prodosblockdevices[slot][drive].file;
-    
-    media_descriptor *media = pdblock_d->prodosblockdevices[slot][drive].media;
-
-    fseek(fp, media->data_offset + (block * media->block_size), SEEK_SET);
-    fread(block_buffer, 1, media->block_size, fp);
-    for (int i = 0; i < media->block_size; i++) {
-        // TODO: for dma we want to simulate the memory map but do not want to burn cycles.
-        // the CPU would halt during a DMA and not tick cycles even though the rest of the bus
-        // is following the system clock.
-        // TODO: So we need a dma_write_memory and dma_read_memory set of routines that do that.
-        //write_memory(cpu, addr + i, block_buffer[i]); 
-        cpu->mmu->write(addr + i, block_buffer[i]); 
+uint8_t pdblock2_read_block(cpu_state *cpu, pdblock2_data *pdblock_d, uint8_t slot, uint8_t drive, uint16_t block, uint16_t addr) {
+
+    uint8_t block_buffer[512];
+    media_t *dev = &pdblock_d->prodosblockdevices[slot][drive];
+    media_descriptor *media = dev->media;
+
+    // copy out under the cache lock, DMA after; the DMA may hit I/O handlers.
+    bool ok = dev->store->read_block(block, [&](const uint8_t *data) {
+        memcpy(block_buffer, data, media->block_size);
+    });
+    if (!ok) {
+        return PD_ERROR_IO;
     }
-    pdblock_d->prodosblockdevices[slot][drive].last_block_accessed = block;
-    pdblock_d->prodosblockdevices[slot][drive].last_block_access_time = SDL_GetTicksNS();
+    cpu->mmu->dma_write(addr, block_buffer, media->block_size);
+
+    dev->last_block_accessed = block;
+    dev->last_block_access_time = SDL_GetTicksNS();
     //debug_dump_memory(cpu, addr, addr + media[slot][drive].block_size);
+    return PD_ERROR_NONE;
 }
 
-void pdblock2_write_block(cpu_state *cpu, pdblock2_data *pdblock_d, uint8_t slot, uint8_t drive, uint16_t block, uint16_t addr) {
+uint8_t pdblock2_write_block(cpu_state *cpu, pdblock2_data *pdblock_d, uint8_t slot, uint8_t drive, uint16_t block, uint16_t addr) {
 
-    // TODO: read the block into the address.
-    static uint8_t block_buffer[512];
-    FILE *fp = pdblock_d->prodosblockdevices[slot][drive].file;
-    media_descriptor *media = pdblock_d->prodosblockdevices[slot][drive].media;
+    uint8_t block_buffer[512];
+    media_t *dev = &pdblock_d->prodosblockdevices[slot][drive];
+    media_descriptor *media = dev->media;
 
-    if (media->write_protected) {
-        pdblock_d->cmd_buffer.error = PD_ERROR_WRITE_PROTECTED;
-        return;
+    if (media->write_protected || dev->store->is_read_only()) {
+        return PD_ERROR_WRITE_PROTECTED;
+    }
+    // run-ahead frames are thrown away; their writes mustn't reach the image. Tell the guest it worked.
+    if (cpu->speculative) {
+        return PD_ERROR_NONE;
     }
 
-    for (int i = 0; i < media->block_size; i++) {
-        // TODO: for dma we want to simulate the memory map but do not want to burn cycles.
-        //block_buffer[i] = read_memory(cpu, addr + i); 
-        block_buffer[i] = cpu->mmu->read(addr + i); 
+    /*
+     * While someone holds snapshots they may restore, keep the old contents so
+     * the restore can roll this write back, and only as far back as the
+     * oldest of them. With none held, no restore can need it.
+     */
+    computer_t *computer = pdblock_d->computer;
+    bool journal = computer->history_held();
+    pd_journal_entry_t entry;
+    if (journal) {
+        entry.cycle = cpu->cycles;
+        entry.slot = slot;
+        entry.drive = drive;
+        entry.block = block;
+        bool ok = dev->store->read_block(block, [&](const uint8_t *data) {
+            memcpy(entry.data, data, media->block_size);
+        });
+        if (!ok) {
+            return PD_ERROR_IO;
+        }
+    }
+
+    cpu->mmu->dma_read(addr, block_buffer, media->block_size);
+    if (!dev->store->write_block(block, block_buffer)) {
+        return PD_ERROR_IO;
+    }
+
+    pdblock_d->journal_seq++;
+    if (journal) {
+        uint64_t floor = computer->history_floor();
+        while (!pdblock_d->journal.empty() && pdblock_d->journal.front().cycle < floor) {
+            pdblock_d->journal.pop_front();
+        }
+        pdblock_d->journal.push_back(entry);
+    } else {
+        pdblock_d->journal.clear();
     }
-    fseek(fp, media->data_offset + (block * media->block_size), SEEK_SET);
-    fwrite(block_buffer, 1, media->block_size, fp);
-    pdblock_d->prodosblockdevices[slot][drive].last_block_accessed = block;
-    pdblock_d->prodosblockdevices[slot][drive].last_block_access_time = SDL_GetTicksNS();
+
+    dev->last_block_accessed = block;
+    dev->last_block_access_time = SDL_GetTicksNS();
+    return PD_ERROR_NONE;
 }
 
 void pdblock2_execute(cpu_state *cpu, pdblock2_data *pdblock_d) {
@@ -178,13 +215,11 @@ void pdblock2_execute(cpu_state *cpu, pdblock2_data *pdblock_d) {
         pdblock_d->cmd_buffer.status1 = media->block_count & 0xFF;
         pdblock_d->cmd_buffer.status2 = (media->block_count >> 8) & 0xFF;
     } else if (cmd == 0x01) {
-        pdblock2_read_block(cpu, pdblock_d, slot, drive, block, addr);
-        pdblock_d->cmd_buffer.error = 0x00;
+        pdblock_d->cmd_buffer.error = pdblock2_read_block(cpu, pdblock_d, slot, drive, block, addr);
         pdblock_d->cmd_buffer.status1 = 0x00;
         pdblock_d->cmd_buffer.status2 = 0x00;
     } else if (cmd == 0x02) {
-        pdblock2_write_block(cpu, pdblock_d, slot, drive, block, addr);
-        pdblock_d->cmd_buffer.error = 0x00;
+        pdblock_d->cmd_buffer.error = pdblock2_write_block(cpu, pdblock_d, slot, drive, block, addr);
         pdblock_d->cmd_buffer.status1 = 0x00;
         pdblock_d->cmd_buffer.status2 = 0x00;
     } else if (cmd == 0x03) { // not implemented
@@ -201,14 +236,37 @@ bool mount_pdblock2(cpu_state *cpu, uint8_t slot, uint8_t drive, media_descripto
     //if (DEBUG(DEBUG_PD_BLOCK)) printf("Mounting ProDOS block device %s slot %d drive %d\n", media->filename, slot, drive);
     if (DEBUG(DEBUG_PD_BLOCK)) std::cout << "Mounting ProDOS block device " << media->filename << " slot " << slot << " drive " << drive << std::endl;
 
-    FILE *fp = fopen(media->filename.c_str(), "r+b");
-    if (fp == nullptr) {
-        //fprintf(stderr, "Could not open ProDOS block device file: %s\n", media->filename);
-        std::cerr << "Could not open ProDOS block device file: " << media->filename << std::endl;
+    if (media->block_size > 512) {
+        std::cerr << "Unsupported block size " << media->block_size << " in " << media->filename << std::endl;
         return false;
     }
-    pdblock_d->prodosblockdevices[slot][drive].file = fp;
+
+    MappedFile *image = nullptr;
+    BlockStore *store = nullptr;
+    if (media->container == CONTAINER_CHUNKED) {
+        ChunkedImage *chunked = new ChunkedImage();
+        if (!chunked->open(media->filename, media->write_protected)) {
+            std::cerr << "Could not open ProDOS block device file: " << media->filename << std::endl;
+            delete chunked;
+            return false;
+        }
+        store = chunked;
+    } else {
+        image = new MappedFile();
+        if (!image->open(media->filename, media->write_protected)) {
+            //fprintf(stderr, "Could not open ProDOS block device file: %s\n", media->filename);
+            std::cerr << "Could not open ProDOS block device file: " << media->filename << std::endl;
+            delete image;
+            return false;
+        }
+        BlockCache *cache = new BlockCache(image, media->data_offset, media->block_size);
+        cache->open();
+        store = cache;
+    }
+    pdblock_d->prodosblockdevices[slot][drive].image = image;
+    pdblock_d->prodosblockdevices[slot][drive].store = store;
     pdblock_d->prodosblockdevices[slot][drive].media = media;
+    pdblock_d->journal.clear(); // snapshots from before the mount can't be rolled back to
     return true;
 }
 
@@ -216,10 +274,22 @@ void unmount_pdblock2(cpu_state *cpu, uint64_t key) {
     uint8_t slot = key >> 8;
     uint8_t drive = key & 0xFF;
     pdblock2_data * pdblock_d = (pdblock2_data *)get_slot_state(cpu, (SlotType_t)slot);
-    if (pdblock_d->prodosblockdevices[slot][drive].file) {
-        fclose(pdblock_d->prodosblockdevices[slot][drive].file);
-        pdblock_d->prodosblockdevices[slot][drive].file = nullptr;
+    if (pdblock_d->prodosblockdevices[slot][drive].store) {
+        delete pdblock_d->prodosblockdevices[slot][drive].store; // writes back anything still dirty
+        delete pdblock_d->prodosblockdevices[slot][drive].image; // flushes and unmaps
+        pdblock_d->prodosblockdevices[slot][drive].store = nullptr;
+        pdblock_d->prodosblockdevices[slot][drive].image = nullptr;
         pdblock_d->prodosblockdevices[slot][drive].media = nullptr;
+        pdblock_d->journal.clear();
+    }
+}
+
+void flush_pdblock2(cpu_state *cpu, uint64_t key) {
+    uint8_t slot = key >> 8;
+    uint8_t drive = key & 0xFF;
+    pdblock2_data * pdblock_d = (pdblock2_data *)get_slot_state(cpu, (SlotType_t)slot);
+    if (pdblock_d && pdblock_d->prodosblockdevices[slot][drive].store) {
+        pdblock_d->prodosblockdevices[slot][drive].store->flush();
     }
 }
 
@@ -265,6 +335,53 @@ uint8_t pdblock2_read_C0x0(void *context, uint16_t addr) {
     } else return 0xE0;
 }
 
+/**
+ * The command being put together and the last command's results. What's on
+ * the mounted media lives in the image files, not here; the chunk records
+ * how many blocks had been written, and restore rolls later writes back
+ * out of the journal. A snapshot from another session leaves the media alone.
+ */
+void pdblock2_save_state(pdblock2_data *pdblock_d, SnapshotWriter &w) {
+    w.begin_chunk("PDB2", 2, pdblock_d->_slot);
+    w.put(pdblock_d->cmd_buffer);
+    w.put(pdblock_d->journal_epoch);
+    w.put(pdblock_d->journal_seq);
+    w.end_chunk();
+}
+
+bool pdblock2_rollback(pdblock2_data *pdblock_d, uint64_t seq) {
+    if (seq > pdblock_d->journal_seq || pdblock_d->journal_seq - seq > pdblock_d->journal.size()) {
+        fprintf(stderr, "Snapshot: block device history in slot %d doesn't reach back that far\n", pdblock_d->_slot);
+        return false;
+    }
+    while (pdblock_d->journal_seq > seq) {
+        pd_journal_entry_t &entry = pdblock_d->journal.back();
+        media_t *dev = &pdblock_d->prodosblockdevices[entry.slot][entry.drive];
+        if (dev->store == nullptr || !dev->store->write_block(entry.block, entry.data)) {
+            fprintf(stderr, "Snapshot: couldn't roll back block %d in slot %d drive %d\n", entry.block, entry.slot, entry.drive + 1);
+            return false;
+        }
+        pdblock_d->journal.pop_back();
+        pdblock_d->journal_seq--;
+    }
+    return true;
+}
+
+bool pdblock2_restore_state(pdblock2_data *pdblock_d, SnapshotReader &r) {
+    uint16_t version = 0;
+    uint64_t epoch, seq;
+    if (!r.find("PDB2", pdblock_d->_slot, &version) || version != 2 || !r.get(pdblock_d->cmd_buffer) || pdblock_d->cmd_buffer.index > MAX_PD_BUFFER_SIZE
+        || !r.get(epoch) || !r.get(seq)) {
+        fprintf(stderr, "Snapshot: no ProDOS block device state for slot %d\n", pdblock_d->_slot);
+        return false;
+    }
+    if (epoch != pdblock_d->journal_epoch) {
+        pdblock_d->journal.clear(); // cycles start over from the snapshot's
+        return true;
+    }
+    return pdblock2_rollback(pdblock_d, seq);
+}
+
 void init_pdblock2(computer_t *computer, SlotType_t slot)
 {
     cpu_state *cpu = computer->cpu;
@@ -272,9 +389,12 @@ void init_pdblock2(computer_t *computer, SlotType_t slot)
     if (DEBUG(DEBUG_PD_BLOCK)) std::cout << "Initializing ProDOS Block2 slot " << slot << std::endl;
     pdblock2_data * pdblock_d = new pdblock2_data;
     pdblock_d->id = DEVICE_ID_PD_BLOCK2;
+    pdblock_d->computer = computer;
+    pdblock_d->journal_epoch = SDL_GetTicksNS() ^ (uint64_t)(uintptr_t)pdblock_d;
     for (int i = 0; i < 7; i++) {
         for (int j = 0; j < 2; j++) {
-            pdblock_d->prodosblockdevices[i][j].file = nullptr;
+            pdblock_d->prodosblockdevices[i][j].image = nullptr;
+            pdblock_d->prodosblockdevices[i][j].store = nullptr;
             pdblock_d->prodosblockdevices[i][j].media = nullptr;
         }
     }
@@ -314,4 +434,20 @@ void init_pdblock2(computer_t *computer, SlotType_t slot)
     register_C0xx_memory_read_handler((slot * 0x10) + PD_ERROR_GET, pdblock2_read_C0x0);
     register_C0xx_memory_read_handler((slot * 0x10) + PD_STATUS1_GET, pdblock2_read_C0x0);
     register_C0xx_memory_read_handler((slot * 0x10) + PD_STATUS2_GET, pdblock2_read_C0x0); */
+
+    computer->register_snapshot_handler(
+        [pdblock_d](SnapshotWriter &w) { pdblock2_save_state(pdblock_d, w); },
+        [pdblock_d](SnapshotReader &r) { return pdblock2_restore_state(pdblock_d, r); });
+
+    // make sure cached writes reach the host disk before we go away.
+    computer->register_shutdown_handler([pdblock_d]() {
+        for (int i = 0; i < 7; i++) {
+            for (int j = 0; j < 2; j++) {
+                media_t *dev = &pdblock_d->prodosblockdevices[i][j];
+                if (dev->store) dev->store->close();
+                if (dev->image) dev->image->close();
+            }
+        }
+        return true;
+    });
 }
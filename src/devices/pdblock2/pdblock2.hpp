@@ -17,10 +17,15 @@
 
 #pragma once
 
+#include <deque>
+
 #include "gs2.hpp"
 #include "cpu.hpp"
 #include "util/media.hpp"
 #include "util/mount.hpp"
+#include "util/MappedFile.hpp"
+#include "util/BlockCache.hpp"
+#include "util/ChunkedImage.hpp"
 #include "slots.hpp"
 #include "computer.hpp"
 
@@ -33,7 +38,8 @@
 #define PD_STATUS2_GET 0xC085
 
 typedef struct media_t {
-    FILE *file;
+    MappedFile *image;      // flat images only; chunked images own their file
+    BlockStore *store;
     media_descriptor *media;
     int last_block_accessed;
     uint64_t last_block_access_time;
@@ -59,10 +65,27 @@ struct pdblock_cmd_buffer {
     uint8_t status2;
 };
 
+/**
+ * What a block held before the guest overwrote it. Restoring an older
+ * snapshot plays these back, newest first, so the media matches the
+ * machine again.
+ */
+struct pd_journal_entry_t {
+    uint64_t cycle;         // when it was overwritten
+    uint8_t slot;
+    uint8_t drive;
+    uint16_t block;
+    uint8_t data[512];
+};
+
 struct pdblock2_data: public SlotData {
+    computer_t *computer;
     uint8_t *rom;
     pdblock_cmd_buffer cmd_buffer;
     media_t prodosblockdevices[7][2];
+    uint64_t journal_epoch;             // tells our snapshots from another session's
+    uint64_t journal_seq = 0;           // block writes so far; snapshots record it
+    std::deque<pd_journal_entry_t> journal; // writes journal_seq - size() .. journal_seq - 1, while history is held
 };
 
 enum pdblock_cmd {
@@ -88,4 +111,5 @@ void pdblock2_execute(cpu_state *cpu, pdblock2_data *pdblock_d);
 void init_pdblock2(computer_t *computer, SlotType_t slot);
 bool mount_pdblock2(cpu_state *cpu, uint8_t slot, uint8_t drive, media_descriptor *media);
 void unmount_pdblock2(cpu_state *cpu, uint64_t key);
+void flush_pdblock2(cpu_state *cpu, uint64_t key);
 drive_status_t pdblock2_osd_status(cpu_state *cpu, uint64_t key);
@@ -22,10 +22,11 @@
 #include "debug.hpp"
 #include "devices/prodos_block/prodos_block.hpp"
 #include "util/media.hpp"
+#include "util/MappedFile.hpp"
 #include "pd_block_firmware.hpp"
 
 typedef struct media_t {
-    FILE *file;
+    MappedFile *image;
     media_descriptor *media;
 /*     uint16_t block_size;
     uint16_t block_count;
@@ -44,7 +45,7 @@ void pv_return(cpu_state *cpu) {
 }
 
 uint8_t status(cpu_state *cpu, uint8_t slot, uint8_t drive) {
-    if (prodosblockdevices[slot][drive].file == nullptr) {
+    if (prodosblockdevices[slot][drive].image == nullptr) {
         return 0x01; // device not ready
     }
     return 0x00; // device ready
@@ -53,41 +54,29 @@ uint8_t status(cpu_state *cpu, uint8_t slot, uint8_t drive) {
 /**
  * These two routines read and write a block to the media.
  * They take into account the media descriptor and the data offset.
- * They read and write memory to the cpu using the memory functions
- * that take into account the memory map, so, we can write data into
- * any bank selected as the CPU (or a 'DMA' device like us) would see it.
+ * The image is memory-mapped and blocks are moved with the MMU DMA routines,
+ * which honor the memory map (so we can write data into any bank selected
+ * as the CPU would see it) without ticking CPU cycles.
  */
 void read_block(cpu_state *cpu, uint8_t slot, uint8_t drive, uint16_t block, uint16_t addr) {
-    // TODO: read the block into the address.
-    static uint8_t block_buffer[512];
-    FILE *fp = prodosblockdevices[slot][drive].file;
-    
+    MappedFile *image = prodosblockdevices[slot][drive].image;
     media_descriptor *media = prodosblockdevices[slot][drive].media;
 
-    fseek(fp, media->data_offset + (block * media->block_size), SEEK_SET);
-    fread(block_buffer, 1, media->block_size, fp);
-    for (int i = 0; i < media->block_size; i++) {
-        // TODO: for dma we want to simulate the memory map but do not want to burn cycles.
-        // the CPU would halt during a DMA and not tick cycles even though the rest of the bus
-        // is following the system clock.
-        // TODO: So we need a dma_write_memory and dma_read_memory set of routines that do that.
-        write_memory(cpu, addr + i, block_buffer[i]); 
-    }
+    size_t offset = media->data_offset + ((size_t)block * media->block_size);
+    if (offset + media->block_size > image->size()) return;
+    cpu->mmu->dma_write(addr, image->data() + offset, media->block_size);
     //debug_dump_memory(cpu, addr, addr + media[slot][drive].block_size);
 }
 
 void write_block(cpu_state *cpu, uint8_t slot, uint8_t drive, uint16_t block, uint16_t addr) {
-    // TODO: read the block into the address.
-    static uint8_t block_buffer[512];
-    FILE *fp = prodosblockdevices[slot][drive].file;
+    MappedFile *image = prodosblockdevices[slot][drive].image;
     media_descriptor *media = prodosblockdevices[slot][drive].media;
-    
-    for (int i = 0; i < media->block_size; i++) {
-        // TODO: for dma we want to simulate the memory map but do not want to burn cycles.
-        block_buffer[i] = read_memory(cpu, addr + i); 
-    }
-    fseek(fp, media->data_offset + (block * media->block_size), SEEK_SET);
-    fwrite(block_buffer, 1, media->block_size, fp);
+
+    size_t offset = media->data_offset + ((size_t)block * media->block_size);
+    if (image->is_read_only() || offset + media->block_size > image->size()) return;
+    cpu->mmu->dma_read(addr, image->data() + offset, media->block_size);
+    image->mark_dirty(offset, media->block_size);
+    image->flush_async();
 
     //debug_dump_memory(cpu, addr, addr + media[slot][drive].block_size);
 }
@@ -143,13 +132,14 @@ void mount_prodos_block(cpu_state *cpu, uint8_t slot, uint8_t drive, media_descr
     //printf("Mounting ProDOS block device %s slot %d drive %d\n", media->filename, slot, drive);
     //std::cout << std::format("Mounting ProDOS block device {} slot {} drive {}\n", media->filename, slot, drive) << std::endl;
     std::cout << "Mounting ProDOS block device " << media->filename << " slot " << slot << " drive " << drive << std::endl;
-    FILE *fp = fopen(media->filename.c_str(), "r+b");
-    if (fp == nullptr) {
+    MappedFile *image = new MappedFile();
+    if (!image->open(media->filename, media->write_protected)) {
         //fprintf(stderr, "Could not open ProDOS block device file: %s\n", media->filename);
         std::cerr << "Could not open ProDOS block device file: " << media->filename << std::endl;
+        delete image;
         return;
     }
-    prodosblockdevices[slot][drive].file = fp;
+    prodosblockdevices[slot][drive].image = image;
     prodosblockdevices[slot][drive].media = media;
 }
 
@@ -26,6 +26,7 @@
 #include "prodos_clock.hpp"
 
 #include "util/ResourceFile.hpp"
+#include "util/Snapshot.hpp"
 
 
 /**
@@ -77,7 +78,8 @@ foo:
 
 void prodos_clock_getln_handler(cpu_state *cpu, char *buf) {
     time_t now = time(nullptr);
-    struct tm *tm = localtime(&now);
+    struct tm tm_now;
+    struct tm *tm = localtime_r(&now, &tm_now);
 
     snprintf(buf, 255, "%02d,%02d,%02d,%02d,%02d\r", tm->tm_mon + 1, tm->tm_wday, tm->tm_mday, tm->tm_hour, tm->tm_min);
     for (int i = 0; buf[i] != '\0'; i++) {
@@ -126,4 +128,17 @@ void init_slot_prodosclock(computer_t *computer, SlotType_t slot) {
     computer->mmu->set_slot_rom(slot, rom_data, "PDCLK_ROM");
     computer->mmu->set_C0XX_write_handler(0xC000 + slx, { prodos_clock_write_register, cpu });
 
+    // the time goes straight into guest memory, so there's nothing to keep; the chunk says the card was there.
+    computer->register_snapshot_handler(
+        [prodosclock_d](SnapshotWriter &w) {
+            w.begin_chunk("PCLK", 1, prodosclock_d->_slot);
+            w.end_chunk();
+        },
+        [prodosclock_d](SnapshotReader &r) {
+            if (!r.find("PCLK", prodosclock_d->_slot)) {
+                fprintf(stderr, "Snapshot: no ProDOS clock in slot %d\n", prodosclock_d->_slot);
+                return false;
+            }
+            return true;
+        });
 }
@@ -25,6 +25,7 @@
 #include "debug.hpp"
 #include "devices/speaker/speaker.hpp"
 #include "devices/speaker/LowPass.hpp"
+#include "util/Timeline.hpp"
 
 /**
  * Each audio frame is for 17000 samples per frame (1020500 samples/second, 1/60th second)
@@ -45,6 +46,7 @@
 
 
 uint64_t audio_generate_frame(cpu_state *cpu, uint64_t cycle_window_start, uint64_t cycle_window_end) {
+    TIMELINE_SCOPE("audio_generate_frame");
     speaker_state_t *speaker_state = (speaker_state_t *)get_module_state(cpu,MODULE_SPEAKER);
     int16_t *working_buffer = speaker_state->working_buffer;
     EventBuffer *event_buffer = &speaker_state->event_buffer;
@@ -60,6 +62,12 @@ uint64_t audio_generate_frame(cpu_state *cpu, uint64_t cycle_window_start, uint6
         return SAMPLES_PER_FRAME*2;
     }
 
+    // toggles are sampled once per CPU cycle, so the pre-filter has to follow the clock rate.
+    if (cpu->clock_mode != CLOCK_FREE_RUN && speaker_state->preFilter_rate != cpu->HZ_RATE) {
+        speaker_state->preFilter->setCoefficients(8000.0f, (double)cpu->HZ_RATE);
+        speaker_state->preFilter_rate = cpu->HZ_RATE;
+    }
+
     uint64_t queued_samples = SDL_GetAudioStreamQueued(speaker_state->stream);
     if (queued_samples < SAMPLES_PER_FRAME) { printf("queue underrun %llu %f %f\n", queued_samples, speaker_state->amplitude, speaker_state->polarity); 
         // attempt to calculate how much time slipped and generate that many samples
@@ -130,7 +138,33 @@ uint64_t audio_generate_frame(cpu_state *cpu, uint64_t cycle_window_start, uint6
     return samples_count;
 }
 
+/**
+ * Throw away queued speaker toggles, when the machine has jumped to another
+ * point in time and they'll never be reached.
+ */
+void speaker_flush_events(cpu_state *cpu) {
+    speaker_state_t *speaker_state = (speaker_state_t *)cpu->module_store[MODULE_SPEAKER];
+    if (speaker_state == nullptr) return;
+    EventBuffer *event_buffer = &speaker_state->event_buffer;
+    event_buffer->read_pos = event_buffer->write_pos;
+    event_buffer->count = 0;
+}
+
+/**
+ * Samples queued for the audio device and not yet played, or -1 if the
+ * speaker isn't playing (no device, or not started yet).
+ */
+int64_t speaker_queued_samples(cpu_state *cpu) {
+    speaker_state_t *speaker_state = (speaker_state_t *)cpu->module_store[MODULE_SPEAKER];
+    if (speaker_state == nullptr || speaker_state->stream == nullptr || !speaker_state->device_started) return -1;
+    int queued = SDL_GetAudioStreamQueued(speaker_state->stream);
+    if (queued < 0) return -1;
+    return queued / (int)sizeof(int16_t);
+}
+
 inline void log_speaker_blip(cpu_state *cpu) {
+    if (cpu->speculative || cpu->replaying) return; // audio only comes from the committed timeline
+
     speaker_state_t *speaker_state = (speaker_state_t *)get_module_state(cpu, MODULE_SPEAKER);
     EventBuffer *event_buffer = &speaker_state->event_buffer;
 
@@ -194,34 +228,41 @@ void init_mb_speaker(computer_t *computer,  SlotType_t slot) {
 
     set_module_state(cpu, MODULE_SPEAKER, speaker_state);
 
-	// Initialize SDL audio - is this right, to do this again here?
-	SDL_Init(SDL_INIT_AUDIO);
-	
-    SDL_AudioSpec desired = {};
-    desired.freq = SAMPLE_RATE;
-    desired.format = SDL_AUDIO_S16LE;
-    desired.channels = 1;
-
-    speaker_state->device_id = SDL_OpenAudioDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, NULL);
-    if (speaker_state->device_id == 0) {
-        SDL_Log("Couldn't open audio device: %s", SDL_GetError());
-        return;
-    }
+    if (computer->headless) {
+        // no audio device. Clicks are still logged, and dropped once the event buffer fills.
+        speaker_state->device_id = 0;
+        speaker_state->stream = nullptr;
+        speaker_state->device_started = 1;
+    } else {
+        // Initialize SDL audio - is this right, to do this again here?
+        SDL_Init(SDL_INIT_AUDIO);
+
+        SDL_AudioSpec desired = {};
+        desired.freq = SAMPLE_RATE;
+        desired.format = SDL_AUDIO_S16LE;
+        desired.channels = 1;
+
+        speaker_state->device_id = SDL_OpenAudioDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, NULL);
+        if (speaker_state->device_id == 0) {
+            SDL_Log("Couldn't open audio device: %s", SDL_GetError());
+            return;
+        }
 
-    speaker_state->stream = SDL_CreateAudioStream(&desired, NULL);
-    if (!speaker_state->stream) {
-        SDL_Log("Couldn't create audio stream: %s", SDL_GetError());
-        return;
-    } else if (!SDL_BindAudioStream(speaker_state->device_id, speaker_state->stream)) {  /* once bound, it'll start playing when there is data available! */
-        SDL_Log("Failed to bind speaker stream to device: %s", SDL_GetError());
-        return;
-    }
+        speaker_state->stream = SDL_CreateAudioStream(&desired, NULL);
+        if (!speaker_state->stream) {
+            SDL_Log("Couldn't create audio stream: %s", SDL_GetError());
+            return;
+        } else if (!SDL_BindAudioStream(speaker_state->device_id, speaker_state->stream)) {  /* once bound, it'll start playing when there is data available! */
+            SDL_Log("Failed to bind speaker stream to device: %s", SDL_GetError());
+            return;
+        }
 
-    SDL_PauseAudioDevice(speaker_state->device_id);
+        SDL_PauseAudioDevice(speaker_state->device_id);
 
-    // prime the pump with a few frames of silence.
-    memset(speaker_state->working_buffer, 0, SAMPLES_PER_FRAME * sizeof(int16_t));
-    SDL_PutAudioStreamData(speaker_state->stream, speaker_state->working_buffer, SAMPLES_PER_FRAME*sizeof(int16_t));
+        // prime the pump with a few frames of silence.
+        memset(speaker_state->working_buffer, 0, SAMPLES_PER_FRAME * sizeof(int16_t));
+        SDL_PutAudioStreamData(speaker_state->stream, speaker_state->working_buffer, SAMPLES_PER_FRAME*sizeof(int16_t));
+    }
 
     if (DEBUG(DEBUG_SPEAKER)) fprintf(stdout, "init_speaker\n");
     for (uint16_t addr = 0xC030; addr <= 0xC03F; addr++) {
@@ -230,11 +271,12 @@ void init_mb_speaker(computer_t *computer,  SlotType_t slot) {
     }
     speaker_state->preFilter = new LowPassFilter();
     speaker_state->preFilter->setCoefficients(8000.0f, (double)1020500); // 1020500 is actual possible sample rate of input toggles.
+    speaker_state->preFilter_rate = cpu->HZ_RATE;
     speaker_state->postFilter = new LowPassFilter();
     speaker_state->postFilter->setCoefficients(8000.0f, (double)SAMPLE_RATE);
 
     computer->register_shutdown_handler([speaker_state, cpu]() {
-        speaker_stop(cpu);
+        if (speaker_state->stream) speaker_stop(cpu);
         SDL_DestroyAudioStream(speaker_state->stream);
         //SDL_CloseAudioDevice(speaker_state->device_id);
         //SDL_QuitSubSystem(SDL_INIT_AUDIO);
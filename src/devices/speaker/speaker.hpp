@@ -81,6 +81,7 @@ typedef struct speaker_state_t {
     double amplitude = AMPLITUDE_PEAK; // suggested 50%
 
     LowPassFilter *preFilter;
+    uint64_t preFilter_rate = 0;    // CPU clock the pre-filter is tuned for
     LowPassFilter *postFilter;
 
     int16_t working_buffer[SAMPLE_BUFFER_SIZE];
@@ -93,5 +94,7 @@ void dump_full_speaker_event_log();
 void dump_partial_speaker_event_log(uint64_t cycles_now);
 void speaker_start(cpu_state *cpu);
 void speaker_stop();
+void speaker_flush_events(cpu_state *cpu);
+int64_t speaker_queued_samples(cpu_state *cpu);
 //void audio_generate_frame(cpu_state *cpu);
 uint64_t audio_generate_frame(cpu_state *cpu, uint64_t last_cycle_window_start, uint64_t cycle_window_start);
\ No newline at end of file
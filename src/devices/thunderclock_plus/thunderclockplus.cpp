@@ -26,6 +26,7 @@
 #include "thunderclockplus.hpp"
 
 #include "util/ResourceFile.hpp"
+#include "util/Snapshot.hpp"
 
 /*
 
@@ -50,17 +51,12 @@ https://retrocomputing.stackexchange.com/questions/5512/is-the-apple-ii-no-slot-
 #define HZ256 256
 #define HZ1024 1024
 
-uint8_t thunderclock_command_register = 0;
-uint64_t thunderclock_time_register = 0;
-uint8_t thunderclock_interrupt_asserted = 0;
-uint8_t thunderblock_interrupt_rate = HZ64;
-
-
 // Returns 40 bits of time data in Thunderclock Plus format
 // the LSB of our 40-bit register is the LSB of the seconds-units field.
 uint64_t get_thunderclock_time() {
     time_t now = time(nullptr);
-    struct tm *tm = localtime(&now);
+    struct tm tm_now;
+    struct tm *tm = localtime_r(&now, &tm_now);
     
     // First collect nibbles in order
     uint8_t nibbles[10] = {
@@ -93,10 +89,10 @@ uint8_t thunderclock_read_register(void *context, uint16_t address) {
     uint8_t slot = (address - 0xC080) >> 4;
     thunderclock_state * thunderclock_d = (thunderclock_state *)get_slot_state(cpu, (SlotType_t)slot);
 
-    fprintf(stderr, "Thunderclock Plus read register %04X => %02X\n", address, thunderclock_command_register);
+    fprintf(stderr, "Thunderclock Plus read register %04X => %02X\n", address, thunderclock_d->command_register);
     
-    uint8_t bit = (thunderclock_time_register & 0x01) << 7;
-    uint8_t reg = thunderclock_command_register;
+    uint8_t bit = (thunderclock_d->time_register & 0x01) << 7;
+    uint8_t reg = thunderclock_d->command_register;
     reg = (reg & (~TCP_OUT)) | bit;
     return reg;
 }
@@ -107,21 +103,21 @@ void thunderclock_write_register(void *context, uint16_t address, uint8_t value)
     thunderclock_state * thunderclock_d = (thunderclock_state *)get_slot_state(cpu, (SlotType_t)slot);
     fprintf(stderr, "Thunderclock Plus write register %X value %X\n", address, value);
     // check for strobe HI to LO transition. Then perform commmand.
-    if ((thunderclock_command_register & TCP_STB) && ((value & TCP_STB) == 0)) {
+    if ((thunderclock_d->command_register & TCP_STB) && ((value & TCP_STB) == 0)) {
         // read the command register.
         if ((value & TCP_CMD) == TCP_CMD_READ_TIME) {
-            thunderclock_time_register = get_thunderclock_time();
-            fprintf(stderr, "Thunderclock Plus read time: %llX\n", thunderclock_time_register);
+            thunderclock_d->time_register = get_thunderclock_time();
+            fprintf(stderr, "Thunderclock Plus read time: %llX\n", thunderclock_d->time_register);
         }
     }
-    if ((thunderclock_command_register & TCP_CLK) && ((value & TCP_CLK) == 0)) {
+    if ((thunderclock_d->command_register & TCP_CLK) && ((value & TCP_CLK) == 0)) {
         // shift the time register right on a 1 to 0 transition of the clock bit.
         fprintf(stderr, "Thunderclock Plus CLK tick - shift time right\n");
-        thunderclock_time_register >>= 1;
+        thunderclock_d->time_register >>= 1;
     }
 
     // remember the value.
-    thunderclock_command_register = value;
+    thunderclock_d->command_register = value;
 
 }
 
@@ -137,6 +133,21 @@ void map_rom_thunderclock(void *context, SlotType_t slot) {
     }
 }
 
+void thunderclock_save_state(thunderclock_state *thunderclock_d, SnapshotWriter &w) {
+    w.begin_chunk("TCLK", 1, thunderclock_d->_slot);
+    w.put(thunderclock_d->command_register);
+    w.put(thunderclock_d->time_register);
+    w.end_chunk();
+}
+
+bool thunderclock_restore_state(thunderclock_state *thunderclock_d, SnapshotReader &r) {
+    if (!r.find("TCLK", thunderclock_d->_slot) || !r.get(thunderclock_d->command_register) || !r.get(thunderclock_d->time_register)) {
+        fprintf(stderr, "Snapshot: no Thunderclock state for slot %d\n", thunderclock_d->_slot);
+        return false;
+    }
+    return true;
+}
+
 void init_slot_thunderclock(computer_t *computer, SlotType_t slot) {
     cpu_state *cpu = computer->cpu;
     
@@ -174,4 +185,8 @@ void init_slot_thunderclock(computer_t *computer, SlotType_t slot) {
     register_C0xx_memory_write_handler(thunderclock_cmd_reg, thunderclock_write_register);
 
     register_C8xx_handler(cpu, slot, map_rom_thunderclock); */
+
+    computer->register_snapshot_handler(
+        [thunderclock_d](SnapshotWriter &w) { thunderclock_save_state(thunderclock_d, w); },
+        [thunderclock_d](SnapshotReader &r) { return thunderclock_restore_state(thunderclock_d, r); });
 }
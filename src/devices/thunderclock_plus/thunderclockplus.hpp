@@ -24,6 +24,8 @@
 
 struct thunderclock_state: public SlotData {
     ResourceFile *rom;
+    uint8_t command_register = 0;
+    uint64_t time_register = 0;
 };
 
 void init_slot_thunderclock(computer_t *computer, SlotType_t slot);
@@ -233,30 +233,32 @@ void DisplayVidex::update_display_videx(cpu_state *cpu) {
         }
     }
 
-    int framedirty = 0;
     for (int line = 0; line < 24; line++) {
         if (vs->force_full_frame_redraw || line_dirty[line]) {
             videx_render_line(cpu, line);
             line_dirty[line] = false;
-            framedirty=1;
         }
     }
+    vs->force_full_frame_redraw = false;
+}
+
+void DisplayVidex::render(const RGBA_t *pixels)
+{
+    if (screenTexture == nullptr) return; // headless
+
 // copy buffer into texture in one go.
-    if (framedirty) {
-        void* pixels;
-        int pitch;
-        if (!SDL_LockTexture(screenTexture, NULL, &pixels, &pitch)) {
-            fprintf(stderr, "Failed to lock texture: %s\n", SDL_GetError());
-            return;
-        }
-        memcpy(pixels, buffer, VIDEX_SCREEN_WIDTH * VIDEX_SCREEN_HEIGHT * sizeof(RGBA_t));
-        SDL_UnlockTexture(screenTexture);
+    void* texture_pixels;
+    int pitch;
+    if (!SDL_LockTexture(screenTexture, NULL, &texture_pixels, &pitch)) {
+        fprintf(stderr, "Failed to lock texture: %s\n", SDL_GetError());
+        return;
     }
-    vs->force_full_frame_redraw = false;
+    memcpy(texture_pixels, pixels, VIDEX_SCREEN_WIDTH * VIDEX_SCREEN_HEIGHT * sizeof(RGBA_t));
+    SDL_UnlockTexture(screenTexture);
 
     SDL_SetTextureBlendMode(screenTexture, SDL_BLENDMODE_ADD); // double-draw this to increase brightness.
-    vs->render_frame(screenTexture, 0.0f);
-    vs->render_frame(screenTexture, 0.0f);
+    video_system->render_frame(screenTexture, 0.0f);
+    video_system->render_frame(screenTexture, 0.0f);
 }
 
 bool DisplayVidex::update_display(cpu_state *cpu)
@@ -265,11 +267,6 @@ bool DisplayVidex::update_display(cpu_state *cpu)
     
     annunciator_state_t * anc_d = (annunciator_state_t *)get_module_state(cpu, MODULE_ANNUNCIATOR);
 
-    // the backbuffer must be cleared each frame. The docs state this clearly
-    // but I didn't know what the backbuffer was. Also, I assumed doing it once
-    // at startup was enough. NOPE.
-    video_system->clear();
-
     //if (videx_d && ds->display_mode == TEXT_MODE && anc_d && anc_d->annunciators[0] ) {
     if (video_scanner->is_text() && anc_d && anc_d->annunciators[0] ) {
         update_display_videx(cpu); 
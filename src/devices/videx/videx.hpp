@@ -95,6 +95,7 @@ public:
     ~DisplayVidex();
 
     bool update_display(cpu_state *cpu);
+    void render(const RGBA_t *pixels) override;
     void update_display_videx(cpu_state *cpu);
     void videx_render_line(cpu_state *cpu, int y);
     void render_videx_scanline_80x24(cpu_state *cpu, int y, void *pixels, int pitch);
@@ -27,6 +27,7 @@
 #include "display/filters.hpp"
 #include "videosystem.hpp"
 #include "util/EventDispatcher.hpp"
+#include "ui/Clipboard.hpp"
 
 bool Display::update_display(cpu_state *cpu)
 {
@@ -36,20 +37,24 @@ bool Display::update_display(cpu_state *cpu)
 
     cpu->get_video_scanner()->end_video_cycle();
 
-    void* pixels;
+    return true;
+}
+
+void Display::render(const RGBA_t *pixels)
+{
+    if (screenTexture == nullptr) return; // headless: the frame stays in buffer.
+
+    void* texture_pixels;
     int pitch;
 
-    if (!SDL_LockTexture(screenTexture, NULL, &pixels, &pitch)) {
+    if (!SDL_LockTexture(screenTexture, NULL, &texture_pixels, &pitch)) {
         fprintf(stderr, "Failed to lock texture: %s\n", SDL_GetError());
-        return false;
+        return;
     }
-    //printf("pixels:%p, this:%p, buffer:%p\n", pixels, this, buffer); fflush(stdout);
-    memcpy(pixels, buffer, width * height * sizeof(RGBA_t)); // load all buffer into texture
+    memcpy(texture_pixels, pixels, width * height * sizeof(RGBA_t)); // load all buffer into texture
     SDL_UnlockTexture(screenTexture);
 
     video_system->render_frame(screenTexture, -7.0f);
-
-    return true;
 }
 
 void Display::make_flipped() {
@@ -144,6 +149,9 @@ Display::Display(computer_t * computer, int width, int height) {
     memset(buffer, 0, width * height * sizeof(RGBA_t));
     // TODO: maybe start it with apple logo?
 
+    screenTexture = nullptr;
+    if (video_system->renderer == nullptr) return;
+
     // Create the screen texture
     screenTexture = SDL_CreateTexture(video_system->renderer,
         PIXEL_FORMAT,
@@ -161,7 +169,7 @@ Display::Display(computer_t * computer, int width, int height) {
 }
 
 Display::~Display() {
-    SDL_DestroyTexture(screenTexture);
+    if (screenTexture) SDL_DestroyTexture(screenTexture);
     delete buffer;
 }
 
@@ -194,9 +202,8 @@ bool handle_display_event(Display *ds, const SDL_Event &event) {
         }
         //init_hgr_LUT();
 
-        static char msgbuf[256];
-        snprintf(msgbuf, sizeof(msgbuf), "Hue set to: %f, Saturation to: %f\n", config.videoHue, config.videoSaturation);
-        ds->get_event_queue()->addEvent(new Event(EVENT_SHOW_MESSAGE, 0, msgbuf));
+        snprintf(ds->message, sizeof(ds->message), "Hue set to: %f, Saturation to: %f\n", config.videoHue, config.videoSaturation);
+        ds->get_event_queue()->addEvent(new Event(EVENT_SHOW_MESSAGE, 0, ds->message));
         return true;
     }
     return false;
@@ -226,9 +233,40 @@ void Display::get_buffer(uint8_t *buffer, uint32_t *width, uint32_t *height) {
             *dst++ = src[scanline * BASE_WIDTH + i].r;
         }
     }
-    static char msgbuf[256];
-    snprintf(msgbuf, sizeof(msgbuf), "Screen snapshot taken");
-    computer->event_queue->addEvent(new Event(EVENT_SHOW_MESSAGE, 0, msgbuf));
+    snprintf(message, sizeof(message), "Screen snapshot taken");
+    computer->event_queue->addEvent(new Event(EVENT_SHOW_MESSAGE, 0, message));
+}
+
+/**
+ * Write the last rendered frame, at native resolution, as a 24-bit BMP.
+ * Works headless, since the frame lives in buffer and not in the texture.
+ */
+bool Display::save_screenshot(const std::string &filename) {
+    FILE *fp = fopen(filename.c_str(), "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: Could not open %s for writing\n", filename.c_str());
+        return false;
+    }
+    BMPHeader header(width, height);
+    fwrite(&header, sizeof(header), 1, fp);
+
+    int row_size = ((width * 3 + 3) / 4) * 4;
+    uint8_t *row = new uint8_t[row_size];
+    memset(row, 0, row_size);
+    for (int y = height - 1; y >= 0; y--) { // BMP rows are bottom-up
+        uint8_t *dst = row;
+        for (int x = 0; x < width; x++) {
+            RGBA_t &px = buffer[y * width + x];
+            *dst++ = px.b;
+            *dst++ = px.g;
+            *dst++ = px.r;
+        }
+        fwrite(row, row_size, 1, fp);
+    }
+    delete[] row;
+    bool ok = !ferror(fp);
+    fclose(fp);
+    return ok;
 }
 
 void display_dump_file(cpu_state *cpu, const char *filename, uint16_t base_addr, uint16_t sizer) {
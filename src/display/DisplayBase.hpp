@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "Device_ID.hpp"
 #include "SDL3/SDL_render.h"
 #include "cpu.hpp"
@@ -62,18 +64,28 @@ public:
     ~Display();
 
     virtual bool update_display(cpu_state *cpu);
+
+    /**
+     * Upload a frame of pixels, as update_display() left them in the buffer,
+     * and draw it. Main thread only.
+     */
+    virtual void render(const RGBA_t *pixels);
     void register_display_device(computer_t *computer, device_id id);
 
     inline uint8_t flash_mask() { return (flash_counter >= 15) ? 0xFF : 0; }
     inline int get_width() { return width; }
     inline int get_height() { return height; }
 
+    char message[256]; // text for EVENT_SHOW_MESSAGE; the event keeps the pointer
+
     inline EventQueue * get_event_queue() { return event_queue; }
     inline SDL_Texture * get_texture() { return screenTexture; }
+    inline const RGBA_t * get_pixels() { return buffer; }
 
     void get_buffer(uint8_t    *buffer,
                     uint32_t   *width,
                     uint32_t   *height);
+    bool save_screenshot(const std::string &filename);
 };
 
 void display_dump_hires_page(cpu_state *cpu, int page);
@@ -1,6 +1,7 @@
 
 #include "VideoScannerII.hpp"
 #include "cpu.hpp"
+#include "util/Snapshot.hpp"
 
 void VideoScannerII::init_video_addresses()
 {
@@ -252,6 +253,34 @@ void vs_bus_write_C057(void *context, uint16_t address, uint8_t value) {
     vs_bus_read_C057(context, address);
 }
 
+void VideoScannerII::save_state(SnapshotWriter &w)
+{
+    w.begin_chunk("VSII", 1);
+    w.put(hcount);
+    w.put(vcount);
+    w.put(graf);
+    w.put(hires);
+    w.put(mixed);
+    w.put(page2);
+    w.put(video_byte);
+    w.put(video_data_size);
+    w.put(video_data, video_data_size);
+    w.end_chunk();
+}
+
+bool VideoScannerII::restore_state(SnapshotReader &r)
+{
+    if (!r.find("VSII")) return false;
+    if (!r.get(hcount) || !r.get(vcount) || !r.get(graf) || !r.get(hires) || !r.get(mixed) || !r.get(page2)
+        || !r.get(video_byte) || !r.get(video_data_size)) return false;
+    if (video_data_size < 0 || video_data_size > video_data_max || !r.get(video_data, video_data_size)) {
+        video_data_size = 0;
+        return false;
+    }
+    set_video_mode();
+    return true;
+}
+
 void init_mb_video_scanner(computer_t *computer, SlotType_t slot)
 {
     cpu_state *cpu = computer->cpu;
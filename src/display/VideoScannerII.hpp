@@ -5,6 +5,9 @@
 #include "mmus/mmu.hpp"
 #include "computer.hpp"
 
+class SnapshotWriter;
+class SnapshotReader;
+
 typedef enum {
     VM_TEXT40 = 0,
     VM_ALT_TEXT40,
@@ -82,6 +85,10 @@ public:
     virtual void video_cycle();
     virtual void init_video_addresses();
 
+    /* beam position, switches and the video data gathered so far this frame */
+    virtual void save_state(SnapshotWriter &w);
+    virtual bool restore_state(SnapshotReader &r);
+
     inline int       get_video_data_size() { return video_data_size; }
     inline void      end_video_cycle()     { video_data_size = 0; }
     inline uint8_t   get_video_byte()      { return video_byte; }
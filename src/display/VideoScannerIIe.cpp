@@ -1,6 +1,7 @@
 
 #include "VideoScannerIIe.hpp"
 #include "display/VideoScannerII.hpp"
+#include "util/Snapshot.hpp"
 
 void VideoScannerIIe::init_video_addresses()
 {
@@ -209,6 +210,24 @@ VideoScannerIIe::VideoScannerIIe(MMU * mmu) : VideoScannerII(mmu)
     dblres    = false;
 }
 
+void VideoScannerIIe::save_state(SnapshotWriter &w)
+{
+    VideoScannerII::save_state(w);
+    w.begin_chunk("VSIE", 1);
+    w.put(sw80col);
+    w.put(sw80store);
+    w.put(altchrset);
+    w.put(dblres);
+    w.end_chunk();
+}
+
+bool VideoScannerIIe::restore_state(SnapshotReader &r)
+{
+    // our switches first, so the base class picks the right mode.
+    if (!r.find("VSIE") || !r.get(sw80col) || !r.get(sw80store) || !r.get(altchrset) || !r.get(dblres)) return false;
+    return VideoScannerII::restore_state(r);
+}
+
 void vs_bus_write_C00C(void *context, uint16_t address, uint8_t data) {
     VideoScannerIIe *vs = (VideoScannerIIe *)context;
     //printf("--80COL\n"); 
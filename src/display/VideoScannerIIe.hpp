@@ -33,6 +33,9 @@ public:
 
     virtual void video_cycle() override;
     virtual void init_video_addresses() override;
+
+    virtual void save_state(SnapshotWriter &w) override;
+    virtual bool restore_state(SnapshotReader &r) override;
 };
 
 void init_mb_video_scanner_iie(computer_t *computer, SlotType_t slot);
@@ -17,10 +17,15 @@
 
 #include <iostream>
 #include <cstdio>
+#include <cstring>
 #include <unistd.h>
 #include <time.h>
 #include <getopt.h>
-#include <regex>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <SDL3/SDL_main.h>
 
 #include "gs2.hpp"
@@ -41,9 +46,18 @@
 #include "videosystem.hpp"
 #include "debugger/debugwindow.hpp"
 #include "computer.hpp"
+#include "machine.hpp"
+#include "cpus/fast_forward.hpp"
 #include "mmus/mmu_ii.hpp"
 #include "mmus/mmu_iie.hpp"
 #include "util/EventTimer.hpp"
+#include "util/Snapshot.hpp"
+#include "util/RewindBuffer.hpp"
+#include "util/InputLog.hpp"
+#include "util/MediaIndex.hpp"
+#include "util/FramePacer.hpp"
+#include "util/FrameQueue.hpp"
+#include "util/Timeline.hpp"
 #include "ui/SelectSystem.hpp"
 #include "ui/MainAtlas.hpp"
 
@@ -93,63 +107,225 @@
 /** Globals we haven't dealt properly with yet. */
 OSD *osd = nullptr;
 
-#if 0
-cpu_state *CPUs[MAX_CPUS];
-void init_cpus() { // this is the same as a power-on event.
-    for (int i = 0; i < MAX_CPUS; i++) {
-        CPUs[i] = new cpu_state();
-        CPUs[i]->init();
+/**
+ * Run-ahead: with this frame's input already latched, snapshot the machine,
+ * run frames ahead, draw the last of them, then roll back. The guest's
+ * response to input shows up that many frames sooner. Nothing from the
+ * speculative frames is kept - devices see cpu->speculative and skip disk
+ * writes, printer output and speaker events, audio is generated before we
+ * get here, and tracing and profiling are paused.
+ */
+static void run_ahead(computer_t *computer, SnapshotWriter &snapshot, int frames) {
+    cpu_state *cpu = computer->cpu;
+
+    computer->save_snapshot(snapshot);
+
+    bool trace = cpu->trace;
+    Profiler *profiler = cpu->profiler;
+    Coverage *coverage = cpu->coverage;
+    cpu->trace = false;
+    cpu->profiler = nullptr;
+    cpu->coverage = nullptr;
+    cpu->speculative = true;
+
+    TIMELINE_SCOPE("run ahead");
+    for (int i = 0; i < frames && !cpu->halt; i++) {
+        while (cpu->bus_cycles < 17030) {
+            if (computer->event_timer->isEventPassed(cpu->cycles)) {
+                computer->event_timer->processEvents(cpu->cycles);
+            }
+            (cpu->execute_next)(cpu);
+        }
+        cpu->bus_cycles -= 17030;
+    }
+    computer->video_system->update_display();
+
+    cpu->speculative = false;
+    cpu->trace = trace;
+    cpu->profiler = profiler;
+    cpu->coverage = coverage;
+
+    SnapshotReader r;
+    if (!r.open(snapshot.data().data(), snapshot.size()) || !computer->restore_snapshot(r)) {
+        fprintf(stderr, "run-ahead: failed to roll back\n");
     }
 }
-#endif
 
-void run_cpus(computer_t *computer) {
+/**
+ * The machine runs on its own thread, so a slow compositor, a vsync'd
+ * present or a window being dragged doesn't hold up emulation. That thread
+ * owns computer_t while it runs a frame. The main thread keeps SDL events,
+ * the OSD, the debugger and presenting - it takes machine_lock between
+ * frames for the parts that reach into the machine, and finished frames come
+ * to it through a lock-free queue.
+ */
+struct emulation_shared_t {
+    std::mutex machine_lock;
+    std::atomic<bool> ui_waiting{false};    // main thread wants the machine; don't grab it straight back
+    std::atomic<bool> done{false};
+    std::atomic<bool> rewind_held{false};   // F11 is down; only the main thread may ask SDL
+    FrameQueue<display_frame_t> frames;
+    int run_ahead = 0;                         // frames; 0 if off, or if the machine can't be rolled back
+    uint64_t present_interval_ns = 16666667;   // host refresh; turbo draws no more often than this
+};
+
+/**
+ * Draw the frame and hand it to the main thread. If the main thread hasn't
+ * freed a frame to draw into, it's behind and couldn't show this one anyway,
+ * so the scanner's data is dropped without rendering it.
+ */
+static bool publish_frame(computer_t *computer, emulation_shared_t *shared, SnapshotWriter &run_ahead_snapshot) {
+    TIMELINE_SCOPE("publish frame");
+    cpu_state *cpu = computer->cpu;
+
+    display_frame_t *frame = shared->frames.acquire();
+    if (frame == nullptr) {
+        cpu->get_video_scanner()->end_video_cycle();
+        return false;
+    }
+    if (shared->run_ahead && !cpu->halt && cpu->execution_mode == EXEC_NORMAL && !computer->debug_window->window_open) {
+        run_ahead(computer, run_ahead_snapshot, shared->run_ahead);
+    } else {
+        computer->video_system->update_display();
+    }
+    computer->video_system->capture_frame(*frame);
+    shared->frames.publish(frame);
+    return true;
+}
+
+static void emulation_thread(computer_t *computer, emulation_shared_t *shared) {
+    TIMELINE_THREAD("emulation");
     cpu_state *cpu = computer->cpu;
 
     /* initialize time tracker vars */
     uint64_t ct = SDL_GetTicksNS();
-    uint64_t last_event_update = ct;
-    uint64_t last_display_update = ct;
-    uint64_t last_audio_update = ct;
-    uint64_t last_app_event_update = ct;
-    uint64_t last_5sec_update = ct;
-    uint64_t last_mockingboard_update = ct;
     uint64_t last_frame_update = ct;
+    uint64_t next_present = ct;
+    uint64_t last_5sec_update = ct;
     uint64_t last_5sec_cycles = cpu->cycles;
+    uint64_t last_5sec_slips = cpu->clock_slip;
+    uint64_t frames_skipped = 0;
 
     uint64_t last_cycle_count =cpu->cycles;
     uint64_t last_cycle_time = SDL_GetTicksNS();
 
-    uint64_t last_time_window_start = 0;
     uint64_t last_cycle_window_start = 0;
-    
+
+    // hold two frames of audio queued: the one just made and one to cover a late frame.
+    FramePacer pacer(SAMPLE_RATE, 2 * SAMPLES_PER_FRAME);
+
+    /**
+     * Rewind: snapshot the machine at the start of every frame, except in
+     * turbo. While F11 is held, restore the previous frame's snapshot instead,
+     * then run that frame again so it's drawn and heard - the machine steps
+     * back one frame per frame of real time. Off unless -r gives it memory.
+     */
+    RewindBuffer *rewind = nullptr;
+    std::deque<uint64_t> rewind_cycles;     // one per frame in rewind, oldest first
+    SnapshotWriter rewind_snapshot;
+    std::vector<uint8_t> rewind_frame;
+    SnapshotWriter run_ahead_snapshot;
+    if (gs2_app_values.rewind_mb) {
+        if (computer->snapshots_complete()) {
+            rewind = new RewindBuffer(gs2_app_values.rewind_mb * 1024 * 1024);
+        } else {
+            printf("Rewind is off: a slot card in this machine can't be snapshotted\n");
+        }
+    }
+
+    uint64_t loop_end_cycles;
+    {
+        std::lock_guard<std::mutex> lock(shared->machine_lock);
+
+        loop_end_cycles = cpu->cycles;
+
+        start_instrumentation(cpu);
+        if (!gs2_app_values.metrics_path.empty()) {
+            computer->metrics->open_json(gs2_app_values.metrics_path);
+        }
+
+        if (!gs2_app_values.replay_path.empty()) {
+            start_input_replay(computer, gs2_app_values.replay_path);
+            loop_end_cycles = cpu->cycles;
+            last_cycle_window_start = cpu->cycles;
+        } else if (!gs2_app_values.record_path.empty()) {
+            start_input_recording(computer, gs2_app_values.record_path);
+        }
+    }
+
     while (1) {
+        uint64_t wakeup_time;
+        bool must_check_time;
+        {
+        std::lock_guard<std::mutex> lock(shared->machine_lock);
+        TIMELINE_SCOPE("frame");
+        uint64_t frame_start = SDL_GetTicksNS();
+
+        // rewinding would take a recording, or its replay, back out of order.
+        bool input_file = computer->input_log->is_streaming() || computer->input_log->is_replaying();
+        if (rewind && !input_file && !cpu->halt && cpu->execution_mode == EXEC_NORMAL) {
+            TIMELINE_SCOPE("rewind");
+            if (shared->rewind_held) {
+                SnapshotReader r;
+                if (rewind->step_back(rewind_frame)) {
+                    if (rewind_cycles.size() > rewind->size()) rewind_cycles.pop_back();
+                    if (!r.open(rewind_frame.data(), rewind_frame.size()) || !computer->restore_snapshot(r)) {
+                        // what's left in the ring can't be trusted to restore either.
+                        fprintf(stderr, "Rewind: couldn't restore frame; rewind history dropped\n");
+                        rewind->clear();
+                        rewind_cycles.clear();
+                        computer->release_history(rewind);
+                    }
+                }
+            } else if (cpu->clock_mode != CLOCK_FREE_RUN) {
+                // turbo runs frames back to back; snapshotting each would cost more than it's worth.
+                computer->save_snapshot(rewind_snapshot);
+                rewind->push(rewind_snapshot.data());
+                rewind_cycles.push_back(cpu->cycles);
+                // the ring drops its oldest frames when over budget.
+                while (rewind_cycles.size() > rewind->size()) {
+                    rewind_cycles.pop_front();
+                }
+                computer->hold_history(rewind, rewind_cycles.front());
+            }
+        }
+
+        // a snapshot was restored (rewind, or the debugger going backwards). Move the
+        // audio window back with the machine and drop speaker events from the old timeline.
+        if (cpu->cycles != loop_end_cycles) {
+            last_cycle_window_start += cpu->cycles - loop_end_cycles;
+            speaker_flush_events(cpu);
+        }
+
         uint64_t cycle_window_start = cpu->cycles;
-        uint64_t cycle_window_delta = cycle_window_start - last_cycle_window_start;
 
-        uint64_t last_cycle_count = cpu->cycles;
-        uint64_t last_cycle_time = SDL_GetTicksNS();
+        last_cycle_count = cpu->cycles;
+        last_cycle_time = SDL_GetTicksNS();
 
-        uint64_t cycles_for_this_burst = clock_mode_info[cpu->clock_mode].cycles_per_burst;
+        uint64_t cycles_for_this_burst = cpu->clock_mode_info[cpu->clock_mode].cycles_per_burst;
         uint64_t execution_time = 0;
 
         if (! cpu->halt) {
+            TIMELINE_SCOPE("cpu");
             switch (cpu->execution_mode) {
                     case EXEC_NORMAL:
                         {
                         if (computer->debug_window->window_open) {
 
-                            cpu->cycle_duration_ns = clock_mode_info[cpu->clock_mode].cycle_duration_ns;
+                            begin_frame(computer);
 
                             uint64_t before_cycles = cpu->cycles;
                             uint64_t before_ns = SDL_GetTicksNS();
+                            uint32_t before_bus_cycles = cpu->bus_cycles;
 
                             // 17030 bus cycles == 1 video frame == 1/59.9227434 sec.
                             while (cpu->bus_cycles < 17030) {
+                                computer->debug_window->time_travel->tick();
                                 if (computer->event_timer->isEventPassed(cpu->cycles)) {
                                     computer->event_timer->processEvents(cpu->cycles);
                                 }
                                 (cpu->execute_next)(cpu);
+                                cpu->counters.instructions++;
                                 if (computer->debug_window->window_open) {
                                     if (computer->debug_window->check_breakpoint(&cpu->trace_entry)) {
                                         cpu->execution_mode = EXEC_STEP_INTO;
@@ -163,6 +339,7 @@ void run_cpus(computer_t *computer) {
                                     }
                                 }
                             }
+                            cpu->counters.bus_cycles += cpu->bus_cycles - before_bus_cycles;
                             if (cpu->bus_cycles >= 17030)
                                 cpu->bus_cycles -= 17030;
 
@@ -171,16 +348,22 @@ void run_cpus(computer_t *computer) {
 
                             if (cpu->clock_mode == CLOCK_FREE_RUN) {
                                 double new_cycle_duration_ns = (double)execution_time / (double)total_cycles * 1.1;
-                                clock_mode_info[CLOCK_FREE_RUN].cycle_duration_ns = new_cycle_duration_ns;
-                                clock_mode_info[CLOCK_FREE_RUN].cycles_per_burst = total_cycles;
+                                cpu->clock_mode_info[CLOCK_FREE_RUN].cycle_duration_ns = new_cycle_duration_ns;
+                                cpu->clock_mode_info[CLOCK_FREE_RUN].cycles_per_burst = total_cycles;
                             }
                         } else { // skip all debug checks if the window is not open - this may seem repetitioius but it saves all kinds of cycles where every cycle counts (GO FAST MODE)
 
                             // set this because it is used in incr_cycle()
-                            cpu->cycle_duration_ns = clock_mode_info[cpu->clock_mode].cycle_duration_ns;
+                            begin_frame(computer);
 
                             uint64_t before_cycles = cpu->cycles;
                             uint64_t before_ns = SDL_GetTicksNS();
+                            uint32_t before_bus_cycles = cpu->bus_cycles;
+
+                            // breakpoints and tracepoints work with the window closed too; a stop opens it.
+                            // Skipping loops would step over them, so that's off while any are set.
+                            debug_window_t *dw = computer->debug_window;
+                            bool stops = dw->breaks.size() > 0 || dw->cond_breaks.size() > 0;
 
                             // 17030 bus cycles == 1 video frame == 1/59.9227434 sec.
                             while (cpu->bus_cycles < 17030) {
@@ -188,16 +371,29 @@ void run_cpus(computer_t *computer) {
                                     computer->event_timer->processEvents(cpu->cycles);
                                 }
                                 (cpu->execute_next)(cpu);
+                                cpu->counters.instructions++;
+                                if (stops) {
+                                    if (dw->check_breakpoint(&cpu->trace_entry)) {
+                                        cpu->execution_mode = EXEC_STEP_INTO;
+                                        cpu->instructions_left = 0;
+                                        computer->event_queue->addEvent(new Event(EVENT_OPEN_DEBUGGER, 0, (uint64_t)0));
+                                        break;
+                                    }
+                                } else if (cpu->loop_hint) {
+                                    fast_forward_loop(cpu, computer->event_timer->getNextEventCycle());
+                                }
                             }
-                            cpu->bus_cycles -= 17030;
+                            cpu->counters.bus_cycles += cpu->bus_cycles - before_bus_cycles;
+                            if (cpu->bus_cycles >= 17030)
+                                cpu->bus_cycles -= 17030;
 
                             uint64_t total_cycles = cpu->cycles - before_cycles;
                             execution_time = SDL_GetTicksNS() - before_ns;
 
                             if (cpu->clock_mode == CLOCK_FREE_RUN) {
                                 double new_cycle_duration_ns = (double)execution_time / (double)total_cycles * 1.1;
-                                clock_mode_info[CLOCK_FREE_RUN].cycle_duration_ns = new_cycle_duration_ns;
-                                clock_mode_info[CLOCK_FREE_RUN].cycles_per_burst = total_cycles;
+                                cpu->clock_mode_info[CLOCK_FREE_RUN].cycle_duration_ns = new_cycle_duration_ns;
+                                cpu->clock_mode_info[CLOCK_FREE_RUN].cycles_per_burst = total_cycles;
                             }
                         }
                         }
@@ -205,10 +401,12 @@ void run_cpus(computer_t *computer) {
 
                     case EXEC_STEP_INTO:
                         while (cpu->instructions_left) {
+                            computer->debug_window->time_travel->tick();
                             if (computer->event_timer->isEventPassed(cpu->cycles)) {
                                 computer->event_timer->processEvents(cpu->cycles);
                             }
                             (cpu->execute_next)(cpu);
+                            cpu->counters.instructions++;
                             cpu->instructions_left--;
                         }
                         break;
@@ -222,175 +420,298 @@ void run_cpus(computer_t *computer) {
         }
 
         uint64_t current_time;
-        uint64_t audio_time;
-        uint64_t display_time;
-        uint64_t event_time;
-        uint64_t app_event_time;
+        uint64_t audio_time = 0;
 
         // bool this_free_run = (cpu->clock_mode == CLOCK_FREE_RUN) || (cpu->execution_mode == EXEC_STEP_INTO || (gs2_app_values.disk_accelerator && (any_diskii_motor_on(cpu))));
-        bool must_check_time = (cpu->execution_mode == EXEC_STEP_INTO || (gs2_app_values.disk_accelerator && (any_diskii_motor_on(cpu))));
+        must_check_time = (cpu->execution_mode == EXEC_STEP_INTO || (gs2_app_values.disk_accelerator && (any_diskii_motor_on(cpu))));
 
-        if (must_check_time == false || (current_time - last_event_update > 16667000))
-        {
-            current_time = SDL_GetTicksNS();
-
-            //computer->dispatch->processEvents();
-
-            SDL_Event event;
-            while(SDL_PollEvent(&event)) {
-                // check for system "pre" events
-                if (computer->sys_event->dispatch(event)) {
-                    continue;
-                }
-                if (computer->debug_window->handle_event(event)) { // ignores event if not for debug window
-                    continue;
-                }
-                if (!osd->event(event)) { // if osd doesn't handle it..
-                    computer->dispatch->dispatch(event); // they say call "once per frame"
-                }
-            }
-
-            osd->update();
-            bool diskii_run = any_diskii_motor_on(cpu);
-            soundeffects_update(diskii_run, diskii_tracknumber_on(cpu));
-
-            event_time = SDL_GetTicksNS() - current_time;
-            last_event_update = current_time;
-        }
-
-        /* Emit Audio Frame */
-        current_time = SDL_GetTicksNS();
-        if (must_check_time == false || (current_time - last_event_update > 16667000))
-        {
-            audio_generate_frame(cpu, last_cycle_window_start, cycle_window_start);
-            audio_time = SDL_GetTicksNS() - current_time;
-            last_audio_update = current_time;
-        }
+        /**
+         * Turbo: free-run mode runs frames back to back and draws only as
+         * many as the host can show. The speaker stays quiet - sounding it
+         * means filtering every emulated cycle.
+         */
+        bool turbo = cpu->clock_mode == CLOCK_FREE_RUN && cpu->execution_mode == EXEC_NORMAL && !cpu->halt;
 
-        /* Process Internal Event Queue */
         current_time = SDL_GetTicksNS();
-        if (must_check_time == false || (current_time - last_event_update > 16667000))
+        if (must_check_time == false || (current_time - last_frame_update > 16667000))
         {
-            Event *event = computer->event_queue->getNextEvent();
-            if (event) {
-                switch (event->getEventType()) {
-                    case EVENT_PLAY_SOUNDEFFECT:
-                        soundeffects_play(event->getEventData());
-                        break;
-                    case EVENT_REFOCUS:
-                        computer->video_system->raise();
-                        break;
-                    case EVENT_MODAL_SHOW:
-                        osd->show_diskii_modal(event->getEventKey(), event->getEventData());
-                        break;
-                    case EVENT_MODAL_CLICK:
-                        {
-                            uint64_t key = event->getEventKey();
-                            uint64_t data = event->getEventData();
-                            printf("EVENT_MODAL_CLICK: %llu %llu\n", key, data);
-                            if (data == 1) {
-                                // save and unmount.
-                                computer->mounts->unmount_media(key, SAVE_AND_UNMOUNT);
-                                osd->event_queue->addEvent(new Event(EVENT_PLAY_SOUNDEFFECT, 0, SE_SHUGART_OPEN));
-                            } else if (data == 2) {
-                                // save as - need to open file dialog, get new filename, change media filename, then unmount.
-                            } else if (data == 3) {
-                                // discard
-                                computer->mounts->unmount_media(key, DISCARD);
-                                osd->event_queue->addEvent(new Event(EVENT_PLAY_SOUNDEFFECT, 0, SE_SHUGART_OPEN));
-                            } else if (data == 4) {
-                                // cancel
-                                // Do nothing!
-                            }
-                            osd->close_diskii_modal(key, data);
-                        }
-                        break;
-                    case EVENT_SHOW_MESSAGE:
-                        osd->set_heads_up_message((const char *)event->getEventData(), 512);
-                        break;
-                 
-                }
-                delete event; // processed, we can now delete it.
+            /* Emit Audio Frame */
+            if (turbo) {
+                speaker_flush_events(cpu);
+            } else {
+                audio_generate_frame(cpu, last_cycle_window_start, cycle_window_start);
             }
-            app_event_time = SDL_GetTicksNS() - current_time;
-            last_app_event_update = current_time;
-        }
+            audio_time = SDL_GetTicksNS() - current_time;
 
-        /* Execute Device Frames - 60 fps */
-        current_time = SDL_GetTicksNS();
-        if (must_check_time == false || (current_time - last_event_update > 16667000))
-        {
+            /* Execute Device Frames - 60 fps */
+            uint64_t devices_start = SDL_GetTicksNS();
             computer->device_frame_dispatcher->dispatch();
+            uint64_t render_start = SDL_GetTicksNS();
+            computer->metrics->record(METRIC_DEVICES, render_start - devices_start);
+
+            /* Emit Video Frame */
+            if (turbo && current_time < next_present) {
+                cpu->get_video_scanner()->end_video_cycle();
+                frames_skipped++;
+            } else if (publish_frame(computer, shared, run_ahead_snapshot)) {
+                // step the schedule rather than restart it, so frames a little faster than
+                // the host's don't get every other one dropped. Don't try to catch up, though.
+                next_present += shared->present_interval_ns;
+                if (next_present < current_time) next_present = current_time;
+            } else {
+                frames_skipped++;
+            }
+            computer->metrics->record(METRIC_RENDER, SDL_GetTicksNS() - render_start);
             last_frame_update = current_time;
         }
-
-        /* Emit Video Frame */
-        current_time = SDL_GetTicksNS();
-        if (must_check_time == false || (current_time - last_event_update > 16667000))
-        {
-            computer->video_system->update_display();    
-            osd->render();
-            computer->debug_window->render();
-            computer->video_system->present();
-            display_time = SDL_GetTicksNS() - current_time;
-            last_display_update = current_time;
-        }
+        computer->metrics->record(METRIC_CPU, execution_time);
+        computer->metrics->record(METRIC_AUDIO, audio_time);
+        computer->metrics->end_frame(frame_start, cpu->cycles - cycle_window_start, cpu->counters);
 
         /* Emit 5-second Stats */
         current_time = SDL_GetTicksNS();
         if (current_time - last_5sec_update > 5000000000) {
             uint64_t delta = cpu->cycles - last_5sec_cycles;
-            cpu->e_mhz = (float)delta / float(5000000);
+            cpu->e_mhz = (float)((double)delta * 1000.0 / (double)(current_time - last_5sec_update)); // cycles per ns, in MHz
 
             fprintf(stdout, "%llu delta %llu cycles clock-mode: %d CPS: %f MHz [ slips: %llu, busy: %llu, sleep: %llu]\n", delta, cpu->cycles, cpu->clock_mode, cpu->e_mhz, cpu->clock_slip, cpu->clock_busy, cpu->clock_sleep);
-            fprintf(stdout, "event_time: %10llu, audio_time: %10llu, display_time: %10llu, app_event_time: %10llu, total: %10llu\n", event_time, audio_time, display_time, app_event_time, event_time + audio_time + display_time + app_event_time);
+            fprintf(stdout, "execution_time: %10llu, audio_time: %10llu, frames skipped: %llu\n", execution_time, audio_time, frames_skipped);
+            metrics_report_t report = computer->metrics->report();
+            fprintf(stdout, "frame time p50: %.3f ms, p99: %.3f ms, max: %.3f ms\n", report.stage[METRIC_FRAME].p50_ns / 1.0E6,
+                report.stage[METRIC_FRAME].p99_ns / 1.0E6, report.stage[METRIC_FRAME].max_ns / 1.0E6);
             fprintf(stdout, "PC: %04X, A: %02X, X: %02X, Y: %02X, P: %02X\n", cpu->pc, cpu->a, cpu->x, cpu->y, cpu->p);
+            if (cpu->clock_mode != CLOCK_FREE_RUN && !cpu->halt && cpu->execution_mode == EXEC_NORMAL) {
+                // within a percent, and no frame overran: the host is keeping up with the clock.
+                double target_mhz = (double)cpu->HZ_RATE / 1.0E6;
+                bool sustained = cpu->e_mhz >= target_mhz * 0.99 && cpu->clock_slip == last_5sec_slips;
+                fprintf(stdout, "target: %.4f MHz, achieved %.1f%%, %s\n", target_mhz, 100.0 * cpu->e_mhz / target_mhz,
+                    sustained ? "sustained" : "host can't keep up");
+            }
+            last_5sec_slips = cpu->clock_slip;
             last_5sec_cycles = cpu->cycles;
             last_5sec_update = current_time;
         }
 
         if (cpu->halt == HLT_USER) {
-            computer->video_system->update_display(); // update one last time to show the last state.
+            publish_frame(computer, shared, run_ahead_snapshot); // update one last time to show the last state.
             break;
         }
 
-        // calculate what sleep-until time should be.
-        uint64_t wakeup_time = last_cycle_time + (cpu->cycles - last_cycle_count) * cpu->cycle_duration_ns;
+        // calculate what sleep-until time should be. While the speaker is playing, its
+        // audio device is the master clock and the frame is nudged to keep it fed.
+        uint64_t frame_ns = (cpu->cycles - last_cycle_count) * cpu->cycle_duration_ns;
+        if (!gs2_app_values.sleep_mode && cpu->clock_mode != CLOCK_FREE_RUN) {
+            frame_ns = pacer.frame_ns(frame_ns, speaker_queued_samples(cpu));
+        }
+        wakeup_time = last_cycle_time + frame_ns;
+
+        if (must_check_time == false && cpu->clock_mode != CLOCK_FREE_RUN && SDL_GetTicksNS() > wakeup_time) {
+            current_time = SDL_GetTicksNS();
+            printf("  last_cycle_time:%llu\n", last_cycle_time);
+            printf("     # CPU cycles:%llu\n", (cpu->cycles - last_cycle_count));
+            printf("cycle_duration_ns:%g\n", cpu->cycle_duration_ns);
+            printf("      wakeup_time:%llu\n", wakeup_time);
+            printf("     current_time:%llu\n", current_time);
+            cpu->clock_slip++;
+            printf("Clock slip: execution_time: %10llu, audio_time: %10llu\n", execution_time, audio_time);
+            fflush(stdout);
+        }
 
-        if (must_check_time == false)  {
-            uint64_t sleep_loops = 0;
+        //last_time_window_start = time_window_start;
+        last_cycle_window_start = cycle_window_start;
+        loop_end_cycles = cpu->cycles;
+        }
+
+        // let the main thread in if it's been waiting, before taking the machine again.
+        while (shared->ui_waiting.load()) {
+            std::this_thread::yield();
+        }
+
+        if (must_check_time == false && cpu->clock_mode != CLOCK_FREE_RUN)  {
             uint64_t current_time = SDL_GetTicksNS();
-            if (current_time > wakeup_time) {
-                printf("  last_cycle_time:%llu\n", last_cycle_time);
-                printf("     # CPU cycles:%llu\n", (cpu->cycles - last_cycle_count));
-                printf("cycle_duration_ns:%g\n", cpu->cycle_duration_ns);
-                printf("      wakeup_time:%llu\n", wakeup_time);
-                printf("     current_time:%llu\n", current_time);
-                cpu->clock_slip++;
-                printf("Clock slip: execution_time: %10llu, event_time: %10llu, audio_time: %10llu, display_time: %10llu, app_event_time: %10llu, total: %10llu\n",
-                    execution_time, event_time, audio_time, display_time, app_event_time, event_time + audio_time + display_time + app_event_time);
-                fflush(stdout);
-            } else {
-                if (gs2_app_values.sleep_mode) {
-                    SDL_DelayPrecise(wakeup_time - SDL_GetTicksNS());
-                } else {
-                    // busy wait sync cycle time
-                    do {
-                        sleep_loops++;
-                    } while (SDL_GetTicksNS() < wakeup_time);
+            if (current_time < wakeup_time) {
+                TIMELINE_SCOPE("sleep");
+                SDL_DelayPrecise(wakeup_time - current_time);
+                cpu->clock_sleep++;
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(shared->machine_lock);
+        stop_instrumentation(cpu);
+        computer->input_log->stop_file();
+        computer->metrics->close_json();
+        computer->metrics->print_summary(stdout);
+    }
+    computer->release_history(rewind);
+    delete rewind;
+    shared->done = true;
+}
+
+/**
+ * Handle one event from the host, the same way for every event: system
+ * hotkeys first, then the debugger window, the OSD, and finally the machine.
+ */
+static void dispatch_event(computer_t *computer, emulation_shared_t &shared, SDL_Event &event) {
+    // rewind watches the key rather than taking it, so everything else still sees F11.
+    if ((event.type == SDL_EVENT_KEY_DOWN || event.type == SDL_EVENT_KEY_UP) && event.key.scancode == SDL_SCANCODE_F11) {
+        shared.rewind_held = (event.type == SDL_EVENT_KEY_DOWN);
+    }
+    // check for system "pre" events
+    if (computer->sys_event->dispatch(event)) {
+        return;
+    }
+    if (computer->debug_window->handle_event(event)) { // ignores event if not for debug window
+        return;
+    }
+    if (!osd->event(event)) { // if osd doesn't handle it..
+        computer->dispatch->dispatch(event); // they say call "once per frame"
+    }
+}
+
+static void process_app_event(computer_t *computer, Event *event) {
+    switch (event->getEventType()) {
+        case EVENT_PLAY_SOUNDEFFECT:
+            soundeffects_play(event->getEventData());
+            break;
+        case EVENT_REFOCUS:
+            computer->video_system->raise();
+            break;
+        case EVENT_OPEN_DEBUGGER:
+            if (!computer->debug_window->window_open) computer->debug_window->set_open();
+            break;
+        case EVENT_MODAL_SHOW:
+            osd->show_diskii_modal(event->getEventKey(), event->getEventData());
+            break;
+        case EVENT_MODAL_CLICK:
+            {
+                uint64_t key = event->getEventKey();
+                uint64_t data = event->getEventData();
+                printf("EVENT_MODAL_CLICK: %llu %llu\n", key, data);
+                if (data == 1) {
+                    // save and unmount.
+                    computer->mounts->unmount_media(key, SAVE_AND_UNMOUNT);
+                    osd->event_queue->addEvent(new Event(EVENT_PLAY_SOUNDEFFECT, 0, SE_SHUGART_OPEN));
+                } else if (data == 2) {
+                    // save as - need to open file dialog, get new filename, change media filename, then unmount.
+                } else if (data == 3) {
+                    // discard
+                    computer->mounts->unmount_media(key, DISCARD);
+                    osd->event_queue->addEvent(new Event(EVENT_PLAY_SOUNDEFFECT, 0, SE_SHUGART_OPEN));
+                } else if (data == 4) {
+                    // cancel
+                    // Do nothing!
                 }
+                osd->close_diskii_modal(key, data);
+            }
+            break;
+        case EVENT_SHOW_MESSAGE:
+            osd->set_heads_up_message((const char *)event->getEventData(), 512);
+            break;
+
+    }
+}
+
+/**
+ * The main thread's half: host events, the OSD, the debugger window, and
+ * showing whatever frame the emulation thread finished last.
+ */
+void run_cpus(computer_t *computer) {
+    cpu_state *cpu = computer->cpu;
+
+    emulation_shared_t shared;
+    shared.present_interval_ns = computer->video_system->refresh_interval_ns();
+    shared.run_ahead = gs2_app_values.run_ahead;
+    if (shared.run_ahead && !computer->snapshots_complete()) {
+        printf("Run-ahead is off: a slot card in this machine can't be snapshotted\n");
+        shared.run_ahead = 0;
+    }
+    std::thread emulation(emulation_thread, computer, &shared);
+
+    std::vector<SDL_Event> events;
+    TIMELINE_THREAD("main");
+
+    while (!shared.done) {
+        // on some hosts this blocks while the window is dragged. The machine keeps running.
+        uint64_t events_start = SDL_GetTicksNS();
+        events.clear();
+        {
+            TIMELINE_SCOPE("poll events");
+            SDL_Event event;
+            while (SDL_PollEvent(&event)) {
+                events.push_back(event);
             }
         }
+        uint64_t events_ns = SDL_GetTicksNS() - events_start;
+
+        display_frame_t *frame = shared.frames.latest();
+        uint64_t present_start = 0;
+        uint64_t draw_ns = 0;
+
+        // the frame is ours until released, so it's drawn without the machine; the OSD goes over it.
+        if (frame) {
+            TIMELINE_SCOPE("draw frame");
+            present_start = SDL_GetTicksNS();
+            computer->video_system->show_frame(*frame);
+            draw_ns = SDL_GetTicksNS() - present_start;
+        }
 
-        //printf("event_time / audio time / display time / total time: %9llu %9llu %9llu %9llu\n", event_time, audio_time, display_time, event_time + audio_time + display_time);
+        {
+            shared.ui_waiting = true;
+            {
+                TIMELINE_SCOPE("wait for machine");
+                shared.machine_lock.lock();
+            }
+            std::lock_guard<std::mutex> lock(shared.machine_lock, std::adopt_lock);
+            shared.ui_waiting = false;
+
+            events_start = SDL_GetTicksNS();
+            {
+                TIMELINE_SCOPE("dispatch events");
+                for (SDL_Event &e : events) {
+                    dispatch_event(computer, shared, e);
+                }
+            }
+            computer->metrics->record_host(METRIC_EVENTS, events_ns + SDL_GetTicksNS() - events_start);
+
+            {
+                TIMELINE_SCOPE("ui update");
+                osd->update();
+                bool diskii_run = any_diskii_motor_on(cpu);
+                soundeffects_update(diskii_run, diskii_tracknumber_on(cpu));
+
+                /* Process Internal Event Queue */
+                Event *app_event = computer->event_queue->getNextEvent();
+                if (app_event) {
+                    process_app_event(computer, app_event);
+                    delete app_event; // processed, we can now delete it.
+                }
+            }
 
-        last_cycle_count = cpu->cycles;
-        last_cycle_time = SDL_GetTicksNS();
+            if (frame) {
+                TIMELINE_SCOPE("draw ui");
+                present_start = SDL_GetTicksNS();
+                osd->render();
+                computer->debug_window->render();
+            }
+        }
 
-        //last_time_window_start = time_window_start;
-        last_cycle_window_start = cycle_window_start;
+        if (frame) {
+            TIMELINE_SCOPE("present");
+            shared.frames.release(frame);
+            computer->video_system->present();
+            computer->metrics->record_host(METRIC_PRESENT, draw_ns + SDL_GetTicksNS() - present_start);
+        } else {
+            SDL_Delay(1); // nothing new to show yet.
+        }
+    }
+
+    emulation.join();
+
+    if (!gs2_app_values.timeline_path.empty()) {
+        timeline_write(gs2_app_values.timeline_path);
     }
-    cpu->trace_buffer->save_to_file(gs2_app_values.pref_path + "trace.bin");
 }
 
 gs2_app_t gs2_app_values;
@@ -402,11 +723,13 @@ int main(int argc, char *argv[]) {
     int opt;
     
     char slot_str[2], drive_str[2] /* , filename[256] */;
-    int slot, drive;
+    std::string job_file;
+    unsigned int job_threads = 0;
     
     std::vector<disk_mount_t> disks_to_mount;
 
-    if (isatty(fileno(stdin))) {
+    // CI runners don't give us a tty, but do pass options. (Finder passes -psn_ on old macOS.)
+    if (isatty(fileno(stdin)) || (argc > 1 && argv[1][0] == '-' && strncmp(argv[1], "-psn", 4) != 0)) {
         gs2_app_values.console_mode = true;
     }
 
@@ -417,26 +740,17 @@ int main(int argc, char *argv[]) {
 
     if (gs2_app_values.console_mode) {
         // parse command line optionss
-        while ((opt = getopt(argc, argv, "sxp:d:")) != -1) {
+        while ((opt = getopt(argc, argv, "sxp:d:t:P:C:H:S:U:o:J:j:B:r:a:I:i:c:M:T:m:")) != -1) {
             switch (opt) {
                 case 'p':
                     platform_id = std::stoi(optarg);
                     break;
                 case 'd':
                     {
-                        std::string filename;
-                        std::string arg_str(optarg);
-                        // Using regex for better parsing
-                        std::regex disk_pattern("s([0-9]+)d([0-9]+)=(.+)");
-                        std::smatch matches;
-                    
-                        if (std::regex_match(arg_str, matches, disk_pattern) && matches.size() == 4) {
-                            slot = std::stoi(matches[1]);
-                            drive = std::stoi(matches[2]) - 1;
-                            filename = matches[3];
-                            //std::cout << std::format("Mounting disk {} in slot {} drive {}\n", filename, slot, drive) << std::endl;
-                            std::cout << "Mounting disk " << filename << " in slot " << slot << " drive " << drive << std::endl;
-                            disks_to_mount.push_back({slot, drive, filename});
+                        disk_mount_t disk_mount;
+                        if (parse_disk_arg(optarg, disk_mount)) {
+                            std::cout << "Mounting disk " << disk_mount.filename << " in slot " << disk_mount.slot << " drive " << disk_mount.drive << std::endl;
+                            disks_to_mount.push_back(disk_mount);
                         }
                     }
                     break;
@@ -446,21 +760,138 @@ int main(int argc, char *argv[]) {
                 case 's':
                     gs2_app_values.sleep_mode = true;
                     break;
+                case 't':
+                    gs2_app_values.trace_stream_path = optarg;
+                    break;
+                case 'P':
+                    gs2_app_values.profile_path = optarg;
+                    break;
+                case 'C':
+                    gs2_app_values.coverage_path = optarg;
+                    break;
+                case 'H':
+                    gs2_app_values.headless = true;
+                    gs2_app_values.headless_frames = std::stoull(optarg);
+                    break;
+                case 'S':
+                    gs2_app_values.headless_stop = optarg;
+                    break;
+                case 'U':
+                    gs2_app_values.headless_until = optarg;
+                    break;
+                case 'o':
+                    gs2_app_values.screenshot_path = optarg;
+                    break;
+                case 'J':
+                    job_file = optarg;
+                    break;
+                case 'j':
+                    job_threads = (unsigned int)std::stoul(optarg);
+                    break;
+                case 'B':
+                    gs2_app_values.boot_checkpoint = optarg;
+                    break;
+                case 'r':
+                    gs2_app_values.rewind_mb = std::stoull(optarg);
+                    break;
+                case 'a':
+                    gs2_app_values.run_ahead = std::stoi(optarg);
+                    break;
+                case 'c':
+                    gs2_app_values.clock_mhz = std::stod(optarg);
+                    break;
+                case 'I':
+                    gs2_app_values.record_path = optarg;
+                    break;
+                case 'i':
+                    gs2_app_values.replay_path = optarg;
+                    break;
+                case 'M':
+                    gs2_app_values.metrics_path = optarg;
+                    break;
+                case 'T':
+                    gs2_app_values.timeline_path = optarg;
+                    break;
+                case 'm':
+                    gs2_app_values.media_index_path = optarg;
+                    break;
                 default:
-                    std::cerr << "Usage: " << argv[0] << " [-p platform] [-dsXdX=filename] [-x] [-s] \n";
-                    std::cerr << "  -s: sleep mode (don't busy-wait, sleep)\n";
+                    std::cerr << "Usage: " << argv[0] << " [-p platform] [-dsXdX=filename] [-x] [-s] [-c MHz] [-t tracefile] [-P profile] [-C coverage] [-r MB] [-a frames] [-I recording | -i recording] [-M metrics.jsonl] [-T timeline.json] [-m media.index] \n";
+                    std::cerr << "       " << argv[0] << " -H frames [-p platform] [-c MHz] [-dsXdX=filename] [-S 'addr [if cond]'] [-U cond] [-o screen.bmp] [-B checkpoint | -i recording] \n";
+                    std::cerr << "       " << argv[0] << " -J jobfile [-j threads] [-H frames] [-p platform] [-dsXdX=filename] \n";
+                    std::cerr << "  -s: pace frames by the host timer only, not the audio device\n";
+                    std::cerr << "  -t: stream the instruction trace to tracefile (.gstrace) while running\n";
+                    std::cerr << "  -P: profile guest code, writing profile.folded and profile.txt on exit\n";
+                    std::cerr << "  -C: record code/data coverage, merged into coverage and listed in coverage.lst on exit\n";
+                    std::cerr << "  -r: keep up to MB megabytes of per-frame snapshots; hold F11 to rewind (default 0 = off)\n";
+                    std::cerr << "  -a: run ahead frames (1-2) and show the result, to cut input latency; the machine rolls back each frame\n";
+                    std::cerr << "  -I: record every input (keys, paddles, buttons, resets, disk changes, free-run clock) with its cycle to recording\n";
+                    std::cerr << "  -i: start from recording's saved state and replay its input cycle-exactly; live input is ignored until it ends\n";
+                    std::cerr << "  -M: write each frame's stage timings, counters and MHz to metrics.jsonl as a line of JSON; shift+F4 shows them on screen\n";
+                    std::cerr << "  -T: write a Chrome trace (chrome://tracing, ui.perfetto.dev) of the frame loop to timeline.json on exit and on shift+F8;\n";
+                    std::cerr << "      builds configured with -DGS2_TIMELINE=ON only\n";
+                    std::cerr << "  -m: take disk image details from a mediaindex catalog instead of reading each image's headers at mount\n";
+                    std::cerr << "  -c: run the CPU at MHz (e.g. 8, 16 or 100, as an accelerator card would; at least 1.0205). F9 cycles back to it\n";
                     std::cerr << "  -x: disk accelerator (speed up CPU when disk II drive is active)\n";
+                    std::cerr << "  -H: headless - no window or audio; run at most frames frames (0 = no limit) as fast as possible\n";
+                    std::cerr << "  -S: headless - stop when execution reaches addr (and cond, as in the monitor's break command)\n";
+                    std::cerr << "  -U: headless - stop at the end of the first frame where cond is true\n";
+                    std::cerr << "  -o: headless - save the last frame as a BMP on exit\n";
+                    std::cerr << "  -B: headless - boot to a checkpoint (+frames after mount, or 'addr [if cond]') and cache it in the pref folder;\n";
+                    std::cerr << "      later runs with the same machine, ROMs, disks and checkpoint start from the cached one. -H/-S/-U count from there\n";
+                    std::cerr << "  -J: run each line of jobfile (headless options, e.g. -p 2 -d s6d1=disk.dsk -H 600 -o shot.bmp) as its own headless machine\n";
+                    std::cerr << "      other options on the command line are defaults for every job; jobs must not share writable disk images\n";
+                    std::cerr << "  -j: run jobs on this many threads (default: one per host core)\n";
+                    std::cerr << "  headless exit status: 0 stop condition met (or none given), 2 frame limit reached first\n";
                     exit(1);
             }
         }
     }
 
+    if (!gs2_app_values.media_index_path.empty()) {
+        gs2_app_values.media_index = new MediaIndex(gs2_app_values.media_index_path);
+        if (!gs2_app_values.media_index->load()) {
+            std::cerr << "Couldn't load media index " << gs2_app_values.media_index_path << "; mounts will identify images themselves" << std::endl;
+        }
+    }
+
     // Debug print mounted media
     std::cout << "Mounted Media (" << disks_to_mount.size() << " disks):" << std::endl;
     for (const auto& disk_mount : disks_to_mount) {
         std::cout << " Slot " << disk_mount.slot << " Drive " << disk_mount.drive << " - " << disk_mount.filename << std::endl;
     }
 
+    headless_job_t job;
+    job.platform_id = platform_id;
+    job.disks = disks_to_mount;
+    job.frames = gs2_app_values.headless_frames;
+    job.stop = gs2_app_values.headless_stop;
+    job.until = gs2_app_values.headless_until;
+    job.screenshot_path = gs2_app_values.screenshot_path;
+    job.checkpoint = gs2_app_values.boot_checkpoint;
+    job.replay_path = gs2_app_values.replay_path;
+
+    if (!job_file.empty()) {
+        std::vector<headless_job_t> jobs;
+        if (!load_headless_jobs(job_file, job, jobs)) {
+            exit(1);
+        }
+        int rc = run_headless_jobs(jobs, job_threads);
+        SDL_Quit();
+        return rc;
+    }
+
+    if (gs2_app_values.headless) {
+        if (job.frames == 0 && job.stop.empty() && job.until.empty()) {
+            std::cerr << "Headless mode needs a frame limit (-H frames), -S or -U\n";
+            exit(1);
+        }
+        headless_result_t result = run_headless_job(job, true);
+        print_headless_result(job, result);
+        SDL_Quit();
+        return result.exit_code;
+    }
+
     while (1) {
 
     computer_t *computer = new computer_t();
@@ -478,96 +909,10 @@ int main(int argc, char *argv[]) {
         delete computer;
         break;
     }
-// load platform roms - this info should get stored in the 'computer'
-    platform_info* platform = get_platform(platform_id);
-    print_platform_info(platform);
-    computer->set_platform(platform);
-    
-    rom_data *rd = load_platform_roms(platform);
-    if (!rd) {
-        system_failure("Failed to load platform roms, exiting.");
-        exit(1);
-    }
-
-    // we will ALWAYS have a 256 page map. because it's a 6502 and all is addressible in a II.
-    // II can have 4k, 8k, 12k; or 16k, 32k, 48k.
-    // II Plus can have 16k, 32K, or 48k RAM. 16K more BUT IN THE LANGUAGE CARD MODULE.
-    // always 12k rom, but not necessarily always the same ROM.
-    MMU_II *mmu_ii = nullptr;
-    MMU_IIe *mmu_iie = nullptr;
-
-    switch (platform->mmu_type) {
-        case MMU_MMU_II:
-            mmu_ii = new MMU_II(256, 48*1024, (uint8_t *) rd->main_rom_data);
-            computer->cpu->set_mmu(mmu_ii);
-            computer->set_mmu(mmu_ii); // TODO: this is ugly. Should use an interface or something like that. This may not even work if I add methods..
-            mmu_ii->set_cpu(computer->cpu);
-            break;
-        case MMU_MMU_IIE:
-            mmu_iie = new MMU_IIe(256, 128*1024, (uint8_t *) rd->main_rom_data);
-            computer->cpu->set_mmu(mmu_iie);
-            computer->set_mmu(mmu_iie); // TODO: this is ugly. Should use an interface or something like that. This may not even work if I add methods..
-            mmu_iie->set_cpu(computer->cpu);
-            break;
-        default:
-            printf("Unknown MMU type: %d\n", platform->mmu_type);
-            break;
-    }
-
-    // need to tell the MMU about our ROM somehow.
-    // need a function in MMU to "reset page to default".
-
-    computer->cpu->set_processor(platform->processor_type);
-    computer->mounts = new Mounts(computer->cpu); // TODO: this should happen in a CPU constructor.
-
-    //computer->cpu->set_video_system(computer->video_system);
-
-    computer->cpu->rd = rd;
-    //init_display_font(rd);
-
-    SystemConfig_t *system_config = get_system_config(platform_id);
-
     SlotManager_t *slot_manager = new SlotManager_t();
-
-    printf("computer->video_system:%p\n", computer->video_system); fflush(stdout);
-
-    for (int i = 0; system_config->device_map[i].id != DEVICE_ID_END; i++) {
-        DeviceMap_t dm = system_config->device_map[i];
-
-        printf("initialize ID %d (%d)\n", dm.id, i); fflush(stdout);
-
-        Device_t *device = get_device(dm.id);
-
-        if (device->power_on == nullptr) {
-            printf("Device has no poweron, not found: %d\n", dm.id);
-            continue;
-        }
-        
-        device->power_on(computer, dm.slot);
-        if (dm.slot != SLOT_NONE) {
-            slot_manager->register_slot(device, dm.slot);
-        }
-    }
-
-    // video scanner should be available here
-    computer->cpu->set_video_scanner(computer->video_scanner);
-
-    bool result = soundeffects_init(computer);
-
-    printf("Before reset\n"); fflush(stdout);
-
-    computer->cpu->reset();
-
-    printf("After reset\n"); fflush(stdout);
-
-    //printf("in gs2 cpu->video scanner: %p\n", computer->cpu->video_scanner); fflush(stdout);
-
-    // mount disks - AFTER device init.
-    while (!disks_to_mount.empty()) {
-        disk_mount_t disk_mount = disks_to_mount.back();
-        disks_to_mount.pop_back(); 
-
-        computer->mounts->mount_media(disk_mount);
+    MMU_II *mmu = setup_computer(computer, platform_id, slot_manager, disks_to_mount);
+    if (!mmu) {
+        exit(1);
     }
 
     //video_system_t *vs = computer->video_system;
@@ -587,14 +932,7 @@ int main(int argc, char *argv[]) {
 
     delete osd;
     delete computer;
-    switch (platform->mmu_type) {
-        case MMU_MMU_II:
-            delete mmu_ii;
-            break;
-        case MMU_MMU_IIE:
-            delete mmu_iie;
-            break;
-    }
+    delete mmu;
     delete select_system;
     delete aa;
     }
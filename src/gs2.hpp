@@ -30,12 +30,32 @@ typedef uint8_t byte_t;
 typedef uint16_t word_t;
 typedef uint8_t opcode_t;
 
+class MediaIndex;
+
 typedef struct gs2_app_t {
     std::string base_path;
     std::string pref_path;
     bool console_mode = false;
     bool disk_accelerator = false;
     bool sleep_mode = false;
+    std::string trace_stream_path;
+    std::string profile_path;
+    std::string coverage_path;
+    bool headless = false;
+    uint64_t headless_frames = 0;     // 0 = until a stop condition
+    std::string headless_stop;        // "addr[.hi] [if cond]"
+    std::string headless_until;       // condition, checked at the end of each frame
+    std::string screenshot_path;
+    std::string boot_checkpoint;      // "+frames" or "addr[.hi] [if cond]"
+    uint64_t rewind_mb = 0;           // rewind buffer budget, 0 = no rewind
+    int run_ahead = 0;                // frames to run ahead of input, 0 = off
+    std::string record_path;          // input recording to write
+    std::string replay_path;          // input recording to replay
+    double clock_mhz = 0;             // CPU clock for CLOCK_CUSTOM, 0 = start at 1MHz as usual
+    std::string metrics_path;         // per-frame metrics, one JSON object per line
+    std::string timeline_path;        // Chrome trace of the frame loop, written on exit and on shift+F8
+    std::string media_index_path;     // catalog written by apps/mediaindex
+    MediaIndex *media_index = nullptr; // loaded from media_index_path; mounts take image details from it
 } gs2_app_t;
 
 extern gs2_app_t gs2_app_values;
@@ -0,0 +1,673 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <regex>
+
+#include "gs2.hpp"
+#include "machine.hpp"
+#include "cpu.hpp"
+#include "devices.hpp"
+#include "systemconfig.hpp"
+#include "mmus/mmu_iie.hpp"
+#include "videosystem.hpp"
+#include "display/DisplayBase.hpp"
+#include "debugger/Profiler.hpp"
+#include "debugger/Coverage.hpp"
+#include "debugger/Breakpoints.hpp"
+#include "util/dialog.hpp"
+#include "util/soundeffects.hpp"
+#include "util/EventTimer.hpp"
+#include "util/ThreadPool.hpp"
+#include "util/MappedFile.hpp"
+#include "util/Snapshot.hpp"
+#include "util/InputLog.hpp"
+#include "cpus/fast_forward.hpp"
+
+void start_instrumentation(cpu_state *cpu) {
+    if (!gs2_app_values.trace_stream_path.empty()) {
+        cpu->trace_buffer->start_streaming(gs2_app_values.trace_stream_path);
+    }
+    if (!gs2_app_values.profile_path.empty()) {
+#ifdef GS2_PROFILER
+        cpu->profiler = new Profiler(cpu->mmu);
+#else
+        printf("Profiling requested but this build has no profiler (configure with -DGS2_PROFILER=ON)\n");
+#endif
+    }
+    if (!gs2_app_values.coverage_path.empty()) {
+        cpu->coverage = new Coverage(cpu->mmu);
+        cpu->coverage->load(gs2_app_values.coverage_path);
+    }
+}
+
+void stop_instrumentation(cpu_state *cpu) {
+    cpu->trace_buffer->stop_streaming();
+    if (cpu->profiler) {
+        cpu->profiler->save_folded(gs2_app_values.profile_path + ".folded");
+        cpu->profiler->save_report(gs2_app_values.profile_path + ".txt");
+        delete cpu->profiler;
+        cpu->profiler = nullptr;
+    }
+    if (cpu->coverage) {
+        cpu->coverage->save(gs2_app_values.coverage_path);
+        cpu->coverage->save_listing(gs2_app_values.coverage_path + ".lst");
+        delete cpu->coverage;
+        cpu->coverage = nullptr;
+    }
+    if (cpu->trace) cpu->trace_buffer->save_to_file(gs2_app_values.pref_path + "trace.bin");
+}
+
+void begin_frame(computer_t *computer) {
+    cpu_state *cpu = computer->cpu;
+    InputLog *input_log = computer->input_log;
+
+    cpu->loop_hint = 0; // left over from the debugger's loop, which doesn't skip
+
+    if (input_log->is_replaying()) {
+        input_log->replay(cpu->cycles); // the recorded clock arrives with the input
+        if (input_log->replay_done()) {
+            printf("Input replay finished at cycle %llu\n", (unsigned long long)cpu->cycles);
+            input_log->stop_replay();
+        }
+        return;
+    }
+
+    double cycle_duration_ns = cpu->clock_mode_info[cpu->clock_mode].cycle_duration_ns;
+    if (cycle_duration_ns != cpu->cycle_duration_ns) {
+        uint64_t bits;
+        memcpy(&bits, &cycle_duration_ns, sizeof(bits));
+        input_log->record(cpu->cycles, INPUT_CLOCK, bits);
+    }
+    cpu->cycle_duration_ns = cycle_duration_ns;
+}
+
+bool start_input_recording(computer_t *computer, const std::string &filename) {
+    cpu_state *cpu = computer->cpu;
+    SnapshotWriter w;
+    computer->save_snapshot(w);
+    if (!computer->input_log->start_file(filename, w.data())) return false;
+
+    // the first frame's clock, so replay doesn't depend on what the machine had before.
+    uint64_t bits;
+    cpu->cycle_duration_ns = cpu->clock_mode_info[cpu->clock_mode].cycle_duration_ns;
+    memcpy(&bits, &cpu->cycle_duration_ns, sizeof(bits));
+    computer->input_log->record(cpu->cycles, INPUT_CLOCK, bits);
+    printf("Recording input to %s\n", filename.c_str());
+    return true;
+}
+
+bool start_input_replay(computer_t *computer, const std::string &filename) {
+    std::vector<uint8_t> state;
+    SnapshotReader r;
+    if (!computer->input_log->load_file(filename, state)) return false;
+    if (!r.open(state.data(), state.size()) || !computer->restore_snapshot(r)) {
+        fprintf(stderr, "Input recording %s doesn't start from a state this machine can load\n", filename.c_str());
+        computer->input_log->stop_replay();
+        computer->input_log->clear();
+        return false;
+    }
+    printf("Replaying %zu input events from %s\n", computer->input_log->size(), filename.c_str());
+    return true;
+}
+
+bool parse_disk_arg(const std::string &arg, disk_mount_t &disk_mount) {
+    std::regex disk_pattern("s([0-9]+)d([0-9]+)=(.+)");
+    std::smatch matches;
+
+    if (!std::regex_match(arg, matches, disk_pattern) || matches.size() != 4) {
+        return false;
+    }
+    disk_mount.slot = std::stoi(matches[1]);
+    disk_mount.drive = std::stoi(matches[2]) - 1;
+    disk_mount.filename = matches[3];
+    disk_mount.media = nullptr;
+    return true;
+}
+
+MMU_II *setup_computer(computer_t *computer, int platform_id, SlotManager_t *slot_manager, std::vector<disk_mount_t> &disks_to_mount) {
+    // load platform roms - this info should get stored in the 'computer'
+    platform_info* platform = get_platform(platform_id);
+    if (!platform) {
+        printf("Unknown platform: %d\n", platform_id);
+        return nullptr;
+    }
+    print_platform_info(platform);
+    computer->set_platform(platform);
+
+    rom_data *rd = load_platform_roms(platform);
+    if (!rd) {
+        if (computer->headless) {
+            fprintf(stderr, "Failed to load platform roms\n");
+        } else {
+            system_failure("Failed to load platform roms, exiting.");
+        }
+        return nullptr;
+    }
+
+    // we will ALWAYS have a 256 page map. because it's a 6502 and all is addressible in a II.
+    // II can have 4k, 8k, 12k; or 16k, 32k, 48k.
+    // II Plus can have 16k, 32K, or 48k RAM. 16K more BUT IN THE LANGUAGE CARD MODULE.
+    // always 12k rom, but not necessarily always the same ROM.
+    MMU_II *mmu_ii = nullptr;
+    MMU_IIe *mmu_iie = nullptr;
+    MMU_II *mmu = nullptr;
+
+    switch (platform->mmu_type) {
+        case MMU_MMU_II:
+            mmu_ii = new MMU_II(256, 48*1024, (uint8_t *) rd->main_rom_data);
+            computer->cpu->set_mmu(mmu_ii);
+            computer->set_mmu(mmu_ii); // TODO: this is ugly. Should use an interface or something like that. This may not even work if I add methods..
+            mmu_ii->set_cpu(computer->cpu);
+            mmu = mmu_ii;
+            break;
+        case MMU_MMU_IIE:
+            mmu_iie = new MMU_IIe(256, 128*1024, (uint8_t *) rd->main_rom_data);
+            computer->cpu->set_mmu(mmu_iie);
+            computer->set_mmu(mmu_iie); // TODO: this is ugly. Should use an interface or something like that. This may not even work if I add methods..
+            mmu_iie->set_cpu(computer->cpu);
+            mmu = mmu_iie;
+            break;
+        default:
+            printf("Unknown MMU type: %d\n", platform->mmu_type);
+            return nullptr;
+    }
+
+    // need to tell the MMU about our ROM somehow.
+    // need a function in MMU to "reset page to default".
+
+    computer->cpu->set_processor(platform->processor_type);
+    computer->mounts = new Mounts(computer->cpu, computer->input_log); // TODO: this should happen in a CPU constructor.
+    computer->mounts->media_index = gs2_app_values.media_index;
+
+    //computer->cpu->set_video_system(computer->video_system);
+
+    computer->cpu->rd = rd;
+    //init_display_font(rd);
+
+    SystemConfig_t *system_config = get_system_config(platform_id);
+
+    // headless runs go many to a process; keep their output to results.
+    if (!computer->headless) { printf("computer->video_system:%p\n", computer->video_system); fflush(stdout); }
+
+    for (int i = 0; system_config->device_map[i].id != DEVICE_ID_END; i++) {
+        DeviceMap_t dm = system_config->device_map[i];
+
+        if (!computer->headless) { printf("initialize ID %d (%d)\n", dm.id, i); fflush(stdout); }
+
+        Device_t *device = get_device(dm.id);
+
+        if (device->power_on == nullptr) {
+            printf("Device has no poweron, not found: %d\n", dm.id);
+            continue;
+        }
+
+        size_t snapshot_handlers = computer->snapshot_handlers.size();
+        device->power_on(computer, dm.slot);
+        if (dm.slot != SLOT_NONE) {
+            slot_manager->register_slot(device, dm.slot);
+            if (computer->snapshot_handlers.size() == snapshot_handlers) {
+                computer->unsnapshotted_cards.push_back(std::string(device->name) + " in slot " + std::to_string(dm.slot));
+            }
+        }
+    }
+
+    // video scanner should be available here
+    computer->cpu->set_video_scanner(computer->video_scanner);
+
+    if (gs2_app_values.clock_mhz > 0) {
+        set_custom_clock_rate(computer->cpu, gs2_app_values.clock_mhz * 1.0E6);
+    }
+
+    if (!computer->headless) {
+        soundeffects_init(computer);
+    }
+
+    if (!computer->headless) { printf("Before reset\n"); fflush(stdout); }
+
+    computer->cpu->reset();
+
+    if (!computer->headless) { printf("After reset\n"); fflush(stdout); }
+
+    //printf("in gs2 cpu->video scanner: %p\n", computer->cpu->video_scanner); fflush(stdout);
+
+    // mount disks - AFTER device init.
+    while (!disks_to_mount.empty()) {
+        disk_mount_t disk_mount = disks_to_mount.back();
+        disks_to_mount.pop_back();
+
+        computer->mounts->mount_media(disk_mount);
+    }
+
+    return mmu;
+}
+
+/**
+ * Finish the current frame and run more until max_frames have ended (0 = no
+ * limit), execution reaches one of stops, or until is true at a frame's end.
+ * Returns why it stopped, or nullptr for the frame limit.
+ */
+static const char *run_headless_frames(computer_t *computer, Breakpoints &stops, BreakCondition &until,
+    uint64_t max_frames, bool want_frames, uint64_t &frames) {
+    cpu_state *cpu = computer->cpu;
+
+    while (!max_frames || frames < max_frames) {
+        begin_frame(computer);
+
+        // 17030 bus cycles == 1 video frame == 1/59.9227434 sec.
+        while (cpu->bus_cycles < 17030) {
+            if (computer->event_timer->isEventPassed(cpu->cycles)) {
+                computer->event_timer->processEvents(cpu->cycles);
+            }
+            (cpu->execute_next)(cpu);
+            // skipped iterations would go past a stop address without checking it.
+            if (cpu->loop_hint && stops.size() == 0) {
+                fast_forward_loop(cpu, computer->event_timer->getNextEventCycle());
+            }
+            if (stops.check(cpu, &cpu->trace_entry)) {
+                return "stop address";
+            }
+            if (cpu->halt) {
+                return "CPU halted";
+            }
+        }
+        cpu->bus_cycles -= 17030;
+        frames++;
+
+        computer->device_frame_dispatcher->dispatch();
+
+        // nobody is listening for sound effects or OSD messages.
+        while (Event *event = computer->event_queue->getNextEvent()) {
+            delete event;
+        }
+
+        if (want_frames) {
+            computer->video_system->update_display();
+        } else if (cpu->get_video_scanner()) {
+            cpu->get_video_scanner()->end_video_cycle();
+        }
+
+        if (!until.empty() && until.evaluate(cpu, &cpu->trace_entry)) {
+            return "until condition";
+        }
+    }
+    return nullptr;
+}
+
+// a checkpoint that isn't reached in ten emulated minutes never will be.
+#define CHECKPOINT_MAX_FRAMES (60 * 60 * 10)
+
+static uint64_t fnv1a64(uint64_t h, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/**
+ * Where the checkpoint for this machine, clock, media and checkpoint spec lives.
+ * Card firmware isn't part of the key; it ships with the app, like the
+ * snapshot format does.
+ */
+static std::string checkpoint_path(computer_t *computer, int platform_id, const std::vector<disk_mount_t> &disks, const std::string &checkpoint) {
+    uint64_t h = 14695981039346656037ull;
+    uint32_t format = SNAPSHOT_FORMAT_VERSION;
+    h = fnv1a64(h, &format, sizeof(format));
+    h = fnv1a64(h, &platform_id, sizeof(platform_id));
+    h = fnv1a64(h, &gs2_app_values.clock_mhz, sizeof(gs2_app_values.clock_mhz));
+
+    SystemConfig_t *system_config = get_system_config(platform_id);
+    for (int i = 0; system_config->device_map[i].id != DEVICE_ID_END; i++) {
+        h = fnv1a64(h, &system_config->device_map[i], sizeof(DeviceMap_t));
+    }
+
+    rom_data *rd = computer->cpu->rd;
+    h = fnv1a64(h, rd->main_rom_file->get_data(), rd->main_rom_file->size());
+    h = fnv1a64(h, rd->char_rom_file->get_data(), rd->char_rom_file->size());
+
+    for (const disk_mount_t &disk : disks) {
+        h = fnv1a64(h, &disk.slot, sizeof(disk.slot));
+        h = fnv1a64(h, &disk.drive, sizeof(disk.drive));
+        MappedFile media;
+        if (media.open(disk.filename, true)) {
+            h = fnv1a64(h, media.data(), media.size());
+        }
+    }
+    h = fnv1a64(h, checkpoint.data(), checkpoint.size());
+
+    char name[40];
+    snprintf(name, sizeof(name), "boot-%016llx.gs2s", (unsigned long long)h);
+    return gs2_app_values.pref_path + "checkpoints/" + name;
+}
+
+static MMU_II *build_headless_machine(const headless_job_t &job, computer_t *&computer, SlotManager_t *&slot_manager) {
+    std::vector<disk_mount_t> disks = job.disks;
+    computer = new computer_t(true);
+    slot_manager = new SlotManager_t();
+    MMU_II *mmu = setup_computer(computer, job.platform_id, slot_manager, disks);
+    if (!mmu) {
+        delete computer;
+        delete slot_manager;
+        computer = nullptr;
+        slot_manager = nullptr;
+        return nullptr;
+    }
+    // nobody looks at a headless machine's trace unless it's streamed to a file (-t).
+    computer->cpu->trace = false;
+    return mmu;
+}
+
+/**
+ * Resume from the saved checkpoint, or run to the checkpoint and save it.
+ * A machine with a card snapshots don't cover boots to the checkpoint every
+ * time: resuming would leave that card freshly powered on under a guest that
+ * had been using it.
+ */
+static bool reach_checkpoint(const headless_job_t &job, computer_t *&computer, SlotManager_t *&slot_manager, MMU_II *&mmu,
+    bool want_frames, headless_result_t &result) {
+    const char *name = job.name.empty() ? "headless" : job.name.c_str();
+    std::string path = checkpoint_path(computer, job.platform_id, job.disks, job.checkpoint);
+    bool cache = computer->snapshots_complete();
+    if (!cache) {
+        printf("%s: a slot card can't be snapshotted, so the checkpoint isn't cached\n", name);
+    }
+
+    std::error_code ec;
+    if (cache && std::filesystem::exists(path, ec)) {
+        MappedFile file;
+        SnapshotReader r;
+        if (file.open(path, true) && r.open(file.data(), file.size()) && computer->restore_snapshot(r)) {
+            printf("%s: resumed from checkpoint %s\n", name, path.c_str());
+            result.from_checkpoint = true;
+            return true;
+        }
+        // a half-restored machine can't be trusted; start over and boot it.
+        fprintf(stderr, "%s: checkpoint %s is unusable, booting instead\n", name, path.c_str());
+        delete computer;
+        delete mmu;
+        delete slot_manager;
+        mmu = build_headless_machine(job, computer, slot_manager);
+        if (!mmu) return false;
+    }
+
+    Breakpoints stops;
+    BreakCondition until;
+    uint64_t frames = 0, max_frames = CHECKPOINT_MAX_FRAMES;
+    std::string error;
+    if (job.checkpoint[0] == '+') {
+        max_frames = strtoull(job.checkpoint.c_str() + 1, nullptr, 10);
+        if (max_frames == 0) {
+            fprintf(stderr, "%s: checkpoint +frames needs at least one frame\n", name);
+            result.reason = "bad checkpoint";
+            return false;
+        }
+    } else if (stops.add(BP_KIND_BREAK, job.checkpoint, error) < 0) {
+        fprintf(stderr, "%s: bad checkpoint: %s\n", name, error.c_str());
+        result.reason = "bad checkpoint";
+        return false;
+    }
+    const char *reason = run_headless_frames(computer, stops, until, max_frames, want_frames, frames);
+    bool reached = (job.checkpoint[0] == '+') ? (reason == nullptr) : (reason && strcmp(reason, "stop address") == 0);
+    if (!reached) {
+        fprintf(stderr, "%s: checkpoint %s not reached (%s)\n", name, job.checkpoint.c_str(), reason ? reason : "frame limit");
+        result.reason = "checkpoint not reached";
+        return false;
+    }
+
+    if (!cache) return true;
+
+    // write then rename, so a job running alongside never maps half a file.
+    SnapshotWriter w;
+    computer->save_snapshot(w);
+    std::filesystem::create_directories(gs2_app_values.pref_path + "checkpoints", ec);
+    std::string tmp = path + "." + std::to_string((uintptr_t)computer) + ".tmp";
+    if (w.save_file(tmp)) {
+        std::filesystem::rename(tmp, path, ec);
+        printf("%s: saved checkpoint %s after %llu frames\n", name, path.c_str(), (unsigned long long)frames);
+    }
+    return true;
+}
+
+headless_result_t run_headless_job(headless_job_t job, bool instrument) {
+    headless_result_t result;
+
+    Breakpoints stops;
+    BreakCondition until;
+    std::string error;
+    if (!job.stop.empty() && stops.add(BP_KIND_BREAK, job.stop, error) < 0) {
+        fprintf(stderr, "%s: bad stop address: %s\n", job.name.c_str(), error.c_str());
+        result.reason = "bad stop address";
+        return result;
+    }
+    if (!job.until.empty() && !until.compile(job.until, error)) {
+        fprintf(stderr, "%s: bad until condition: %s\n", job.name.c_str(), error.c_str());
+        result.reason = "bad until condition";
+        return result;
+    }
+
+    computer_t *computer = nullptr;
+    SlotManager_t *slot_manager = nullptr;
+    MMU_II *mmu = build_headless_machine(job, computer, slot_manager);
+    if (!mmu) {
+        return result;
+    }
+    bool want_frames = !job.screenshot_path.empty();
+    uint64_t start_ns = SDL_GetTicksNS();
+
+    if (!job.replay_path.empty()) {
+        // a recording carries its own starting state; there's no checkpoint to reach.
+        if (!start_input_replay(computer, job.replay_path)) {
+            result.reason = "bad input recording";
+            delete computer;
+            delete mmu;
+            delete slot_manager;
+            return result;
+        }
+    } else if (!job.checkpoint.empty() && !reach_checkpoint(job, computer, slot_manager, mmu, want_frames, result)) {
+        delete computer;
+        delete mmu;
+        delete slot_manager;
+        return result;
+    }
+    cpu_state *cpu = computer->cpu;
+
+    if (instrument) {
+        cpu->trace = !gs2_app_values.trace_stream_path.empty();
+        start_instrumentation(cpu);
+    }
+
+    const char *reason = run_headless_frames(computer, stops, until, job.frames, want_frames, result.frames);
+    bool stopped = (reason != nullptr);
+    result.reason = stopped ? reason : "frame limit";
+
+    result.elapsed_ns = SDL_GetTicksNS() - start_ns;
+    bool had_condition = !job.stop.empty() || !job.until.empty();
+    result.exit_code = (stopped || !had_condition) ? 0 : 2;
+    result.cycles = cpu->cycles;
+    result.pc = cpu->pc;
+    result.a = cpu->a_lo;
+    result.x = cpu->x_lo;
+    result.y = cpu->y_lo;
+    result.sp = cpu->sp & 0xFF;
+    result.p = cpu->p;
+
+    if (want_frames) {
+        Display *display = computer->video_system->get_active_display();
+        if (display == nullptr || !display->save_screenshot(job.screenshot_path)) {
+            fprintf(stderr, "Could not save screenshot %s\n", job.screenshot_path.c_str());
+        }
+    }
+
+    if (instrument) stop_instrumentation(cpu);
+
+    delete computer;
+    delete mmu;
+    delete slot_manager;
+    return result;
+}
+
+void print_headless_result(const headless_job_t &job, const headless_result_t &result) {
+    const char *name = job.name.empty() ? "headless" : job.name.c_str();
+    double seconds = result.elapsed_ns / 1e9;
+    // one printf, so results from concurrent jobs don't interleave.
+    printf("%s: %s after %llu frames%s, %llu cycles, %.3f s (%.1fx)\n"
+        "%s: PC: %04X, A: %02X, X: %02X, Y: %02X, SP: %02X, P: %02X\n",
+        name, result.reason, (unsigned long long)result.frames, result.from_checkpoint ? " from checkpoint" : "", (unsigned long long)result.cycles,
+        seconds, result.elapsed_ns ? (result.frames / 59.9227434) / seconds : 0.0,
+        name, result.pc, result.a, result.x, result.y, result.sp, result.p);
+    fflush(stdout);
+}
+
+/**
+ * Split a job line into words, honoring ' and " quoting.
+ */
+static bool split_job_line(const std::string &line, std::vector<std::string> &words) {
+    std::string word;
+    bool in_word = false;
+    char quote = 0;
+    for (char c : line) {
+        if (quote) {
+            if (c == quote) quote = 0;
+            else word += c;
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            in_word = true;
+        } else if (c == ' ' || c == '\t' || c == '\r') {
+            if (in_word) words.push_back(word);
+            word.clear();
+            in_word = false;
+        } else {
+            word += c;
+            in_word = true;
+        }
+    }
+    if (in_word) words.push_back(word);
+    return quote == 0;
+}
+
+bool load_headless_jobs(const std::string &filename, const headless_job_t &defaults, std::vector<headless_job_t> &jobs) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        fprintf(stderr, "Failed to open job file: %s\n", filename.c_str());
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        std::vector<std::string> words;
+        if (!split_job_line(line, words)) {
+            fprintf(stderr, "%s:%d: unterminated quote\n", filename.c_str(), line_number);
+            return false;
+        }
+        if (words.empty() || words[0][0] == '#') continue;
+
+        headless_job_t job = defaults;
+        job.name = filename + ":" + std::to_string(line_number);
+        bool own_disks = false;
+        for (size_t i = 0; i < words.size(); i++) {
+            const std::string &opt = words[i];
+            if (opt.size() != 2 || opt[0] != '-' || i + 1 >= words.size()) {
+                fprintf(stderr, "%s:%d: expected -p, -d, -H, -S, -U, -o, -B or -i with a value, got '%s'\n", filename.c_str(), line_number, opt.c_str());
+                return false;
+            }
+            const std::string &value = words[++i];
+            switch (opt[1]) {
+                case 'p':
+                    job.platform_id = atoi(value.c_str());
+                    break;
+                case 'd': {
+                    disk_mount_t disk_mount;
+                    if (!parse_disk_arg(value, disk_mount)) {
+                        fprintf(stderr, "%s:%d: bad disk '%s', expected sXdY=filename\n", filename.c_str(), line_number, value.c_str());
+                        return false;
+                    }
+                    if (!own_disks) job.disks.clear();  // a line's disks replace the defaults
+                    own_disks = true;
+                    job.disks.push_back(disk_mount);
+                    break;
+                }
+                case 'H':
+                    job.frames = strtoull(value.c_str(), nullptr, 10);
+                    break;
+                case 'S':
+                    job.stop = value;
+                    break;
+                case 'U':
+                    job.until = value;
+                    break;
+                case 'o':
+                    job.screenshot_path = value;
+                    break;
+                case 'B':
+                    job.checkpoint = value;
+                    break;
+                case 'i':
+                    job.replay_path = value;
+                    break;
+                default:
+                    fprintf(stderr, "%s:%d: unknown option '%s'\n", filename.c_str(), line_number, opt.c_str());
+                    return false;
+            }
+        }
+        if (job.frames == 0 && job.stop.empty() && job.until.empty()) {
+            fprintf(stderr, "%s:%d: job needs -H frames, -S or -U\n", filename.c_str(), line_number);
+            return false;
+        }
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+int run_headless_jobs(const std::vector<headless_job_t> &jobs, unsigned int threads) {
+    std::mutex lock;
+    int worst = 0;
+    size_t failed = 0, timed_out = 0;
+    uint64_t start_ns = SDL_GetTicksNS();
+
+    {
+        ThreadPool pool(threads);
+        printf("Running %zu jobs on %u threads\n", jobs.size(), pool.size());
+        for (const headless_job_t &job : jobs) {
+            pool.enqueue([&, job]() {
+                headless_result_t result = run_headless_job(job);
+                std::lock_guard<std::mutex> guard(lock);
+                print_headless_result(job, result);
+                if (result.exit_code == 1) {
+                    failed++;
+                    worst = 1;
+                } else if (result.exit_code == 2) {
+                    timed_out++;
+                    if (worst == 0) worst = 2;
+                }
+            });
+        }
+        pool.wait_idle();
+    }
+
+    printf("%zu jobs in %.3f s: %zu finished, %zu ran out of frames, %zu failed\n",
+        jobs.size(), (SDL_GetTicksNS() - start_ns) / 1e9, jobs.size() - failed - timed_out, timed_out, failed);
+    return worst;
+}
@@ -0,0 +1,130 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "computer.hpp"
+#include "slots.hpp"
+#include "platforms.hpp"
+#include "util/mount.hpp"
+#include "mmus/mmu_ii.hpp"
+
+/**
+ * Build the machine for platform_id into computer: ROMs, MMU, devices, reset,
+ * then mount disks. Returns the MMU (the caller deletes it after the computer),
+ * or nullptr if the platform can't be built.
+ */
+MMU_II *setup_computer(computer_t *computer, int platform_id, SlotManager_t *slot_manager, std::vector<disk_mount_t> &disks_to_mount);
+
+/**
+ * Parse "sXdY=filename" as given to -d. Drives are numbered from 1.
+ */
+bool parse_disk_arg(const std::string &arg, disk_mount_t &disk_mount);
+
+/**
+ * Trace streaming, profiler and coverage, as asked for on the command line.
+ */
+void start_instrumentation(cpu_state *cpu);
+void stop_instrumentation(cpu_state *cpu);
+
+/**
+ * Start a frame: take this frame's clock, and any input that is due, from the
+ * input recording being replayed; otherwise take the clock from the clock
+ * mode, logging it when it changes so a free-run frame replays at the speed
+ * it ran at.
+ */
+void begin_frame(computer_t *computer);
+
+/**
+ * Snapshot the machine into filename and log all input after it there, with
+ * the cycle it arrived at.
+ */
+bool start_input_recording(computer_t *computer, const std::string &filename);
+
+/**
+ * Load a recording made by start_input_recording, restore the machine to its
+ * starting state, and replay its input from begin_frame() (and the debugger's
+ * per-instruction ticks) until it runs out.
+ */
+bool start_input_replay(computer_t *computer, const std::string &filename);
+
+/**
+ * One headless run. Stops after frames frames, when execution reaches stop,
+ * or at the end of the first frame where until is true.
+ *
+ * With a checkpoint, the run first goes as far as the checkpoint ("+N" for
+ * N frames after the disks are mounted, or "addr [if cond]" for the first
+ * time execution gets there) and snapshots the machine into the pref path,
+ * keyed by the system configuration, platform ROMs, media contents and the
+ * checkpoint itself. Later runs with the same key map that snapshot and
+ * start from it. frames, stop and until count from the checkpoint.
+ *
+ * With replay_path, the run starts from an input recording's state instead
+ * and replays its input.
+ */
+struct headless_job_t {
+    std::string name;
+    int platform_id = PLATFORM_APPLE_II_PLUS;
+    std::vector<disk_mount_t> disks;
+    uint64_t frames = 0;            // 0 = until a stop condition
+    std::string stop;               // "addr[.hi] [if cond]"
+    std::string until;              // condition, checked at the end of each frame
+    std::string screenshot_path;
+    std::string checkpoint;         // "+frames" or "addr[.hi] [if cond]"
+    std::string replay_path;        // input recording to replay
+};
+
+struct headless_result_t {
+    int exit_code = 1;              // 0 stop condition met (or none given), 2 frame limit first, 1 failed
+    const char *reason = "setup failed";
+    bool from_checkpoint = false;   // resumed from a saved boot checkpoint
+    uint64_t frames = 0;
+    uint64_t cycles = 0;
+    uint64_t elapsed_ns = 0;
+    uint16_t pc = 0;
+    uint8_t a = 0, x = 0, y = 0, sp = 0, p = 0;
+};
+
+/**
+ * Build and run one machine with no window, renderer, audio device or event
+ * polling, as fast as the host allows. Everything it touches belongs to the
+ * machine, so any number may run at once on different threads.
+ * instrument turns on the command line's trace/profile/coverage outputs,
+ * which are process-wide paths: only one machine at a time should ask.
+ */
+headless_result_t run_headless_job(headless_job_t job, bool instrument = false);
+
+void print_headless_result(const headless_job_t &job, const headless_result_t &result);
+
+/**
+ * Read a job file: one job per line, written as the headless command line
+ * options (-p -d -H -S -U -o -B -i, quoted with ' or " where they contain spaces).
+ * Options not given on a line come from defaults. Blank lines and lines
+ * starting with # are skipped.
+ */
+bool load_headless_jobs(const std::string &filename, const headless_job_t &defaults, std::vector<headless_job_t> &jobs);
+
+/**
+ * Run every job, one machine per worker, threads workers (0 = one per host
+ * core). Prints each job's result as it finishes and returns the worst exit
+ * code: 1 if any job failed, else 2 if any ran out of frames, else 0.
+ */
+int run_headless_jobs(const std::vector<headless_job_t> &jobs, unsigned int threads);
@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "mmu.hpp"
 #include "cpu.hpp"
@@ -113,6 +114,46 @@ void MMU::write(uint32_t address, uint8_t value) {
 }
 #endif
 
+void MMU::dma_read(uint16_t address, uint8_t *dst, uint32_t len) {
+    while (len > 0) {
+        uint16_t offset = address % GS2_PAGE_SIZE;
+        uint32_t run = GS2_PAGE_SIZE - offset;
+        if (run > len) run = len;
+
+        page_table_entry_t *pte = &page_table[address / GS2_PAGE_SIZE];
+        if (pte->read_p != nullptr) {
+            memcpy(dst, pte->read_p + offset, run);
+        } else {
+            for (uint32_t i = 0; i < run; i++) dst[i] = read((uint16_t)(address + i));
+        }
+        dst += run;
+        len -= run;
+        address = (uint16_t)(address + run);
+    }
+}
+
+void MMU::dma_write(uint16_t address, const uint8_t *src, uint32_t len) {
+    while (len > 0) {
+        uint16_t offset = address % GS2_PAGE_SIZE;
+        uint32_t run = GS2_PAGE_SIZE - offset;
+        if (run > len) run = len;
+
+        page_table_entry_t *pte = &page_table[address / GS2_PAGE_SIZE];
+        if (pte->write_h.write == nullptr) {
+            if (pte->write_p != nullptr) memcpy(pte->write_p + offset, src, run);
+            // shadowed memory (e.g. video pages) still needs to hear about every byte.
+            if (pte->shadow_h.write != nullptr) {
+                for (uint32_t i = 0; i < run; i++) pte->shadow_h.write(pte->shadow_h.context, address + i, src[i]);
+            }
+        } else {
+            for (uint32_t i = 0; i < run; i++) write((uint16_t)(address + i), src[i]);
+        }
+        src += run;
+        len -= run;
+        address = (uint16_t)(address + run);
+    }
+}
+
 uint8_t *MMU::get_page_base_address(page_t page) {
     return page_table[page].read_p;
 }
@@ -95,6 +95,17 @@ class MMU {
         }
         virtual uint8_t floating_bus_read();
 
+        /**
+         * dma_read / dma_write
+         * Bulk transfer between a host buffer and the CPU address space, the way a
+         * DMA device would see it: the current bank map is honored, but no CPU cycles
+         * are burned. Each page is resolved once; plain memory pages are memcpy'd in
+         * one go, and pages with I/O handlers fall back to per-byte read()/write().
+         * Addresses wrap at the top of the 64K space.
+         */
+        virtual void dma_read(uint16_t address, uint8_t *dst, uint32_t len);
+        virtual void dma_write(uint16_t address, const uint8_t *src, uint32_t len);
+
         void map_page_both(page_t page, uint8_t *data, const char *read_d); // map page to same memory with no read or write handler.
         void map_page_read_only(page_t page, uint8_t *data, const char *read_d);
         //void map_page_read_write(page_t page, uint8_t *read_data, uint8_t *write_data/* , memory_type_t type */);
@@ -104,6 +115,7 @@ class MMU {
         void set_page_read_h(page_t page, read_handler_t handler, const char *read_d); // set just the read handler routine
         void set_page_write_h(page_t page, write_handler_t handler, const char *write_d); // set just a write handler routine
         uint8_t *get_page_base_address(page_t page);
+        inline const page_table_entry_t *get_page_entry(page_t page) { return &page_table[page]; }
         const char *get_read_d(page_t page);
         const char *get_write_d(page_t page);
         void dump_page_table();
@@ -1,6 +1,7 @@
 #include "mmu_ii.hpp"
 #include "display/VideoScannerII.hpp"
 #include "display/DisplayBase.hpp"
+#include "util/Snapshot.hpp"
 
 /**
  * Sets base memory map without any specificity for various devices.
@@ -34,6 +35,7 @@ void MMU_II::power_on_randomize(uint8_t *ram, int ram_size) {
 MMU_II::MMU_II(int page_table_size, int ram_amount, uint8_t *rom_pointer) : MMU(256) {
     //ram_pages = ram_amount / GS2_PAGE_SIZE;
     ram_pages = (48 * 1024) / GS2_PAGE_SIZE; // should be 48k worth of pages or 192 pages.
+    ram_size = ram_amount;
     main_ram = new uint8_t[ram_amount];
     power_on_randomize(main_ram, ram_amount);
     
@@ -235,6 +237,47 @@ void MMU_II::write(uint32_t address, uint8_t value) {
     /* MMU::write(address, value); */
 }
 
+/**
+ * DMA into the $C000-$CFFF region goes byte-by-byte through read()/write() so
+ * soft switches and the C8xx slot ROM mapping see every access. Everything else
+ * takes the page-run fast path in MMU.
+ */
+void MMU_II::dma_read(uint16_t address, uint8_t *dst, uint32_t len) {
+    while (len > 0) {
+        uint32_t run;
+        if ((address >> 12) == 0xC) {
+            run = 0xD000 - address;
+            if (run > len) run = len;
+            for (uint32_t i = 0; i < run; i++) dst[i] = read(address + i);
+        } else {
+            run = (address < 0xC000) ? (0xC000 - address) : (0x10000 - address);
+            if (run > len) run = len;
+            MMU::dma_read(address, dst, run);
+        }
+        dst += run;
+        len -= run;
+        address = (uint16_t)(address + run);
+    }
+}
+
+void MMU_II::dma_write(uint16_t address, const uint8_t *src, uint32_t len) {
+    while (len > 0) {
+        uint32_t run;
+        if ((address >> 12) == 0xC) {
+            run = 0xD000 - address;
+            if (run > len) run = len;
+            for (uint32_t i = 0; i < run; i++) write(address + i, src[i]);
+        } else {
+            run = (address < 0xC000) ? (0xC000 - address) : (0x10000 - address);
+            if (run > len) run = len;
+            MMU::dma_write(address, src, run);
+        }
+        src += run;
+        len -= run;
+        address = (uint16_t)(address + run);
+    }
+}
+
 void MMU_II::set_C0XX_read_handler(uint16_t address, read_handler_t handler) {
     if (address < C0X0_BASE || address >= C0X0_BASE + C0X0_SIZE) {
         return;
@@ -258,6 +301,34 @@ void MMU_II::reset() {
     init_map();
 }
 
+void MMU_II::save_state(SnapshotWriter &w) {
+    w.begin_chunk("MMU ", 1);
+    w.put((uint32_t)ram_size);
+    w.put(main_ram, ram_size);
+    w.put(C8xx_slot);
+    w.put(f_intcxrom);
+    w.end_chunk();
+}
+
+bool MMU_II::restore_state(SnapshotReader &r) {
+    uint32_t size;
+    if (!r.find("MMU ") || !r.get(size)) return false;
+    if (size != (uint32_t)ram_size) {
+        fprintf(stderr, "Snapshot has %u bytes of RAM, this machine has %d\n", size, ram_size);
+        return false;
+    }
+    if (!r.get(main_ram, ram_size) || !r.get(C8xx_slot) || !r.get(f_intcxrom)) return false;
+
+    init_map();
+    if ((uint8_t)C8xx_slot == 0xFF) {
+        set_default_C8xx_map();
+    } else {
+        call_C8xx_handler((SlotType_t)C8xx_slot);
+    }
+    compose_c1cf();
+    return true;
+}
+
 void MMU_II::dump_C0XX_handlers() {
     printf("C0XX handlers:\n");
     for (int i = 0; i < C0X0_SIZE; i++) {
@@ -5,6 +5,9 @@
 #include "mmu_ii.hpp"
 
 
+class SnapshotWriter;
+class SnapshotReader;
+
 struct C8XX_handler_t {
     void (*handler)(void *context, SlotType_t slot);
     void *context;
@@ -13,6 +16,7 @@ struct C8XX_handler_t {
 class MMU_II : public MMU {
     protected:
         int ram_pages;
+        int ram_size;
         uint8_t *main_ram = nullptr;
         //uint8_t *main_io_4 = nullptr;
         uint8_t *main_rom_D0 = nullptr;
@@ -35,6 +39,8 @@ class MMU_II : public MMU {
         uint8_t read(uint32_t address) override;
         uint8_t floating_bus_read() override;
         void write(uint32_t address, uint8_t value) override;
+        void dma_read(uint16_t address, uint8_t *dst, uint32_t len) override;
+        void dma_write(uint16_t address, const uint8_t *src, uint32_t len) override;
         
         virtual void set_slot_rom(SlotType_t slot, uint8_t *rom, const char *name);
         virtual void set_C8xx_handler(SlotType_t slot, void (*handler)(void *context, SlotType_t slot), void *context);
@@ -47,6 +53,9 @@ class MMU_II : public MMU {
         virtual void set_default_C8xx_map();
         virtual void reset();
         virtual void dump_C0XX_handlers();
+        /* RAM and soft switches. Restore rebuilds the page table from them; devices that remap pages restore after this. */
+        virtual void save_state(SnapshotWriter &w);
+        virtual bool restore_state(SnapshotReader &r);
         /* Handlers for "Slot ROM" area C1 - CF */
         virtual void compose_c1cf();
         virtual void map_c1cf_page_both(uint8_t page, uint8_t *data, const char *read_d);
@@ -1,4 +1,5 @@
 #include "mmu_iie.hpp"
+#include "util/Snapshot.hpp"
 
 /**
  * Sets base memory map without any specificity for various devices.
@@ -65,6 +66,20 @@ void MMU_IIe::reset() {
     compose_c1cf();
 }
 
+void MMU_IIe::save_state(SnapshotWriter &w) {
+    MMU_II::save_state(w);
+    w.begin_chunk("MMUE", 1);
+    w.put(f_intcxrom);
+    w.put(f_slotc3rom);
+    w.end_chunk();
+}
+
+bool MMU_IIe::restore_state(SnapshotReader &r) {
+    // switches first: the base class rebuilds the map through our overrides.
+    if (!r.find("MMUE") || !r.get(f_intcxrom) || !r.get(f_slotc3rom)) return false;
+    return MMU_II::restore_state(r);
+}
+
 void iie_mmu_handle_C00X_write(void *context, uint16_t address, uint8_t value) {
     MMU_IIe *mmu = (MMU_IIe *)context;
 
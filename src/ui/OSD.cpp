@@ -122,12 +122,12 @@ void unidisk_button_click(void *userdata) {
 
     if (osd->computer->mounts->media_status(data->key).is_mounted) {
         disk_mount_t dm;
-        osd->computer->mounts->unmount_media(data->key, DISCARD); // TODO: we write blocks as we go, there is nothing to 'save' here.
+        osd->computer->mounts->unmount_media(data->key, DISCARD); // block writes are flushed by unmount_media, there is nothing to 'save' here.
         return;
     }
     
     static const SDL_DialogFileFilter filters[] = {
-        { "Disk Images",  "po;dsk;hdv;2mg" },
+        { "Disk Images",  "po;dsk;hdv;2mg;gsc" },
         { "All files",   "*" }
     };
 
@@ -667,6 +667,10 @@ void OSD::render() {
             snprintf(hud_str, sizeof(hud_str), "MHz: %8.4f", cpu->e_mhz);
             SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
             SDL_RenderDebugText(renderer, 20, window_height - 30, hud_str);
+
+            if (show_metrics) {
+                render_metrics(window_height - 30);
+            }
 #if 0
             snprintf(hud_str, sizeof(hud_str), "Cycles          PC   A  X  Y  P  (N V B D I Z C)");
             SDL_RenderDebugText(renderer, 20, window_height - 50, hud_str);
@@ -679,6 +683,36 @@ void OSD::render() {
     }
 }
 
+/**
+ * Performance overlay: p50/p99/max host time of each frame stage over the
+ * last couple of seconds, what the machine did per frame, and the effective
+ * clock, drawn up the screen from just above the MHz line.
+ */
+void OSD::render_metrics(int bottom) {
+    metrics_report_t report = computer->metrics->report();
+    char str[150];
+    int y = bottom - 10 * (NUM_METRIC_STAGES + 3);
+
+    snprintf(str, sizeof(str), "%-8s %8s %8s %8s (ms)", "", "p50", "p99", "max");
+    SDL_RenderDebugText(renderer, 20, y, str);
+    y += 10;
+    for (int i = 0; i < NUM_METRIC_STAGES; i++) {
+        const metric_summary_t &st = report.stage[i];
+        snprintf(str, sizeof(str), "%-8s %8.3f %8.3f %8.3f", FrameMetrics::stage_name((metric_stage_t)i),
+            st.p50_ns / 1.0E6, st.p99_ns / 1.0E6, st.max_ns / 1.0E6);
+        SDL_RenderDebugText(renderer, 20, y, str);
+        y += 10;
+    }
+    const frame_counters_t &c = report.counters;
+    snprintf(str, sizeof(str), "per frame: %llu instr, %llu bus cycles, %llu IRQ, %llu remaps, %llu nibbles",
+        (unsigned long long)c.instructions, (unsigned long long)c.bus_cycles, (unsigned long long)c.irqs,
+        (unsigned long long)c.remaps, (unsigned long long)c.disk_nibbles);
+    SDL_RenderDebugText(renderer, 20, y, str);
+    y += 10;
+    snprintf(str, sizeof(str), "effective: %8.4f MHz", report.mhz);
+    SDL_RenderDebugText(renderer, 20, y, str);
+}
+
 bool OSD::event(const SDL_Event &event) {
     bool active = (currentSlideStatus == SLIDE_IN);
     if (active) {
@@ -701,6 +735,10 @@ bool OSD::event(const SDL_Event &event) {
     {
         case SDL_EVENT_KEY_DOWN:
             //printf("osd key down: %d %d %d\n", event.key.key, slideStatus, currentSlideStatus);
+            if (event.key.key == SDLK_F4 && (event.key.mod & SDL_KMOD_SHIFT)) {
+                show_metrics = !show_metrics;
+                return(true);
+            }
             if (event.key.key == SDLK_F4) {
                 SDL_SetWindowRelativeMouseMode(window, false);
                 // if we're already in motion, disregard this for now.
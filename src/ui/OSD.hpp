@@ -96,6 +96,9 @@ protected:
 
     std::string headsUpMessageText;
     int headsUpMessageCount = 0;
+    bool show_metrics = false;
+
+    void render_metrics(int bottom);
 
 public:
     cpu_state *cpu = nullptr;
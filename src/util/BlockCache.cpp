@@ -0,0 +1,258 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "util/BlockCache.hpp"
+
+/**
+ * Journal layout. All values little-endian as written by the host.
+ *
+ *   header:  "GS2J" | uint32 version | uint32 block_size
+ *   record:  uint32 block | block_size bytes | uint32 checksum
+ *   commit:  uint32 0xFFFFFFFF | uint32 record count | uint32 checksum
+ *
+ * Only records followed by a valid commit are replayed.
+ */
+#define JOURNAL_MAGIC "GS2J"
+#define JOURNAL_VERSION 1
+#define JOURNAL_COMMIT 0xFFFFFFFF
+
+static uint32_t journal_checksum(uint32_t block, const uint8_t *data, uint32_t len) {
+    // FNV-1a over the block number and data.
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 4; i++) {
+        h ^= (block >> (i * 8)) & 0xFF;
+        h *= 16777619u;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void sync_file(FILE *fp) {
+    fflush(fp);
+#ifdef _WIN32
+    _commit(_fileno(fp));
+#else
+    fsync(fileno(fp));
+#endif
+}
+
+BlockCache::BlockCache(MappedFile *image, size_t data_offset, uint32_t block_size)
+    : image(image), data_offset(data_offset), block_size(block_size) {
+    block_count = (uint32_t)((image->size() - data_offset) / block_size);
+    journal_path = image->get_filename() + ".journal";
+}
+
+BlockCache::~BlockCache() {
+    close();
+}
+
+bool BlockCache::open() {
+    if (!image->is_read_only()) replay_journal();
+    flusher = std::thread(&BlockCache::flush_thread, this);
+    return true;
+}
+
+void BlockCache::close() {
+    if (!flusher.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        stopping = true;
+    }
+    wake.notify_one();
+    flusher.join();
+}
+
+bool BlockCache::read_block(uint32_t block, BlockReader reader) {
+    if (block >= block_count) return false;
+
+    std::lock_guard<std::mutex> lk(lock);
+    auto it = dirty.find(block);
+    if (it != dirty.end()) {
+        reader(it->second.data());
+        return true;
+    }
+    it = inflight.find(block);
+    if (it != inflight.end()) {
+        reader(it->second.data());
+        return true;
+    }
+    reader(image->data() + data_offset + ((size_t)block * block_size));
+    return true;
+}
+
+bool BlockCache::write_block(uint32_t block, const uint8_t *data) {
+    if (block >= block_count || image->is_read_only()) return false;
+
+    bool kick;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        std::vector<uint8_t> &buf = dirty[block];
+        buf.assign(data, data + block_size);
+        kick = (dirty.size() >= FLUSH_HIGH_WATER);
+    }
+    if (kick) wake.notify_one();
+    return true;
+}
+
+void BlockCache::flush() {
+    std::unique_lock<std::mutex> lk(lock);
+    if (dirty.empty() && inflight.empty()) return;
+    flush_requested = true;
+    wake.notify_one();
+    flushed.wait(lk, [this]() { return dirty.empty() && inflight.empty(); });
+}
+
+size_t BlockCache::dirty_count() {
+    std::lock_guard<std::mutex> lk(lock);
+    return dirty.size() + inflight.size();
+}
+
+void BlockCache::flush_thread() {
+    std::unique_lock<std::mutex> lk(lock);
+    while (true) {
+        wake.wait_for(lk, std::chrono::milliseconds(FLUSH_INTERVAL_MS), [this]() {
+            return stopping || flush_requested || dirty.size() >= FLUSH_HIGH_WATER;
+        });
+        if (dirty.empty()) {
+            flush_requested = false;
+            flushed.notify_all();
+            if (stopping) break;
+            continue;
+        }
+        // take the whole dirty set as one batch. Readers find these blocks in
+        // inflight until they've landed in the image.
+        inflight.swap(dirty);
+        flush_requested = false;
+        lk.unlock();
+
+        write_batch(inflight);
+
+        lk.lock();
+        inflight.clear();
+        flushed.notify_all();
+    }
+}
+
+void BlockCache::write_batch(block_map_t &batch) {
+    bool journaled = write_journal(batch);
+
+    for (auto &entry : batch) {
+        memcpy(image->data() + data_offset + ((size_t)entry.first * block_size), entry.second.data(), block_size);
+    }
+    image->mark_dirty(data_offset, (size_t)block_count * block_size);
+    image->flush();
+
+    if (journaled) clear_journal();
+}
+
+bool BlockCache::write_journal(block_map_t &batch) {
+    FILE *fp = fopen(journal_path.c_str(), "wb");
+    if (fp == nullptr) {
+        std::cerr << "BlockCache: could not create journal " << journal_path << ", writing without it" << std::endl;
+        return false;
+    }
+    uint32_t version = JOURNAL_VERSION;
+    fwrite(JOURNAL_MAGIC, 1, 4, fp);
+    fwrite(&version, sizeof(version), 1, fp);
+    fwrite(&block_size, sizeof(block_size), 1, fp);
+
+    uint32_t count = 0;
+    uint32_t batch_sum = 0;
+    for (auto &entry : batch) {
+        uint32_t block = entry.first;
+        uint32_t sum = journal_checksum(block, entry.second.data(), block_size);
+        fwrite(&block, sizeof(block), 1, fp);
+        fwrite(entry.second.data(), 1, block_size, fp);
+        fwrite(&sum, sizeof(sum), 1, fp);
+        batch_sum ^= sum;
+        count++;
+    }
+    uint32_t commit = JOURNAL_COMMIT;
+    fwrite(&commit, sizeof(commit), 1, fp);
+    fwrite(&count, sizeof(count), 1, fp);
+    fwrite(&batch_sum, sizeof(batch_sum), 1, fp);
+
+    bool ok = !ferror(fp);
+    sync_file(fp);
+    fclose(fp);
+    return ok;
+}
+
+void BlockCache::clear_journal() {
+    remove(journal_path.c_str());
+}
+
+void BlockCache::replay_journal() {
+    FILE *fp = fopen(journal_path.c_str(), "rb");
+    if (fp == nullptr) return; // no journal, clean shutdown last time.
+
+    char magic[4];
+    uint32_t version = 0, jblock_size = 0;
+    if (fread(magic, 1, 4, fp) != 4 || memcmp(magic, JOURNAL_MAGIC, 4) != 0
+        || fread(&version, sizeof(version), 1, fp) != 1 || version != JOURNAL_VERSION
+        || fread(&jblock_size, sizeof(jblock_size), 1, fp) != 1 || jblock_size != block_size) {
+        std::cerr << "BlockCache: ignoring unrecognized journal " << journal_path << std::endl;
+        fclose(fp);
+        return;
+    }
+
+    block_map_t pending;
+    std::vector<uint8_t> buf(block_size);
+    uint32_t batch_sum = 0;
+    int replayed = 0;
+    while (true) {
+        uint32_t block, sum;
+        if (fread(&block, sizeof(block), 1, fp) != 1) break;
+        if (block == JOURNAL_COMMIT) {
+            uint32_t count, commit_sum;
+            if (fread(&count, sizeof(count), 1, fp) != 1 || fread(&commit_sum, sizeof(commit_sum), 1, fp) != 1) break;
+            if (count != pending.size() || commit_sum != batch_sum) break;
+            for (auto &entry : pending) {
+                memcpy(image->data() + data_offset + ((size_t)entry.first * block_size), entry.second.data(), block_size);
+            }
+            replayed += (int)pending.size();
+            pending.clear();
+            batch_sum = 0;
+            continue;
+        }
+        if (fread(buf.data(), 1, block_size, fp) != block_size || fread(&sum, sizeof(sum), 1, fp) != 1) break;
+        if (block >= block_count || sum != journal_checksum(block, buf.data(), block_size)) break;
+        pending[block] = buf;
+        batch_sum ^= sum;
+    }
+    fclose(fp);
+
+    if (replayed) {
+        std::cout << "BlockCache: replayed " << replayed << " journaled blocks into " << image->get_filename() << std::endl;
+        image->mark_dirty(data_offset, (size_t)block_count * block_size);
+        image->flush();
+    }
+    clear_journal();
+}
@@ -0,0 +1,98 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "util/MappedFile.hpp"
+#include "util/BlockStore.hpp"
+
+/**
+ * BlockCache is a write-back cache sitting in front of a memory-mapped block
+ * image. The emulation thread never touches the host disk:
+ *
+ *  - write_block() copies the block into an in-memory dirty set and returns.
+ *    Repeated writes to the same block before the next flush coalesce.
+ *  - read_block() returns the newest copy: dirty set, then the batch currently
+ *    being flushed, then the image mapping.
+ *  - A background thread periodically takes the dirty set, appends it to a
+ *    write-ahead journal (<image>.journal) and syncs that, copies the blocks
+ *    into the mapping and syncs the image, then truncates the journal.
+ *
+ * If the host dies between the journal sync and the image sync, the journal
+ * is replayed the next time the image is opened.
+ */
+class BlockCache : public BlockStore {
+public:
+    BlockCache(MappedFile *image, size_t data_offset, uint32_t block_size);
+    ~BlockCache();
+
+    /**
+     * Replay any leftover journal into the image and start the flush thread.
+     */
+    bool open();
+
+    /**
+     * Flush everything and stop the flush thread. The image stays mapped.
+     */
+    void close() override;
+
+    bool read_block(uint32_t block, BlockReader reader) override;
+    bool write_block(uint32_t block, const uint8_t *data) override;
+    void flush() override;
+    bool is_read_only() override { return image->is_read_only(); }
+    uint32_t get_block_count() override { return block_count; }
+
+    size_t dirty_count();
+
+    // how often the background thread flushes, and how many dirty blocks
+    // make it flush early.
+    static constexpr int FLUSH_INTERVAL_MS = 500;
+    static constexpr size_t FLUSH_HIGH_WATER = 256;
+
+protected:
+    typedef std::unordered_map<uint32_t, std::vector<uint8_t>> block_map_t;
+
+    MappedFile *image;
+    size_t data_offset;
+    uint32_t block_size;
+    uint32_t block_count;
+    std::string journal_path;
+
+    std::mutex lock;                // protects dirty, inflight, and the flags below
+    std::condition_variable wake;
+    std::condition_variable flushed;
+    block_map_t dirty;
+    block_map_t inflight;           // batch the flush thread is writing out
+    bool flush_requested = false;
+    bool stopping = false;
+    std::thread flusher;
+
+    void flush_thread();
+    void write_batch(block_map_t &batch);
+    bool write_journal(block_map_t &batch);
+    void clear_journal();
+    void replay_journal();
+};
@@ -0,0 +1,54 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+/**
+ * BlockStore is the interface block devices (pdblock2) use to get at the
+ * blocks of a mounted image, whatever the image looks like on disk.
+ * BlockCache serves flat images (.hdv, .po, .2mg); ChunkedImage serves
+ * sparse/compressed .gsc containers.
+ */
+class BlockStore {
+public:
+    using BlockReader = std::function<void(const uint8_t *block)>;
+
+    virtual ~BlockStore() {}
+
+    /**
+     * Call reader with a pointer to the current contents of the block.
+     * The pointer is only valid for the duration of the call.
+     */
+    virtual bool read_block(uint32_t block, BlockReader reader) = 0;
+    virtual bool write_block(uint32_t block, const uint8_t *data) = 0;
+
+    /**
+     * Write all pending changes to the host file and wait for it to finish.
+     */
+    virtual void flush() = 0;
+
+    /**
+     * Flush and release the host file. Called on unmount/shutdown.
+     */
+    virtual void close() = 0;
+
+    virtual bool is_read_only() = 0;
+    virtual uint32_t get_block_count() = 0;
+};
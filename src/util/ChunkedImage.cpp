@@ -0,0 +1,449 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "util/ChunkedImage.hpp"
+#include "util/LZ.hpp"
+
+static void sync_to_disk(FILE *fp) {
+#ifdef _WIN32
+    _commit(_fileno(fp));
+#else
+    fsync(fileno(fp));
+#endif
+}
+
+static void sync_file(FILE *fp) {
+    fflush(fp);
+    sync_to_disk(fp);
+}
+
+static bool is_all_zero(const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (data[i]) return false;
+    }
+    return true;
+}
+
+ChunkedImage::ChunkedImage(size_t cache_chunks) : cache_capacity(cache_chunks) {
+    memset(&header, 0, sizeof(header));
+}
+
+ChunkedImage::~ChunkedImage() {
+    close();
+}
+
+bool ChunkedImage::read_header(const std::string &path, gsc_header_t &hdr) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == nullptr) return false;
+    size_t n = fread(&hdr, sizeof(hdr), 1, f);
+    fclose(f);
+    if (n != 1) return false;
+    if (memcmp(hdr.magic, GSC_MAGIC, 4) != 0 || hdr.version != GSC_VERSION) return false;
+    if (hdr.block_size == 0 || hdr.chunk_size == 0 || (hdr.chunk_size % hdr.block_size) != 0) return false;
+    uint64_t total = (uint64_t)hdr.block_size * hdr.block_count;
+    if (hdr.chunk_count != (total + hdr.chunk_size - 1) / hdr.chunk_size) return false;
+    return true;
+}
+
+bool ChunkedImage::open(const std::string &path, bool ro) {
+    close();
+    if (!read_header(path, header)) {
+        std::cerr << "ChunkedImage: not a valid .gsc image: " << path << std::endl;
+        return false;
+    }
+    read_only = ro || (header.flags & GSC_FLAG_LOCKED);
+    fp = fopen(path.c_str(), read_only ? "rb" : "r+b");
+    if (fp == nullptr) {
+        std::cerr << "ChunkedImage: could not open " << path << std::endl;
+        return false;
+    }
+    filename = path;
+
+    index.resize(header.chunk_count);
+    if (fseek(fp, (long)header.index_offset, SEEK_SET) != 0
+        || fread(index.data(), sizeof(gsc_index_entry_t), header.chunk_count, fp) != header.chunk_count) {
+        std::cerr << "ChunkedImage: could not read chunk index: " << path << std::endl;
+        fclose(fp);
+        fp = nullptr;
+        return false;
+    }
+    index_dirty = false;
+    if (!read_only) {
+        stopping = false;
+        flusher = std::thread(&ChunkedImage::flush_thread, this);
+    }
+    return true;
+}
+
+void ChunkedImage::close() {
+    if (fp == nullptr) return;
+    if (flusher.joinable()) {
+        {
+            std::lock_guard<std::mutex> lk(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        flusher.join(); // writes out whatever is still dirty first
+    }
+
+    // every flush leaves the chunks and index it replaced behind as dead space.
+    bool repack = false;
+    if (!read_only) {
+        uint64_t live = sizeof(header) + index.size() * sizeof(gsc_index_entry_t);
+        for (const gsc_index_entry_t &e : index) live += e.stored_size;
+        fseek(fp, 0, SEEK_END);
+        uint64_t file_size = (uint64_t)ftell(fp);
+        repack = file_size > live && file_size - live > file_size / 4;
+    }
+    fclose(fp);
+    fp = nullptr;
+    if (repack) compact(filename);
+
+    cache.clear();
+    lru.clear();
+    index.clear();
+    inflight.clear();
+    dirty_chunks = 0;
+}
+
+size_t ChunkedImage::chunk_bytes(uint32_t chunk) {
+    uint64_t total = (uint64_t)header.block_size * header.block_count;
+    uint64_t start = (uint64_t)chunk * header.chunk_size;
+    uint64_t left = total - start;
+    return left < header.chunk_size ? (size_t)left : header.chunk_size;
+}
+
+ChunkedImage::cached_chunk_t *ChunkedImage::get_chunk(uint32_t chunk) {
+    auto it = cache.find(chunk);
+    if (it != cache.end()) {
+        cache_hits++;
+        lru.splice(lru.begin(), lru, it->second.lru_pos);
+        return &it->second;
+    }
+    cache_misses++;
+
+    size_t len = chunk_bytes(chunk);
+    std::vector<uint8_t> data(len, 0);
+    gsc_index_entry_t &entry = index[chunk];
+    auto in = inflight.find(chunk);
+    if (in != inflight.end()) {
+        data = in->second;
+    } else if (entry.encoding != GSC_CHUNK_HOLE) {
+        std::vector<uint8_t> stored(entry.stored_size);
+        if (fseek(fp, (long)entry.offset, SEEK_SET) != 0
+            || fread(stored.data(), 1, entry.stored_size, fp) != entry.stored_size) {
+            std::cerr << "ChunkedImage: read error on chunk " << chunk << std::endl;
+            return nullptr;
+        }
+        if (entry.encoding == GSC_CHUNK_RAW && entry.stored_size == len) {
+            data.swap(stored);
+        } else if (entry.encoding != GSC_CHUNK_LZ || !lz_decompress(stored.data(), stored.size(), data.data(), len)) {
+            std::cerr << "ChunkedImage: corrupt chunk " << chunk << std::endl;
+            return nullptr;
+        }
+    }
+
+    if (cache.size() >= cache_capacity) evict();
+    lru.push_front(chunk);
+    cached_chunk_t &c = cache[chunk];
+    c.data.swap(data);
+    c.lru_pos = lru.begin();
+    c.dirty = false;
+    return &c;
+}
+
+void ChunkedImage::evict() {
+    uint32_t victim = lru.back();
+    auto it = cache.find(victim);
+    if (it->second.dirty) store_chunk(victim, it->second);
+    lru.pop_back();
+    cache.erase(it);
+}
+
+void ChunkedImage::pack_chunk(const uint8_t *data, size_t len, uint32_t &encoding, std::vector<uint8_t> &bytes) {
+    if (is_all_zero(data, len)) {
+        encoding = GSC_CHUNK_HOLE;
+        bytes.clear();
+        return;
+    }
+    bytes.resize(lz_compress_bound(len));
+    size_t packed_len = lz_compress(data, len, bytes.data());
+    if (packed_len < len) {
+        encoding = GSC_CHUNK_LZ;
+        bytes.resize(packed_len);
+    } else {
+        encoding = GSC_CHUNK_RAW;
+        bytes.assign(data, data + len);
+    }
+}
+
+bool ChunkedImage::append_chunk(FILE *out, uint32_t encoding, const std::vector<uint8_t> &bytes, gsc_index_entry_t &entry) {
+    if (encoding == GSC_CHUNK_HOLE) {
+        entry = { 0, 0, GSC_CHUNK_HOLE };
+        return true;
+    }
+    fseek(out, 0, SEEK_END);
+    entry.offset = (uint64_t)ftell(out);
+    entry.stored_size = (uint32_t)bytes.size();
+    entry.encoding = encoding;
+    return fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size();
+}
+
+bool ChunkedImage::encode_chunk(FILE *out, const uint8_t *data, size_t len, gsc_index_entry_t &entry) {
+    uint32_t encoding;
+    std::vector<uint8_t> bytes;
+    pack_chunk(data, len, encoding, bytes);
+    return append_chunk(out, encoding, bytes, entry);
+}
+
+bool ChunkedImage::store_chunk(uint32_t chunk, cached_chunk_t &c) {
+    // a copy the flush thread is still compressing is older than this one.
+    inflight.erase(chunk);
+    c.dirty = false;
+    dirty_chunks--;
+    index_dirty = true;
+    if (!encode_chunk(fp, c.data.data(), c.data.size(), index[chunk])) {
+        std::cerr << "ChunkedImage: write error on chunk " << chunk << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ChunkedImage::read_block(uint32_t block, BlockReader reader) {
+    std::lock_guard<std::mutex> lk(lock);
+    if (fp == nullptr || block >= header.block_count) return false;
+    uint64_t pos = (uint64_t)block * header.block_size;
+    cached_chunk_t *c = get_chunk((uint32_t)(pos / header.chunk_size));
+    if (c == nullptr) return false;
+    reader(c->data.data() + (pos % header.chunk_size));
+    return true;
+}
+
+bool ChunkedImage::write_block(uint32_t block, const uint8_t *data) {
+    bool kick;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        if (fp == nullptr || read_only || block >= header.block_count) return false;
+        uint64_t pos = (uint64_t)block * header.block_size;
+        cached_chunk_t *c = get_chunk((uint32_t)(pos / header.chunk_size));
+        if (c == nullptr) return false;
+        memcpy(c->data.data() + (pos % header.chunk_size), data, header.block_size);
+        if (!c->dirty) {
+            c->dirty = true;
+            dirty_chunks++;
+        }
+        kick = (dirty_chunks >= FLUSH_HIGH_WATER);
+    }
+    if (kick) wake.notify_one();
+    return true;
+}
+
+void ChunkedImage::flush() {
+    if (!flusher.joinable()) return;
+    std::unique_lock<std::mutex> lk(lock);
+    if (dirty_chunks == 0 && !index_dirty && !writing) return;
+    flush_requested = true;
+    wake.notify_one();
+    flushed.wait(lk, [this]() { return dirty_chunks == 0 && !index_dirty && !writing; });
+}
+
+bool ChunkedImage::write_index(uint64_t &offset) {
+    fseek(fp, 0, SEEK_END);
+    offset = (uint64_t)ftell(fp);
+    bool ok = fwrite(index.data(), sizeof(gsc_index_entry_t), index.size(), fp) == index.size();
+    return (fflush(fp) == 0) && ok;
+}
+
+bool ChunkedImage::write_header() {
+    fseek(fp, 0, SEEK_SET);
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    return (fflush(fp) == 0) && ok;
+}
+
+void ChunkedImage::flush_thread() {
+    std::unique_lock<std::mutex> lk(lock);
+    while (true) {
+        wake.wait_for(lk, std::chrono::milliseconds(FLUSH_INTERVAL_MS), [this]() {
+            return stopping || flush_requested || dirty_chunks >= FLUSH_HIGH_WATER;
+        });
+        flush_requested = false;
+        if (dirty_chunks == 0 && !index_dirty) {
+            flushed.notify_all();
+            if (stopping) break;
+            continue;
+        }
+
+        // take copies of the dirty chunks; they're clean in the cache from here on.
+        writing = true;
+        std::vector<packed_chunk_t> batch;
+        for (auto &entry : cache) {
+            if (!entry.second.dirty) continue;
+            inflight[entry.first] = entry.second.data;
+            batch.push_back({ entry.first, GSC_CHUNK_RAW, entry.second.data });
+            entry.second.dirty = false;
+        }
+        dirty_chunks = 0;
+        lk.unlock();
+
+        // compress without holding up the emulation thread.
+        for (packed_chunk_t &p : batch) {
+            std::vector<uint8_t> data;
+            data.swap(p.bytes);
+            pack_chunk(data.data(), data.size(), p.encoding, p.bytes);
+        }
+
+        lk.lock();
+        for (packed_chunk_t &p : batch) {
+            if (inflight.erase(p.chunk) == 0) continue; // evicted and stored from newer data meanwhile
+            if (!append_chunk(fp, p.encoding, p.bytes, index[p.chunk])) {
+                std::cerr << "ChunkedImage: write error on chunk " << p.chunk << std::endl;
+            }
+            index_dirty = true;
+        }
+        uint64_t index_offset = 0;
+        bool have_index = false;
+        if (index_dirty) {
+            have_index = write_index(index_offset);
+            if (!have_index) std::cerr << "ChunkedImage: could not write chunk index: " << filename << std::endl;
+            index_dirty = false;
+        }
+        lk.unlock();
+
+        // the new index has to be on disk before the header points at it.
+        if (have_index) {
+            sync_to_disk(fp);
+            lk.lock();
+            header.index_offset = index_offset;
+            bool ok = write_header();
+            lk.unlock();
+            if (ok) sync_to_disk(fp);
+            else std::cerr << "ChunkedImage: could not write header: " << filename << std::endl;
+        }
+
+        lk.lock();
+        writing = false;
+        flushed.notify_all();
+    }
+}
+
+bool ChunkedImage::create(const std::string &path, const uint8_t *data, uint32_t block_size,
+        uint32_t block_count, uint32_t chunk_size) {
+    if (block_size == 0 || chunk_size % block_size != 0) {
+        std::cerr << "ChunkedImage: chunk size must be a multiple of the block size" << std::endl;
+        return false;
+    }
+    FILE *out = fopen(path.c_str(), "w+b");
+    if (out == nullptr) {
+        std::cerr << "ChunkedImage: could not create " << path << std::endl;
+        return false;
+    }
+
+    gsc_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, GSC_MAGIC, 4);
+    hdr.version = GSC_VERSION;
+    hdr.block_size = block_size;
+    hdr.block_count = block_count;
+    hdr.chunk_size = chunk_size;
+    uint64_t total = (uint64_t)block_size * block_count;
+    hdr.chunk_count = (uint32_t)((total + chunk_size - 1) / chunk_size);
+    fwrite(&hdr, sizeof(hdr), 1, out);
+
+    std::vector<gsc_index_entry_t> idx(hdr.chunk_count);
+    bool ok = true;
+    for (uint32_t i = 0; i < hdr.chunk_count && ok; i++) {
+        uint64_t start = (uint64_t)i * chunk_size;
+        size_t len = (total - start) < chunk_size ? (size_t)(total - start) : chunk_size;
+        ok = encode_chunk(out, data + start, len, idx[i]);
+    }
+
+    fseek(out, 0, SEEK_END);
+    hdr.index_offset = (uint64_t)ftell(out);
+    ok = ok && fwrite(idx.data(), sizeof(gsc_index_entry_t), idx.size(), out) == idx.size();
+    fseek(out, 0, SEEK_SET);
+    ok = ok && fwrite(&hdr, sizeof(hdr), 1, out) == 1;
+    ok = (fclose(out) == 0) && ok;
+    if (!ok) std::cerr << "ChunkedImage: write error creating " << path << std::endl;
+    return ok;
+}
+
+bool ChunkedImage::compact(const std::string &path) {
+    gsc_header_t hdr;
+    if (!read_header(path, hdr)) {
+        std::cerr << "ChunkedImage: not a valid .gsc image: " << path << std::endl;
+        return false;
+    }
+    FILE *in = fopen(path.c_str(), "rb");
+    if (in == nullptr) {
+        std::cerr << "ChunkedImage: could not open " << path << std::endl;
+        return false;
+    }
+    std::vector<gsc_index_entry_t> idx(hdr.chunk_count);
+    if (fseek(in, (long)hdr.index_offset, SEEK_SET) != 0
+        || fread(idx.data(), sizeof(gsc_index_entry_t), idx.size(), in) != idx.size()) {
+        std::cerr << "ChunkedImage: could not read chunk index: " << path << std::endl;
+        fclose(in);
+        return false;
+    }
+
+    // write the live chunks in order to a new file, then swap it in.
+    std::string tmp_path = path + ".tmp";
+    FILE *out = fopen(tmp_path.c_str(), "wb");
+    if (out == nullptr) {
+        std::cerr << "ChunkedImage: could not create " << tmp_path << std::endl;
+        fclose(in);
+        return false;
+    }
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, out) == 1;
+    std::vector<uint8_t> stored;
+    for (uint32_t i = 0; i < hdr.chunk_count && ok; i++) {
+        if (idx[i].encoding == GSC_CHUNK_HOLE) continue;
+        stored.resize(idx[i].stored_size);
+        ok = fseek(in, (long)idx[i].offset, SEEK_SET) == 0
+            && fread(stored.data(), 1, stored.size(), in) == stored.size();
+        idx[i].offset = (uint64_t)ftell(out);
+        ok = ok && fwrite(stored.data(), 1, stored.size(), out) == stored.size();
+    }
+    hdr.index_offset = (uint64_t)ftell(out);
+    ok = ok && fwrite(idx.data(), sizeof(gsc_index_entry_t), idx.size(), out) == idx.size();
+    ok = ok && fseek(out, 0, SEEK_SET) == 0 && fwrite(&hdr, sizeof(hdr), 1, out) == 1;
+    sync_file(out);
+    ok = (fclose(out) == 0) && ok;
+    fclose(in);
+
+    if (ok) {
+        std::error_code ec;
+        std::filesystem::rename(tmp_path, path, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::cerr << "ChunkedImage: could not compact " << path << std::endl;
+        std::remove(tmp_path.c_str());
+    }
+    return ok;
+}
@@ -0,0 +1,172 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "util/BlockStore.hpp"
+
+/**
+ * .gsc - chunked block image container.
+ *
+ * A volume is split into fixed-size chunks (64K by default). Each chunk is
+ * either a hole (all zeros, nothing stored), stored raw, or LZ-compressed.
+ * A chunk index records where each chunk lives. A mostly-empty 32MB ProDOS
+ * volume shrinks to the size of the files on it, and mounting only reads
+ * the header and the index.
+ *
+ * File layout:
+ *   gsc_header_t at offset 0
+ *   chunk data, in any order
+ *   gsc_index_entry_t[chunk_count] at header.index_offset
+ *
+ * Chunks rewritten while mounted are appended to the end of the file
+ * followed by a fresh index; the header is updated last. Like BlockCache, a
+ * background thread does this every FLUSH_INTERVAL_MS, or sooner once
+ * FLUSH_HIGH_WATER chunks are dirty, compressing outside the lock. The
+ * superseded copies are dead space; close() compacts the file once they
+ * pass a quarter of it.
+ */
+
+#define GSC_MAGIC "GSC2"
+#define GSC_VERSION 1
+#define GSC_DEFAULT_CHUNK_SIZE 0x10000
+
+#define GSC_FLAG_LOCKED 0x00000001
+
+enum gsc_chunk_encoding_t {
+    GSC_CHUNK_HOLE = 0,
+    GSC_CHUNK_RAW = 1,
+    GSC_CHUNK_LZ = 2,
+};
+
+struct gsc_header_t {
+    char magic[4];
+    uint32_t version;
+    uint32_t block_size;
+    uint32_t block_count;
+    uint32_t chunk_size;
+    uint32_t chunk_count;
+    uint64_t index_offset;
+    uint32_t flags;
+    uint8_t reserved[28];
+};
+static_assert(sizeof(gsc_header_t) == 64, "gsc_header_t must be 64 bytes");
+
+struct gsc_index_entry_t {
+    uint64_t offset;
+    uint32_t stored_size;
+    uint32_t encoding;
+};
+static_assert(sizeof(gsc_index_entry_t) == 16, "gsc_index_entry_t must be 16 bytes");
+
+class ChunkedImage : public BlockStore {
+public:
+    ChunkedImage(size_t cache_chunks = 64);
+    ~ChunkedImage();
+
+    bool open(const std::string &path, bool read_only);
+    void close() override;
+
+    bool read_block(uint32_t block, BlockReader reader) override;
+    bool write_block(uint32_t block, const uint8_t *data) override;
+    void flush() override;
+    bool is_read_only() override { return read_only; }
+    uint32_t get_block_count() override { return header.block_count; }
+
+    uint64_t get_cache_hits() { return cache_hits; }
+    uint64_t get_cache_misses() { return cache_misses; }
+
+    static constexpr int FLUSH_INTERVAL_MS = 500;
+    static constexpr size_t FLUSH_HIGH_WATER = 16;
+
+    /**
+     * Read and validate just the header. Used by identify_media().
+     */
+    static bool read_header(const std::string &path, gsc_header_t &hdr);
+
+    /**
+     * Write a new container holding block_count blocks from data.
+     */
+    static bool create(const std::string &path, const uint8_t *data, uint32_t block_size,
+        uint32_t block_count, uint32_t chunk_size = GSC_DEFAULT_CHUNK_SIZE);
+
+    /**
+     * Rewrite a closed container with just its live chunks and one index.
+     */
+    static bool compact(const std::string &path);
+
+protected:
+    struct cached_chunk_t {
+        std::vector<uint8_t> data;
+        std::list<uint32_t>::iterator lru_pos;
+        bool dirty;
+    };
+
+    struct packed_chunk_t {
+        uint32_t chunk;
+        uint32_t encoding;
+        std::vector<uint8_t> bytes;
+    };
+
+    std::string filename;
+    FILE *fp = nullptr;
+    bool read_only = false;
+    gsc_header_t header;
+    std::vector<gsc_index_entry_t> index;
+    bool index_dirty = false;
+
+    // decompressed chunks, most recently used at the front of lru.
+    std::unordered_map<uint32_t, cached_chunk_t> cache;
+    std::list<uint32_t> lru;
+    size_t cache_capacity;
+    size_t dirty_chunks = 0;
+    uint64_t cache_hits = 0;
+    uint64_t cache_misses = 0;
+
+    std::mutex lock;                // protects everything above, and fp
+    std::condition_variable wake;
+    std::condition_variable flushed;
+    // chunks the flush thread is compressing, as they were when it took them.
+    // An evicted chunk is read back from here until its new copy is indexed.
+    std::unordered_map<uint32_t, std::vector<uint8_t>> inflight;
+    bool flush_requested = false;
+    bool writing = false;           // the flush thread is between taking a batch and landing the header
+    bool stopping = false;
+    std::thread flusher;
+
+    size_t chunk_bytes(uint32_t chunk);
+    cached_chunk_t *get_chunk(uint32_t chunk);
+    bool store_chunk(uint32_t chunk, cached_chunk_t &c);
+    void evict();
+    void flush_thread();
+    bool write_index(uint64_t &offset);
+    bool write_header();
+
+    static void pack_chunk(const uint8_t *data, size_t len, uint32_t &encoding, std::vector<uint8_t> &bytes);
+    static bool append_chunk(FILE *out, uint32_t encoding, const std::vector<uint8_t> &bytes, gsc_index_entry_t &entry);
+    static bool encode_chunk(FILE *out, const uint8_t *data, size_t len, gsc_index_entry_t &entry);
+};
@@ -1,4 +1,5 @@
 #include "DeviceFrameDispatcher.hpp"
+#include "Timeline.hpp"
 
 DeviceFrameDispatcher::DeviceFrameDispatcher() {
 }
@@ -11,6 +12,7 @@ void DeviceFrameDispatcher::registerHandler(EventHandler handler) {
 }
 
 void DeviceFrameDispatcher::dispatch() {
+    TIMELINE_SCOPE("DeviceFrameDispatcher::dispatch");
     for (auto& handler : handlers) {
         handler();
     }
@@ -24,6 +24,7 @@
 #define EVENT_PLAY_SOUNDEFFECT 3
 #define EVENT_REFOCUS 4
 #define EVENT_SHOW_MESSAGE 5
+#define EVENT_OPEN_DEBUGGER 6
 
 /**
  * event_id: a 64-bit integer that uniquely identifies the type of event.
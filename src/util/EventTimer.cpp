@@ -3,6 +3,7 @@
 #include <limits>
 #include <iostream>
 #include "debug.hpp"
+#include "util/Snapshot.hpp"
 
 // Constructor implementation
 EventTimer::EventTimer() = default;
@@ -90,3 +91,48 @@ bool EventTimer::hasPendingEvents() const {
 uint64_t EventTimer::getNextEventCycle() const {
     return next_event_cycle;
 }
+
+void EventTimer::saveState(SnapshotWriter &w) {
+    w.begin_chunk("EVTM", 1);
+    w.put((uint32_t)events.size());
+    for (const Event& event : events) {
+        w.put(event.triggerCycles);
+        w.put(event.instanceID);
+    }
+    w.end_chunk();
+}
+
+bool EventTimer::restoreState(SnapshotReader &r) {
+    events.clear();
+    restored.clear();
+    updateNextEventCycle();
+
+    uint32_t count;
+    if (!r.find("EVTM") || !r.get(count)) return false;
+    for (uint32_t i = 0; i < count; i++) {
+        Event event{0, nullptr, 0, nullptr};
+        if (!r.get(event.triggerCycles) || !r.get(event.instanceID)) return false;
+        restored.push_back(event);
+    }
+    return true;
+}
+
+// Put back a saved event with its owner's callback. Returns false if it wasn't pending at save time.
+bool EventTimer::rearmEvent(uint64_t instanceID, void (*callback)(uint64_t, void*), void* userData) {
+    for (const Event& event : restored) {
+        if (event.instanceID == instanceID) {
+            scheduleEvent(event.triggerCycles, callback, instanceID, userData);
+            return true;
+        }
+    }
+    return false;
+}
+
+void EventTimer::endRestore() {
+    for (const Event& event : restored) {
+        if (std::none_of(events.begin(), events.end(), [&event](const Event& e) { return e.instanceID == event.instanceID; })) {
+            fprintf(stderr, "EventTimer: no device re-armed saved event %llx\n", (unsigned long long)event.instanceID);
+        }
+    }
+    restored.clear();
+}
@@ -3,6 +3,9 @@
 #include <vector>
 #include "gs2.hpp"
 
+class SnapshotWriter;
+class SnapshotReader;
+
 class EventTimer {
 public:
     struct Event {
@@ -21,8 +24,20 @@ public:
     bool hasPendingEvents() const;
     uint64_t getNextEventCycle() const;
     inline bool isEventPassed(uint64_t currentCycles) { return currentCycles >= next_event_cycle; }
+
+    /**
+     * Snapshots hold each pending event's trigger cycle and instanceID, but not
+     * its callback. restoreState() empties the queue; each device then calls
+     * rearmEvent() for the instanceIDs it owns, and endRestore() drops any
+     * saved event nobody claimed.
+     */
+    void saveState(SnapshotWriter &w);
+    bool restoreState(SnapshotReader &r);
+    bool rearmEvent(uint64_t instanceID, void (*callback)(uint64_t, void*), void* userData = nullptr);
+    void endRestore();
     
 private:
     std::vector<Event> events;
+    std::vector<Event> restored;
     void updateNextEventCycle();
 };
@@ -0,0 +1,184 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cinttypes>
+
+#include "util/FrameMetrics.hpp"
+
+static const char *stage_names[NUM_METRIC_STAGES] = {
+    "cpu", "events", "audio", "devices", "render", "present", "frame"
+};
+
+static int highest_bit(uint64_t v) {
+    int bit = 0;
+    while (v >>= 1) bit++;
+    return bit;
+}
+
+void MetricHistogram::add(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    int index;
+    if (us < (1 << SUB_BITS)) {
+        index = (int)us;
+    } else {
+        int msb = highest_bit(us);
+        index = ((msb - SUB_BITS + 1) << SUB_BITS) + (int)((us >> (msb - SUB_BITS)) & ((1 << SUB_BITS) - 1));
+    }
+    buckets[index]++;
+    count++;
+    if (ns > max) max = ns;
+}
+
+void MetricHistogram::reset() {
+    for (int i = 0; i < NUM_BUCKETS; i++) buckets[i] = 0;
+    count = 0;
+    max = 0;
+}
+
+/** The top of the bucket the percentile falls in, so it never reads low. */
+uint64_t MetricHistogram::percentile_ns(double p) const {
+    if (count == 0) return 0;
+    uint64_t rank = (uint64_t)(p / 100.0 * (double)count + 0.999999);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen < rank) continue;
+
+        uint64_t top_us;
+        if (i < (1 << SUB_BITS)) {
+            top_us = i;
+        } else {
+            int msb = (i >> SUB_BITS) + SUB_BITS - 1;
+            uint64_t low = (uint64_t)((1 << SUB_BITS) + (i & ((1 << SUB_BITS) - 1))) << (msb - SUB_BITS);
+            top_us = low + ((uint64_t)1 << (msb - SUB_BITS)) - 1;
+        }
+        uint64_t top_ns = top_us * 1000 + 999;
+        return top_ns < max ? top_ns : max;
+    }
+    return max;
+}
+
+FrameMetrics::FrameMetrics() {
+}
+
+FrameMetrics::~FrameMetrics() {
+    close_json();
+}
+
+bool FrameMetrics::open_json(const std::string &path) {
+    close_json();
+    json = fopen(path.c_str(), "w");
+    if (!json) {
+        fprintf(stderr, "Could not open metrics file %s\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void FrameMetrics::close_json() {
+    if (json) {
+        fclose(json);
+        json = nullptr;
+    }
+}
+
+void FrameMetrics::end_frame(uint64_t start_ns, uint64_t cpu_cycles, frame_counters_t &counters) {
+    for (int i = 0; i < NUM_METRIC_STAGES; i++) {
+        frame_ns[i] += host_ns[i].exchange(0, std::memory_order_relaxed);
+    }
+
+    // the first frame has nothing to measure its length from.
+    bool have_length = last_start_ns != 0;
+    frame_ns[METRIC_FRAME] = have_length ? start_ns - last_start_ns : 0;
+    last_start_ns = start_ns;
+
+    for (int i = 0; i < NUM_METRIC_STAGES; i++) {
+        if (i == METRIC_FRAME && !have_length) continue;
+        window[i].add(frame_ns[i]);
+        run[i].add(frame_ns[i]);
+    }
+
+    double mhz = frame_ns[METRIC_FRAME] ? (double)cpu_cycles * 1000.0 / (double)frame_ns[METRIC_FRAME] : 0;
+    if (json) {
+        fprintf(json, "{\"frame\":%" PRIu64 ",\"start_ns\":%" PRIu64, frame_number, start_ns);
+        for (int i = 0; i < NUM_METRIC_STAGES; i++) {
+            fprintf(json, ",\"%s_ns\":%" PRIu64, stage_names[i], frame_ns[i]);
+        }
+        fprintf(json, ",\"cycles\":%" PRIu64 ",\"mhz\":%.4f,\"instructions\":%" PRIu64 ",\"bus_cycles\":%" PRIu64
+            ",\"irqs\":%" PRIu64 ",\"remaps\":%" PRIu64 ",\"disk_nibbles\":%" PRIu64 "}\n",
+            cpu_cycles, mhz, counters.instructions, counters.bus_cycles, counters.irqs, counters.remaps, counters.disk_nibbles);
+    }
+
+    window_counters.instructions += counters.instructions;
+    window_counters.bus_cycles += counters.bus_cycles;
+    window_counters.irqs += counters.irqs;
+    window_counters.remaps += counters.remaps;
+    window_counters.disk_nibbles += counters.disk_nibbles;
+    if (have_length) {
+        window_cycles += cpu_cycles;
+        window_ns += frame_ns[METRIC_FRAME];
+    }
+    window_frames++;
+    frame_number++;
+
+    counters = frame_counters_t();
+    for (int i = 0; i < NUM_METRIC_STAGES; i++) frame_ns[i] = 0;
+
+    if (window_frames < WINDOW_FRAMES) return;
+
+    metrics_report_t r;
+    r.frames = frame_number;
+    for (int i = 0; i < NUM_METRIC_STAGES; i++) {
+        r.stage[i].p50_ns = window[i].percentile_ns(50);
+        r.stage[i].p99_ns = window[i].percentile_ns(99);
+        r.stage[i].max_ns = window[i].max_ns();
+        window[i].reset();
+    }
+    r.counters.instructions = window_counters.instructions / window_frames;
+    r.counters.bus_cycles = window_counters.bus_cycles / window_frames;
+    r.counters.irqs = window_counters.irqs / window_frames;
+    r.counters.remaps = window_counters.remaps / window_frames;
+    r.counters.disk_nibbles = window_counters.disk_nibbles / window_frames;
+    r.mhz = window_ns ? (double)window_cycles * 1000.0 / (double)window_ns : 0;
+
+    window_counters = frame_counters_t();
+    window_frames = 0;
+    window_cycles = 0;
+    window_ns = 0;
+
+    std::lock_guard<std::mutex> lock(report_lock);
+    last_report = r;
+}
+
+metrics_report_t FrameMetrics::report() {
+    std::lock_guard<std::mutex> lock(report_lock);
+    return last_report;
+}
+
+void FrameMetrics::print_summary(FILE *out) {
+    fprintf(out, "frame metrics over %" PRIu64 " frames\n", frame_number);
+    fprintf(out, "  %-8s %8s %8s %8s (ms)\n", "", "p50", "p99", "max");
+    for (int i = 0; i < NUM_METRIC_STAGES; i++) {
+        fprintf(out, "  %-8s %8.3f %8.3f %8.3f\n", stage_names[i],
+            run[i].percentile_ns(50) / 1.0E6, run[i].percentile_ns(99) / 1.0E6, run[i].max_ns() / 1.0E6);
+    }
+}
+
+const char *FrameMetrics::stage_name(metric_stage_t stage) {
+    return stage_names[stage];
+}
@@ -0,0 +1,141 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+/**
+ * Where a frame's host time goes. The emulation thread times the CPU burst,
+ * audio, device frames and drawing the frame; the main thread times polling
+ * and handling host events and presenting.
+ */
+enum metric_stage_t {
+    METRIC_CPU = 0,
+    METRIC_EVENTS,
+    METRIC_AUDIO,
+    METRIC_DEVICES,
+    METRIC_RENDER,
+    METRIC_PRESENT,
+    METRIC_FRAME,       // start of one frame to the start of the next
+    NUM_METRIC_STAGES
+};
+
+/**
+ * What the machine did in a frame. These live in cpu_state, are bumped by
+ * the CPU and devices as they go, and are zeroed when the frame is closed.
+ * They're host statistics and aren't part of a snapshot.
+ */
+struct frame_counters_t {
+    uint64_t instructions = 0;
+    uint64_t bus_cycles = 0;
+    uint64_t irqs = 0;
+    uint64_t remaps = 0;        // soft switches that rebuilt the memory map
+    uint64_t disk_nibbles = 0;  // nibbles passed under a Disk II head
+};
+
+/**
+ * Log-linear histogram of durations in microseconds: 16 buckets per power of
+ * two, so any percentile is within about 6%, in under 2KB.
+ */
+class MetricHistogram {
+public:
+    static const int SUB_BITS = 4;
+    static const int NUM_BUCKETS = (64 - SUB_BITS + 1) << SUB_BITS;
+
+    void add(uint64_t ns);
+    void reset();
+    uint64_t percentile_ns(double p) const;     // p in 0..100
+    uint64_t max_ns() const { return max; }
+    uint64_t samples() const { return count; }
+
+protected:
+    uint32_t buckets[NUM_BUCKETS] = {};
+    uint64_t count = 0;
+    uint64_t max = 0;
+};
+
+struct metric_summary_t {
+    uint64_t p50_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t max_ns = 0;
+};
+
+/**
+ * Per-frame timings of every stage, what the machine did, and the effective
+ * clock rate, over a window of recent frames - for the HUD - and the whole
+ * run. Each frame can also go out as one line of JSON.
+ */
+struct metrics_report_t {
+    uint64_t frames = 0;
+    metric_summary_t stage[NUM_METRIC_STAGES];
+    frame_counters_t counters;                  // per frame, averaged over the window
+    double mhz = 0;
+};
+
+class FrameMetrics {
+public:
+    static const uint64_t WINDOW_FRAMES = 120;
+
+    FrameMetrics();
+    ~FrameMetrics();
+
+    bool open_json(const std::string &path);
+    void close_json();
+
+    /** Emulation thread: time spent in a stage of the current frame. */
+    void record(metric_stage_t stage, uint64_t ns) { frame_ns[stage] += ns; }
+
+    /** Main thread: time spent in a stage, added to whichever frame is running. */
+    void record_host(metric_stage_t stage, uint64_t ns) { host_ns[stage].fetch_add(ns, std::memory_order_relaxed); }
+
+    /**
+     * Emulation thread: close the frame that started at start_ns and ran
+     * cpu_cycles, taking its counters and clearing them for the next one.
+     */
+    void end_frame(uint64_t start_ns, uint64_t cpu_cycles, frame_counters_t &counters);
+
+    /** The last full window. Safe from any thread. */
+    metrics_report_t report();
+
+    /** Whole run so far; for the log at exit. */
+    void print_summary(FILE *out);
+
+    static const char *stage_name(metric_stage_t stage);
+
+protected:
+    uint64_t frame_ns[NUM_METRIC_STAGES] = {};
+    std::atomic<uint64_t> host_ns[NUM_METRIC_STAGES] = {};
+    uint64_t last_start_ns = 0;
+    uint64_t frame_number = 0;
+
+    MetricHistogram window[NUM_METRIC_STAGES];
+    MetricHistogram run[NUM_METRIC_STAGES];
+    frame_counters_t window_counters;
+    uint64_t window_frames = 0;
+    uint64_t window_cycles = 0;
+    uint64_t window_ns = 0;
+
+    std::mutex report_lock;
+    metrics_report_t last_report;
+
+    FILE *json = nullptr;
+};
@@ -0,0 +1,36 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "util/FramePacer.hpp"
+
+// correct an eighth of the queue error each frame, so one late frame doesn't make the next one jump.
+#define PACER_GAIN_DIVISOR 8
+#define PACER_MAX_ADJUST_DIVISOR 100
+
+FramePacer::FramePacer(double sample_rate, int64_t target_samples)
+    : ns_per_sample(1000000000.0 / sample_rate), target(target_samples) {
+}
+
+uint64_t FramePacer::frame_ns(uint64_t nominal_ns, int64_t queued_samples) const {
+    if (queued_samples < 0) return nominal_ns;
+
+    int64_t adjust = (int64_t)((queued_samples - target) * ns_per_sample / PACER_GAIN_DIVISOR);
+    int64_t limit = (int64_t)(nominal_ns / PACER_MAX_ADJUST_DIVISOR);
+    if (adjust > limit) adjust = limit;
+    if (adjust < -limit) adjust = -limit;
+    return nominal_ns + adjust;
+}
@@ -0,0 +1,42 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Paces frames to the audio device. The emulated length of a frame is
+ * stretched or shrunk by up to 1% to hold the audio queue near a target
+ * depth, so over time the machine runs at the rate the device plays samples
+ * and the queue never runs dry or builds up latency.
+ */
+class FramePacer {
+public:
+    FramePacer(double sample_rate, int64_t target_samples);
+
+    /**
+     * Wall-clock length for a frame of nominal_ns emulated time, given the
+     * samples still queued just after the frame's audio went in. A negative
+     * count (no audio playing) leaves the frame at its nominal length.
+     */
+    uint64_t frame_ns(uint64_t nominal_ns, int64_t queued_samples) const;
+
+protected:
+    double ns_per_sample;
+    int64_t target;
+};
@@ -0,0 +1,67 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "util/SPSCQueue.hpp"
+
+/**
+ * Hands finished frames from the thread that makes them to the thread that
+ * shows them, without locks and without either one waiting on the other.
+ *
+ * The producer acquire()s a free frame, fills it and publish()es it. If
+ * every frame is still queued or on screen, acquire() returns nullptr and
+ * the producer just doesn't publish that one. The consumer takes the
+ * latest() frame, dropping any older ones it didn't get to, and release()s
+ * it once it's done with it.
+ */
+template <typename T, size_t FRAMES = 3>
+class FrameQueue {
+    static_assert(FRAMES < 8, "FrameQueue holds at most 7 frames");
+
+public:
+    FrameQueue() {
+        for (size_t i = 0; i < FRAMES; i++) {
+            free_frames.push(&frames[i]);
+        }
+    }
+
+    T *acquire() {
+        T *frame = nullptr;
+        free_frames.pop(frame);
+        return frame;
+    }
+
+    void publish(T *frame) { ready_frames.push(frame); }
+
+    T *latest() {
+        T *frame = nullptr;
+        T *newer;
+        while (ready_frames.pop(newer)) {
+            if (frame) free_frames.push(frame);
+            frame = newer;
+        }
+        return frame;
+    }
+
+    void release(T *frame) { free_frames.push(frame); }
+
+protected:
+    T frames[FRAMES];
+    SPSCQueue<T *, 8> free_frames;
+    SPSCQueue<T *, 8> ready_frames;
+};
@@ -0,0 +1,157 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "util/InputLog.hpp"
+
+void InputLog::register_handler(input_event_type_t type, ApplyHandler handler) {
+    handlers[type] = handler;
+}
+
+InputLog::~InputLog() {
+    stop_file();
+}
+
+void InputLog::set_recording(bool on) {
+    recording = on;
+    if (!on && !replaying) clear();
+}
+
+void InputLog::record(uint64_t cycle, input_event_type_t type, uint64_t data, const std::string &text) {
+    if (applying || (!recording && !file.is_open())) return; // a replayed event is already logged
+    input_event_t event = {cycle, type, data, text};
+    if (file.is_open()) write_event(event);
+    if (!recording) return;
+    events.resize(cursor);
+    events.push_back(std::move(event));
+    cursor = events.size();
+}
+
+bool InputLog::start_file(const std::string &filename, const std::vector<uint8_t> &snapshot) {
+    stop_file();
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        fprintf(stderr, "Failed to open input recording: %s\n", filename.c_str());
+        return false;
+    }
+    uint32_t version = INPUT_LOG_FORMAT_VERSION;
+    uint64_t length = snapshot.size();
+    file.write(INPUT_LOG_MAGIC, 4);
+    file.write((const char *)&version, sizeof(version));
+    file.write((const char *)&length, sizeof(length));
+    file.write((const char *)snapshot.data(), snapshot.size());
+    file.flush();
+    return (bool)file;
+}
+
+void InputLog::stop_file() {
+    if (file.is_open()) file.close();
+}
+
+void InputLog::write_event(const input_event_t &event) {
+    uint16_t type = event.type;
+    uint32_t length = (uint32_t)event.text.size();
+    file.write((const char *)&event.cycle, sizeof(event.cycle));
+    file.write((const char *)&type, sizeof(type));
+    file.write((const char *)&event.data, sizeof(event.data));
+    file.write((const char *)&length, sizeof(length));
+    file.write(event.text.data(), length);
+    // input is rare; flushing each event keeps a recording good up to a crash.
+    file.flush();
+}
+
+bool InputLog::load_file(const std::string &filename, std::vector<uint8_t> &snapshot) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        fprintf(stderr, "Failed to open input recording: %s\n", filename.c_str());
+        return false;
+    }
+    char magic[4];
+    uint32_t version;
+    uint64_t length;
+    if (!in.read(magic, 4) || memcmp(magic, INPUT_LOG_MAGIC, 4) != 0
+        || !in.read((char *)&version, sizeof(version)) || version != INPUT_LOG_FORMAT_VERSION
+        || !in.read((char *)&length, sizeof(length))) {
+        fprintf(stderr, "Not an input recording: %s\n", filename.c_str());
+        return false;
+    }
+    snapshot.resize(length);
+    if (!in.read((char *)snapshot.data(), length)) {
+        fprintf(stderr, "Input recording %s is truncated\n", filename.c_str());
+        return false;
+    }
+
+    clear();
+    while (true) {
+        input_event_t event;
+        uint16_t type;
+        uint32_t text_length;
+        if (!in.read((char *)&event.cycle, sizeof(event.cycle))) break;
+        if (!in.read((char *)&type, sizeof(type)) || !in.read((char *)&event.data, sizeof(event.data))
+            || !in.read((char *)&text_length, sizeof(text_length))) {
+            fprintf(stderr, "Input recording %s ends mid-event; replaying what is there\n", filename.c_str());
+            break;
+        }
+        event.text.resize(text_length);
+        if (!in.read(&event.text[0], text_length)) {
+            fprintf(stderr, "Input recording %s ends mid-event; replaying what is there\n", filename.c_str());
+            break;
+        }
+        if (type == 0 || type >= NUM_INPUT_EVENT_TYPES) {
+            fprintf(stderr, "Input recording %s has unknown event type %d\n", filename.c_str(), type);
+            clear();
+            return false;
+        }
+        event.type = (input_event_type_t)type;
+        events.push_back(std::move(event));
+    }
+    cursor = 0;
+    replaying = true;
+    return true;
+}
+
+void InputLog::seek(uint64_t cycle) {
+    cursor = std::upper_bound(events.begin(), events.end(), cycle,
+        [](uint64_t c, const input_event_t &e) { return c < e.cycle; }) - events.begin();
+}
+
+void InputLog::discard_before(uint64_t cycle) {
+    auto end = std::lower_bound(events.begin(), events.end(), cycle,
+        [](const input_event_t &e, uint64_t c) { return e.cycle < c; });
+    size_t n = end - events.begin();
+    if (n == 0) return;
+    events.erase(events.begin(), end);
+    cursor = (cursor > n) ? cursor - n : 0;
+}
+
+void InputLog::clear() {
+    events.clear();
+    cursor = 0;
+}
+
+void InputLog::apply(const input_event_t &event) {
+    if (handlers[event.type]) {
+        applying = true;
+        handlers[event.type](event);
+        applying = false;
+    } else {
+        fprintf(stderr, "InputLog: no handler for input event type %d\n", event.type);
+    }
+}
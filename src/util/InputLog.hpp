@@ -0,0 +1,139 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+enum input_event_type_t : uint16_t {
+    INPUT_KEY = 1,      // data: key code latched into the keyboard
+    INPUT_PASTE,        // text: clipboard text queued for the keyboard
+    INPUT_RESET,        // data: 1 for a cold start
+    INPUT_ANY_KEY,      // data: 1 while any key is held (IIe AKD)
+    INPUT_GAME,         // data: paddles 0-3 in bytes 0-3, buttons in byte 4
+    INPUT_MOUNT,        // data: slot << 8 | drive, text: media filename
+    INPUT_UNMOUNT,      // data: slot << 8 | drive
+    INPUT_CLOCK,        // data: bits of the double cycle_duration_ns for the frame
+    NUM_INPUT_EVENT_TYPES
+};
+
+struct input_event_t {
+    uint64_t cycle;
+    input_event_type_t type;
+    uint64_t data;
+    std::string text;
+};
+
+/**
+ * Log of input that reached the machine from outside, with the cycle it
+ * arrived at. Devices record input as they apply it, and register a handler
+ * that applies a logged event again. Re-executing from a snapshot and
+ * calling replay() before each instruction then sees the same input at the
+ * same cycles as the first time through.
+ *
+ * Nothing is kept unless recording is on.
+ *
+ * A log can also be streamed to a file, after the snapshot it starts from,
+ * and loaded back to replay a whole session:
+ *
+ *   header:  "GS2I" magic, uint32 format version, uint64 snapshot length, snapshot
+ *   events:  uint64 cycle, uint16 type, uint64 data, uint32 text length, text
+ */
+
+#define INPUT_LOG_MAGIC "GS2I"
+#define INPUT_LOG_FORMAT_VERSION 1
+
+class InputLog {
+public:
+    using ApplyHandler = std::function<void (const input_event_t &)>;
+
+    void register_handler(input_event_type_t type, ApplyHandler handler);
+
+    ~InputLog();
+
+    /**
+     * Turning recording off forgets the log, unless it is being replayed.
+     */
+    void set_recording(bool on);
+    bool is_recording() const { return recording; }
+
+    /**
+     * Also write every event recorded from now on to filename, after the
+     * snapshot the machine is starting from. Returns false if the file
+     * can't be written.
+     */
+    bool start_file(const std::string &filename, const std::vector<uint8_t> &snapshot);
+    void stop_file();
+    bool is_streaming() const { return file.is_open(); }
+
+    /**
+     * Replace the log with a recording, positioned at its start, and go into
+     * replay: live input should stay out until replay_done(). snapshot gets
+     * the state the recording starts from.
+     */
+    bool load_file(const std::string &filename, std::vector<uint8_t> &snapshot);
+    void stop_replay() { replaying = false; }
+    bool is_replaying() const { return replaying; }
+    bool replay_done() const { return cursor >= events.size(); }
+
+    /** True while a handler is applying a logged event. */
+    bool is_applying() const { return applying; }
+
+    /**
+     * Log input that was just applied live. Logged events still ahead of the
+     * replay position are dropped first: new input means a different future.
+     */
+    void record(uint64_t cycle, input_event_type_t type, uint64_t data = 0, const std::string &text = std::string());
+
+    /**
+     * Position replay just after everything at or before cycle - the state a
+     * snapshot taken at that cycle already includes.
+     */
+    void seek(uint64_t cycle);
+
+    /**
+     * Apply logged events due at or before now.
+     */
+    inline void replay(uint64_t now) {
+        while (cursor < events.size() && events[cursor].cycle <= now) {
+            apply(events[cursor++]);
+        }
+    }
+
+    /** Forget events before cycle, once nothing can replay from there. */
+    void discard_before(uint64_t cycle);
+    void clear();
+
+    size_t size() const { return events.size(); }
+
+protected:
+    std::vector<input_event_t> events;
+    size_t cursor = 0;          // next event for replay(); == size() when live
+    bool recording = false;
+    bool replaying = false;
+    bool applying = false;
+    std::ofstream file;
+    ApplyHandler handlers[NUM_INPUT_EVENT_TYPES];
+
+    void write_event(const input_event_t &event);
+
+    void apply(const input_event_t &event);
+};
@@ -0,0 +1,148 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "LZ.hpp"
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 0xFFFF
+#define LZ_HASH_BITS 12
+
+static inline uint32_t lz_read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint32_t lz_hash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static inline uint8_t *lz_put_length(uint8_t *op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+size_t lz_compress_bound(size_t len) {
+    return len + (len / 255) + 16;
+}
+
+static uint8_t *lz_emit(uint8_t *op, const uint8_t *lit, size_t lit_len, size_t offset, size_t match_len) {
+    uint8_t *token = op++;
+    uint8_t t_lit = lit_len >= 15 ? 15 : (uint8_t)lit_len;
+    if (t_lit == 15) op = lz_put_length(op, lit_len - 15);
+    if (lit_len) memcpy(op, lit, lit_len);
+    op += lit_len;
+
+    uint8_t t_match = 0;
+    if (match_len) {
+        *op++ = offset & 0xFF;
+        *op++ = (offset >> 8) & 0xFF;
+        size_t ml = match_len - LZ_MIN_MATCH;
+        t_match = ml >= 15 ? 15 : (uint8_t)ml;
+        if (t_match == 15) op = lz_put_length(op, ml - 15);
+    }
+    *token = (t_lit << 4) | t_match;
+    return op;
+}
+
+size_t lz_compress(const uint8_t *src, size_t len, uint8_t *dst) {
+    uint32_t table[1 << LZ_HASH_BITS];
+    memset(table, 0xFF, sizeof(table));
+
+    uint8_t *op = dst;
+    size_t anchor = 0;
+    size_t ip = 0;
+
+    while (len >= LZ_MIN_MATCH && ip <= len - LZ_MIN_MATCH) {
+        uint32_t seq = lz_read32(src + ip);
+        uint32_t h = lz_hash(seq);
+        uint32_t cand = table[h];
+        table[h] = (uint32_t)ip;
+
+        if (cand == 0xFFFFFFFF || ip - cand > LZ_MAX_OFFSET || lz_read32(src + cand) != seq) {
+            ip++;
+            continue;
+        }
+
+        size_t match_len = LZ_MIN_MATCH;
+        while (ip + match_len < len && src[cand + match_len] == src[ip + match_len]) match_len++;
+
+        op = lz_emit(op, src + anchor, ip - anchor, ip - cand, match_len);
+        ip += match_len;
+        anchor = ip;
+    }
+
+    // trailing literals. Always emit a final sequence so the decoder has a terminator.
+    op = lz_emit(op, src + anchor, len - anchor, 0, 0);
+    return op - dst;
+}
+
+bool lz_decompress(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len) {
+    const uint8_t *ip = src;
+    const uint8_t *iend = src + src_len;
+    uint8_t *op = dst;
+    uint8_t *oend = dst + dst_len;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        size_t lit_len = token >> 4;
+        if (lit_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) return false;
+                b = *ip++;
+                lit_len += b;
+            } while (b == 255);
+        }
+        if (lit_len > (size_t)(iend - ip) || lit_len > (size_t)(oend - op)) return false;
+        if (lit_len) memcpy(op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+
+        if (ip >= iend) break; // final, literals-only sequence.
+
+        if (iend - ip < 2) return false;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) return false;
+
+        size_t match_len = token & 0x0F;
+        if (match_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) return false;
+                b = *ip++;
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += LZ_MIN_MATCH;
+        if (match_len > (size_t)(oend - op)) return false;
+
+        // byte-at-a-time: matches may overlap their own output (runs).
+        const uint8_t *m = op - offset;
+        for (size_t i = 0; i < match_len; i++) op[i] = m[i];
+        op += match_len;
+    }
+    return op == oend;
+}
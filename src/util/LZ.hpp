@@ -0,0 +1,48 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * A small LZ77 codec (LZ4-style block format) for things we want smaller on
+ * disk but fast to unpack: disk image chunks, trace segments, snapshots.
+ *
+ * Sequence: token (hi nibble literal count, lo nibble match length - 4),
+ * extra literal-count bytes if hi nibble == 15, the literals, a 2-byte
+ * little-endian match offset, extra match-length bytes if lo nibble == 15.
+ * The last sequence is literals only.
+ */
+
+/**
+ * Worst-case compressed size for len input bytes.
+ */
+size_t lz_compress_bound(size_t len);
+
+/**
+ * Compress src into dst (at least lz_compress_bound(len) bytes).
+ * Returns the compressed size.
+ */
+size_t lz_compress(const uint8_t *src, size_t len, uint8_t *dst);
+
+/**
+ * Decompress exactly dst_len bytes. Returns false if the input is malformed
+ * or doesn't produce exactly dst_len bytes.
+ */
+bool lz_decompress(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len);
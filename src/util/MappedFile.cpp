@@ -0,0 +1,173 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "util/MappedFile.hpp"
+
+MappedFile::MappedFile() {
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string &path, bool ro) {
+    close();
+    filename = path;
+    read_only = ro;
+
+    HANDLE fh = CreateFileA(path.c_str(), ro ? GENERIC_READ : (GENERIC_READ | GENERIC_WRITE),
+        FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fh == INVALID_HANDLE_VALUE) {
+        std::cerr << "MappedFile: could not open " << path << std::endl;
+        return false;
+    }
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(fh, &sz) || sz.QuadPart == 0) {
+        std::cerr << "MappedFile: empty or unreadable file " << path << std::endl;
+        CloseHandle(fh);
+        return false;
+    }
+    HANDLE mh = CreateFileMappingA(fh, NULL, ro ? PAGE_READONLY : PAGE_READWRITE, 0, 0, NULL);
+    if (mh == NULL) {
+        std::cerr << "MappedFile: could not map " << path << std::endl;
+        CloseHandle(fh);
+        return false;
+    }
+    void *p = MapViewOfFile(mh, ro ? FILE_MAP_READ : FILE_MAP_WRITE, 0, 0, 0);
+    if (p == NULL) {
+        std::cerr << "MappedFile: could not map view of " << path << std::endl;
+        CloseHandle(mh);
+        CloseHandle(fh);
+        return false;
+    }
+    file_handle = fh;
+    map_handle = mh;
+    base = (uint8_t *)p;
+    map_size = (size_t)sz.QuadPart;
+    dirty = false;
+    return true;
+}
+
+void MappedFile::close() {
+    if (base == nullptr) return;
+    flush();
+    UnmapViewOfFile(base);
+    CloseHandle((HANDLE)map_handle);
+    CloseHandle((HANDLE)file_handle);
+    base = nullptr;
+    map_handle = nullptr;
+    file_handle = nullptr;
+    map_size = 0;
+}
+
+void MappedFile::flush_async() {
+    if (!dirty) return;
+    // FlushViewOfFile queues the write and returns without waiting for the disk.
+    FlushViewOfFile(base + dirty_lo, dirty_hi - dirty_lo);
+    dirty = false;
+}
+
+void MappedFile::flush() {
+    if (base == nullptr || read_only) return;
+    // earlier async flushes may still be in flight, so always sync the whole view.
+    FlushViewOfFile(base, 0);
+    FlushFileBuffers((HANDLE)file_handle);
+    dirty = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string &path, bool ro) {
+    close();
+    filename = path;
+    read_only = ro;
+
+    int f = ::open(path.c_str(), ro ? O_RDONLY : O_RDWR);
+    if (f < 0) {
+        std::cerr << "MappedFile: could not open " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(f, &st) != 0 || st.st_size == 0) {
+        std::cerr << "MappedFile: empty or unreadable file " << path << std::endl;
+        ::close(f);
+        return false;
+    }
+    void *p = mmap(nullptr, (size_t)st.st_size, ro ? PROT_READ : (PROT_READ | PROT_WRITE), MAP_SHARED, f, 0);
+    if (p == MAP_FAILED) {
+        std::cerr << "MappedFile: could not map " << path << std::endl;
+        ::close(f);
+        return false;
+    }
+    fd = f;
+    base = (uint8_t *)p;
+    map_size = (size_t)st.st_size;
+    dirty = false;
+    return true;
+}
+
+void MappedFile::close() {
+    if (base == nullptr) return;
+    flush();
+    munmap(base, map_size);
+    ::close(fd);
+    base = nullptr;
+    fd = -1;
+    map_size = 0;
+}
+
+void MappedFile::flush_async() {
+    if (!dirty) return;
+    // msync wants a page-aligned start address.
+    size_t pagesz = (size_t)sysconf(_SC_PAGESIZE);
+    size_t lo = dirty_lo & ~(pagesz - 1);
+    msync(base + lo, dirty_hi - lo, MS_ASYNC);
+    dirty = false;
+}
+
+void MappedFile::flush() {
+    if (base == nullptr || read_only) return;
+    // earlier async flushes may still be in flight, so always sync the whole mapping.
+    msync(base, map_size, MS_SYNC);
+    dirty = false;
+}
+
+#endif
+
+void MappedFile::mark_dirty(size_t offset, size_t len) {
+    if (!dirty) {
+        dirty_lo = offset;
+        dirty_hi = offset + len;
+        dirty = true;
+        return;
+    }
+    if (offset < dirty_lo) dirty_lo = offset;
+    if (offset + len > dirty_hi) dirty_hi = offset + len;
+}
@@ -0,0 +1,83 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * A MappedFile is a disk image (or any other file) mapped directly into our
+ * address space. Block devices read and write the mapping instead of going
+ * through fseek/fread/fwrite, and let the host OS page data in and out.
+ *
+ * Writes land in the mapping immediately. flush_async() asks the OS to start
+ * writing dirty pages back without waiting; flush() waits for it.
+ */
+class MappedFile {
+private:
+    std::string filename;
+    uint8_t *base = nullptr;
+    size_t map_size = 0;
+    bool read_only = false;
+    bool dirty = false;
+    size_t dirty_lo = 0;    // byte range touched since the last flush
+    size_t dirty_hi = 0;
+#ifdef _WIN32
+    void *file_handle = nullptr;
+    void *map_handle = nullptr;
+#else
+    int fd = -1;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    /**
+     * Map the entire file. Returns false (and prints why) on failure.
+     */
+    bool open(const std::string &path, bool read_only);
+
+    /**
+     * Flush any outstanding writes and unmap the file.
+     */
+    void close();
+
+    bool is_open() { return base != nullptr; }
+    const std::string &get_filename() { return filename; }
+    bool is_read_only() { return read_only; }
+    bool is_dirty() { return dirty; }
+    uint8_t *data() { return base; }
+    size_t size() { return map_size; }
+
+    /**
+     * Note that the caller wrote into the mapping at [offset, offset+len).
+     */
+    void mark_dirty(size_t offset, size_t len);
+
+    /**
+     * Schedule write-back of dirty pages without blocking the caller.
+     */
+    void flush_async();
+
+    /**
+     * Write back dirty pages and wait for completion.
+     */
+    void flush();
+};
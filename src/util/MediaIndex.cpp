@@ -0,0 +1,383 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include <mutex>
+#include <cstring>
+#include <cinttypes>
+
+#include "util/MediaIndex.hpp"
+#include "util/MappedFile.hpp"
+#include "util/ChunkedImage.hpp"
+#include "util/ThreadPool.hpp"
+
+namespace fs = std::filesystem;
+
+#define MEDIA_INDEX_HEADER "#GS2 media index 1"
+
+static const char *indexed_suffixes[] = { ".2mg", ".hdv", ".do", ".dsk", ".po", ".nib", ".gsc" };
+
+static bool is_media_file(const std::string &path) {
+    for (const char *suffix : indexed_suffixes) {
+        if (compare_suffix(path, suffix)) return true;
+    }
+    return false;
+}
+
+/**
+ * Index keys are absolute paths, so "scan lib" and "scan /path/to/lib" agree.
+ */
+static std::string normalize_path(const std::string &path) {
+    std::error_code ec;
+    fs::path p = fs::absolute(path, ec);
+    if (ec) return path;
+    return p.lexically_normal().string();
+}
+
+static bool is_separator(char c) {
+    return c == '/' || c == (char)fs::path::preferred_separator;
+}
+
+static uint64_t fnv1a64(const uint8_t *data, size_t len) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static bool stat_file(const std::string &path, int64_t &mtime, uint64_t &size) {
+    std::error_code ec;
+    size = fs::file_size(path, ec);
+    if (ec) return false;
+    mtime = (int64_t)fs::last_write_time(path, ec).time_since_epoch().count();
+    return !ec;
+}
+
+/**
+ * ProDOS block n of a 140K DOS-order image lives in two DOS logical sectors.
+ */
+static const uint8_t do_block_sectors[8][2] = {
+    { 0x0, 0xE }, { 0xD, 0xC }, { 0xB, 0xA }, { 0x9, 0x8 },
+    { 0x7, 0x6 }, { 0x5, 0x4 }, { 0x3, 0x2 }, { 0x1, 0xF }
+};
+
+static bool read_prodos_block(const uint8_t *data, size_t len, media_interleave_t interleave, uint32_t block, uint8_t *out) {
+    if (interleave == INTERLEAVE_DO) {
+        uint32_t track = block / 8;
+        for (int half = 0; half < 2; half++) {
+            size_t off = ((size_t)track * 16 + do_block_sectors[block % 8][half]) * 256;
+            if (off + 256 > len) return false;
+            memcpy(out + half * 256, data + off, 256);
+        }
+        return true;
+    }
+    size_t off = (size_t)block * 512;
+    if (off + 512 > len) return false;
+    memcpy(out, data + off, 512);
+    return true;
+}
+
+/**
+ * Volume name from the ProDOS volume directory (block 2), or the DOS 3.3
+ * VTOC (track 17 sector 0, which is at the same offset in DO and PO order).
+ */
+static std::string find_volume_name(const uint8_t *data, size_t len, media_interleave_t interleave) {
+    uint8_t blk[512];
+    if (read_prodos_block(data, len, interleave, 2, blk)) {
+        uint8_t storage_type = blk[4] >> 4;
+        uint8_t name_len = blk[4] & 0x0F;
+        if (storage_type == 0xF && name_len > 0) {
+            std::string name((const char *)blk + 5, name_len);
+            bool valid = std::all_of(name.begin(), name.end(), [](char c) {
+                return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.';
+            });
+            if (valid) return name;
+        }
+    }
+    size_t vtoc = 17 * 16 * 256;
+    if (len == 560 * 256 && data[vtoc + 0x27] == 122 && data[vtoc + 0x34] == 35 && data[vtoc + 0x35] == 16) {
+        return "DOS 3.3 V" + std::to_string(data[vtoc + 6]);
+    }
+    return "";
+}
+
+bool MediaIndex::index_file(const std::string &path, media_index_entry_t &entry) {
+    media_descriptor md;
+    md.filename = path;
+    if (identify_media(md, true) != 0) return false;
+
+    entry.path = path;
+    if (!stat_file(path, entry.mtime, entry.size)) return false;
+    entry.media_type = md.media_type;
+    entry.container = md.container;
+    entry.interleave = md.interleave;
+    entry.data_offset = md.data_offset;
+    entry.block_size = md.block_size;
+    entry.block_count = md.block_count;
+    entry.write_protected = md.write_protected;
+    entry.dos33_volume = md.dos33_volume;
+
+    // get the block data into memory: mapped for flat images, expanded for chunked ones.
+    MappedFile mapped;
+    std::vector<uint8_t> expanded;
+    const uint8_t *data = nullptr;
+    size_t len = 0;
+    if (md.container == CONTAINER_CHUNKED) {
+        ChunkedImage img(4);
+        if (!img.open(path, true)) return false;
+        expanded.resize((size_t)md.block_size * md.block_count);
+        for (uint32_t b = 0; b < md.block_count; b++) {
+            img.read_block(b, [&](const uint8_t *blk) {
+                memcpy(expanded.data() + (size_t)b * md.block_size, blk, md.block_size);
+            });
+        }
+        data = expanded.data();
+        len = expanded.size();
+    } else {
+        if (!mapped.open(path, true)) return false;
+        if (md.data_offset >= mapped.size()) return false;
+        data = mapped.data() + md.data_offset;
+        len = mapped.size() - md.data_offset;
+        if (md.data_size && md.data_size < len) len = md.data_size;
+    }
+
+    entry.content_hash = fnv1a64(data, len);
+    if (md.media_type == MEDIA_PRENYBBLE) {
+        // nybble streams have no sector structure we can read without decoding.
+        entry.boot_fingerprint = 0;
+        entry.volume_name.clear();
+    } else {
+        entry.boot_fingerprint = fnv1a64(data, len < 256 ? len : 256);
+        entry.volume_name = find_volume_name(data, len, md.interleave);
+    }
+    return true;
+}
+
+MediaIndex::MediaIndex(const std::string &index_path) : index_path(index_path) {
+}
+
+bool MediaIndex::load() {
+    std::ifstream in(index_path);
+    if (!in) return false;
+
+    std::string line;
+    if (!std::getline(in, line) || line != MEDIA_INDEX_HEADER) {
+        std::cerr << "MediaIndex: " << index_path << " is not a media index, ignoring it" << std::endl;
+        return false;
+    }
+    entries.clear();
+    while (std::getline(in, line)) {
+        std::vector<std::string> f;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, '\t')) f.push_back(field);
+        if (f.size() < 14) f.resize(14); // trailing empty volume name etc.
+        if (f[0].empty()) continue;
+
+        media_index_entry_t e;
+        e.path = f[0];
+        e.mtime = strtoll(f[1].c_str(), nullptr, 10);
+        e.size = strtoull(f[2].c_str(), nullptr, 10);
+        e.media_type = (media_type_t)atoi(f[3].c_str());
+        e.container = (media_container_t)atoi(f[4].c_str());
+        e.interleave = (media_interleave_t)atoi(f[5].c_str());
+        e.data_offset = strtoull(f[6].c_str(), nullptr, 10);
+        e.block_size = (uint16_t)atoi(f[7].c_str());
+        e.block_count = (uint32_t)strtoul(f[8].c_str(), nullptr, 10);
+        e.write_protected = atoi(f[9].c_str()) != 0;
+        e.dos33_volume = (uint16_t)atoi(f[10].c_str());
+        e.content_hash = strtoull(f[11].c_str(), nullptr, 16);
+        e.boot_fingerprint = strtoull(f[12].c_str(), nullptr, 16);
+        e.volume_name = f[13];
+        entries[e.path] = e;
+    }
+    return true;
+}
+
+bool MediaIndex::save() {
+    // write beside the real index and rename over it, so a crash never leaves half an index.
+    std::string tmp = index_path + ".tmp";
+    FILE *fp = fopen(tmp.c_str(), "w");
+    if (fp == nullptr) {
+        std::cerr << "MediaIndex: could not write " << tmp << std::endl;
+        return false;
+    }
+    fprintf(fp, "%s\n", MEDIA_INDEX_HEADER);
+
+    std::vector<const media_index_entry_t *> sorted;
+    for (auto &it : entries) sorted.push_back(&it.second);
+    std::sort(sorted.begin(), sorted.end(), [](auto a, auto b) { return a->path < b->path; });
+
+    for (const media_index_entry_t *e : sorted) {
+        fprintf(fp, "%s\t%" PRId64 "\t%" PRIu64 "\t%d\t%d\t%d\t%" PRIu64 "\t%u\t%u\t%d\t%u\t%016" PRIx64 "\t%016" PRIx64 "\t%s\n",
+            e->path.c_str(), e->mtime, e->size, (int)e->media_type, (int)e->container, (int)e->interleave,
+            e->data_offset, e->block_size, e->block_count, e->write_protected ? 1 : 0, e->dos33_volume,
+            e->content_hash, e->boot_fingerprint, e->volume_name.c_str());
+    }
+    bool ok = !ferror(fp);
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok) return false;
+
+    std::error_code ec;
+    fs::rename(tmp, index_path, ec);
+    return !ec;
+}
+
+media_scan_stats_t MediaIndex::scan(const std::vector<std::string> &roots, unsigned int num_threads) {
+    media_scan_stats_t stats;
+    std::vector<std::string> todo;
+    std::unordered_map<std::string, bool> seen;
+
+    std::vector<std::string> abs_roots;
+    for (const std::string &root : roots) abs_roots.push_back(normalize_path(root));
+    // a root we couldn't walk all of keeps its entries; we can't tell which files are gone.
+    std::vector<bool> complete(abs_roots.size(), true);
+
+    for (size_t r = 0; r < abs_roots.size(); r++) {
+        const std::string &root = abs_roots[r];
+        std::error_code ec;
+        fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec), end;
+        if (ec) {
+            std::cerr << "MediaIndex: cannot scan " << root << ": " << ec.message() << std::endl;
+            complete[r] = false;
+            continue;
+        }
+        for (; it != end; it.increment(ec)) {
+            if (ec) {
+                std::cerr << "MediaIndex: scan of " << root << " stopped early, keeping its old entries: " << ec.message() << std::endl;
+                complete[r] = false;
+                break;
+            }
+            if (!it->is_regular_file(ec)) continue;
+            std::string path = it->path().string();
+            if (!is_media_file(path)) continue;
+
+            stats.found++;
+            seen[path] = true;
+            int64_t mtime;
+            uint64_t size;
+            auto known = entries.find(path);
+            if (known != entries.end() && stat_file(path, mtime, size)
+                && known->second.mtime == mtime && known->second.size == size) {
+                stats.unchanged++;
+                continue;
+            }
+            todo.push_back(path);
+        }
+    }
+
+    // drop entries under the scanned roots whose files are gone.
+    for (auto it = entries.begin(); it != entries.end(); ) {
+        bool under_root = false;
+        for (size_t r = 0; r < abs_roots.size(); r++) {
+            const std::string &root = abs_roots[r];
+            if (!complete[r]) continue;
+            // a prefix match alone would take /media/lib2 for part of /media/lib.
+            if (it->first.size() > root.size() && it->first.compare(0, root.size(), root) == 0
+                && (is_separator(root.back()) || is_separator(it->first[root.size()]))) under_root = true;
+        }
+        if (under_root && !seen.count(it->first)) {
+            it = entries.erase(it);
+            stats.removed++;
+        } else it++;
+    }
+
+    std::mutex results_lock;
+    {
+        ThreadPool pool(num_threads);
+        for (const std::string &path : todo) {
+            pool.enqueue([this, path, &stats, &results_lock]() {
+                media_index_entry_t e;
+                bool ok = index_file(path, e);
+                std::lock_guard<std::mutex> lk(results_lock);
+                if (ok) {
+                    entries[path] = e;
+                    stats.indexed++;
+                } else {
+                    entries.erase(path);
+                    stats.failed++;
+                }
+            });
+        }
+        pool.wait_idle();
+    }
+    return stats;
+}
+
+const media_index_entry_t *MediaIndex::lookup(const std::string &path) {
+    auto it = entries.find(normalize_path(path));
+    if (it == entries.end()) return nullptr;
+    return &it->second;
+}
+
+bool MediaIndex::fill_descriptor(media_descriptor &md) {
+    const media_index_entry_t *e = lookup(md.filename);
+    if (e == nullptr) return false;
+    int64_t mtime;
+    uint64_t size;
+    if (!stat_file(md.filename, mtime, size) || mtime != e->mtime || size != e->size) return false;
+
+    md.media_type = e->media_type;
+    md.container = e->container;
+    md.interleave = e->interleave;
+    md.data_offset = e->data_offset;
+    md.block_size = e->block_size;
+    md.block_count = e->block_count;
+    md.file_size = e->size;
+    md.data_size = (uint64_t)e->block_size * e->block_count;
+    md.write_protected = e->write_protected;
+    md.dos33_volume = e->dos33_volume;
+    md.filestub = fs::path(md.filename).filename().string();
+    return true;
+}
+
+std::vector<const media_index_entry_t *> MediaIndex::find(const std::string &text) {
+    auto lower = [](std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        return s;
+    };
+    std::string needle = lower(text);
+    std::vector<const media_index_entry_t *> result;
+    for (auto &it : entries) {
+        const media_index_entry_t &e = it.second;
+        if (lower(fs::path(e.path).filename().string()).find(needle) != std::string::npos
+            || lower(e.volume_name).find(needle) != std::string::npos) {
+            result.push_back(&e);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](auto a, auto b) { return a->path < b->path; });
+    return result;
+}
+
+std::vector<std::vector<const media_index_entry_t *>> MediaIndex::duplicates() {
+    std::unordered_map<uint64_t, std::vector<const media_index_entry_t *>> by_hash;
+    for (auto &it : entries) by_hash[it.second.content_hash].push_back(&it.second);
+
+    std::vector<std::vector<const media_index_entry_t *>> result;
+    for (auto &it : by_hash) {
+        if (it.second.size() < 2) continue;
+        std::sort(it.second.begin(), it.second.end(), [](auto a, auto b) { return a->path < b->path; });
+        result.push_back(it.second);
+    }
+    return result;
+}
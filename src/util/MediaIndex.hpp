@@ -0,0 +1,104 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "util/media.hpp"
+
+/**
+ * What we know about one disk image, without having to open it again.
+ */
+struct media_index_entry_t {
+    std::string path;
+    int64_t mtime = 0;
+    uint64_t size = 0;
+    media_type_t media_type = MEDIA_BLK;
+    media_container_t container = CONTAINER_FLAT;
+    media_interleave_t interleave = INTERLEAVE_NONE;
+    uint64_t data_offset = 0;
+    uint16_t block_size = 0;
+    uint32_t block_count = 0;
+    bool write_protected = false;
+    uint16_t dos33_volume = 254;
+    std::string volume_name;        // ProDOS volume name, or "DOS 3.3 Vnnn"
+    uint64_t content_hash = 0;      // over the block data only, not container headers
+    uint64_t boot_fingerprint = 0;  // hash of track 0 sector 0 / block 0
+};
+
+struct media_scan_stats_t {
+    int found = 0;      // image files seen in the tree
+    int indexed = 0;    // new or changed, (re)read this scan
+    int unchanged = 0;  // mtime and size matched the index
+    int failed = 0;     // identify_media or reading failed
+    int removed = 0;    // in the index but gone from disk
+};
+
+/**
+ * MediaIndex is a persistent catalog of disk images built with identify_media().
+ *
+ * scan() walks directory trees on a thread pool, re-reading only files whose
+ * mtime or size changed since the last scan, and drops entries under a
+ * root whose files are gone - unless the walk of that root failed partway,
+ * in which case its entries are kept. The index is a tab-separated text
+ * file, one image per line.
+ */
+class MediaIndex {
+public:
+    MediaIndex(const std::string &index_path);
+
+    bool load();
+    bool save();
+
+    media_scan_stats_t scan(const std::vector<std::string> &roots, unsigned int num_threads = 0);
+
+    /**
+     * Entry for path, or nullptr if it isn't indexed.
+     */
+    const media_index_entry_t *lookup(const std::string &path);
+
+    /**
+     * Fill in md from the index if the file hasn't changed since it was
+     * indexed. Returns false if the caller should run identify_media().
+     */
+    bool fill_descriptor(media_descriptor &md);
+
+    /**
+     * Entries whose file name or volume name contains text (case-insensitive).
+     */
+    std::vector<const media_index_entry_t *> find(const std::string &text);
+
+    /**
+     * Groups of two or more entries with the same content hash.
+     */
+    std::vector<std::vector<const media_index_entry_t *>> duplicates();
+
+    size_t size() { return entries.size(); }
+
+    /**
+     * Identify, hash and fingerprint one file.
+     */
+    static bool index_file(const std::string &path, media_index_entry_t &entry);
+
+protected:
+    std::string index_path;
+    std::unordered_map<std::string, media_index_entry_t> entries;
+};
@@ -0,0 +1,176 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "util/RewindBuffer.hpp"
+
+/**
+ * Delta format, for each page that differs from the keyframe:
+ *   uint32 page number, uint16 encoded length, then runs of
+ *   uint8 unchanged-byte count, uint8 literal count, literal XOR bytes.
+ */
+
+RewindBuffer::RewindBuffer(size_t budget_bytes, int keyframe_interval)
+    : budget(budget_bytes), keyframe_interval(keyframe_interval) {
+}
+
+size_t RewindBuffer::entry_size(const entry_t &e) const {
+    return sizeof(entry_t) + e.delta.capacity() + (e.is_key ? e.key->capacity() : 0);
+}
+
+void RewindBuffer::clear() {
+    entries.clear();
+    used = 0;
+    since_key = 0;
+    keys = 0;
+}
+
+void RewindBuffer::push_key(const std::vector<uint8_t> &state) {
+    entry_t e;
+    e.key = std::make_shared<const std::vector<uint8_t>>(state);
+    e.is_key = true;
+    used += entry_size(e);
+    entries.push_back(std::move(e));
+    keys++;
+    since_key = 0;
+}
+
+void RewindBuffer::drop_oldest_group() {
+    do {
+        used -= entry_size(entries.front());
+        if (entries.front().is_key) keys--;
+        entries.pop_front();
+    } while (!entries.empty() && !entries.front().is_key);
+}
+
+void RewindBuffer::push(const std::vector<uint8_t> &state) {
+    if (entries.empty() || since_key + 1 >= keyframe_interval || entries.back().key->size() != state.size()) {
+        push_key(state);
+    } else {
+        entry_t e;
+        e.key = entries.back().key;
+        e.is_key = false;
+        encode(e.key->data(), state.data(), state.size(), scratch);
+        if (scratch.size() > state.size() / 2) {
+            push_key(state); // changed too much to be worth it
+        } else {
+            e.delta.assign(scratch.begin(), scratch.end());
+            used += entry_size(e);
+            entries.push_back(std::move(e));
+            since_key++;
+        }
+    }
+
+    // keep at least the group being written to.
+    while (used > budget && keys > 1) {
+        drop_oldest_group();
+    }
+}
+
+bool RewindBuffer::step_back(std::vector<uint8_t> &state) {
+    if (entries.empty()) return false;
+
+    const entry_t &e = entries.back();
+    state.resize(e.key->size());
+    if (e.is_key) {
+        memcpy(state.data(), e.key->data(), e.key->size());
+    } else {
+        decode(e.key->data(), e.key->size(), e.delta, state.data());
+    }
+
+    if (entries.size() > 1) {
+        used -= entry_size(e);
+        if (e.is_key) keys--;
+        entries.pop_back();
+        // count back to the keyframe the next push will encode against.
+        since_key = 0;
+        for (auto it = entries.rbegin(); it != entries.rend() && !it->is_key; ++it) {
+            since_key++;
+        }
+    }
+    return true;
+}
+
+void RewindBuffer::encode(const uint8_t *key, const uint8_t *state, size_t size, std::vector<uint8_t> &out) {
+    // worst case per page: header plus a two-byte run for every other byte.
+    out.resize((size / PAGE + 1) * (6 + PAGE / 2 * 3 + 2));
+    uint8_t *o = out.data();
+
+    for (size_t off = 0; off < size; off += PAGE) {
+        size_t len = (size - off < PAGE) ? size - off : PAGE;
+        const uint8_t *k = key + off;
+        const uint8_t *st = state + off;
+        // memcmp is vectorized by the C library; most pages don't change.
+        if (memcmp(k, st, len) == 0) continue;
+
+        uint32_t page = (uint32_t)(off / PAGE);
+        uint8_t *header = o;
+        memcpy(header, &page, 4);
+        o += 6;
+
+        size_t i = 0;
+        while (i < len) {
+            size_t start = i;
+            // skip equal bytes a word at a time where we can.
+            while (i + 8 <= len && i - start + 8 <= 255) {
+                uint64_t a, b;
+                memcpy(&a, k + i, 8);
+                memcpy(&b, st + i, 8);
+                if (a != b) break;
+                i += 8;
+            }
+            while (i < len && i - start < 255 && k[i] == st[i]) i++;
+            *o++ = (uint8_t)(i - start);
+
+            uint8_t *count = o++;
+            start = i;
+            while (i < len && i - start < 255 && k[i] != st[i]) {
+                *o++ = k[i] ^ st[i];
+                i++;
+            }
+            *count = (uint8_t)(i - start);
+        }
+        uint16_t encoded = (uint16_t)(o - header - 6);
+        memcpy(header + 4, &encoded, 2);
+    }
+    out.resize(o - out.data());
+}
+
+void RewindBuffer::decode(const uint8_t *key, size_t size, const std::vector<uint8_t> &delta, uint8_t *out) {
+    memcpy(out, key, size);
+    const uint8_t *p = delta.data();
+    const uint8_t *end = p + delta.size();
+    while (p + 6 <= end) {
+        uint32_t page;
+        uint16_t encoded;
+        memcpy(&page, p, 4);
+        memcpy(&encoded, p + 4, 2);
+        p += 6;
+        const uint8_t *run_end = p + encoded;
+        uint8_t *dst = out + (size_t)page * PAGE;
+        while (p + 2 <= run_end) {
+            dst += p[0];
+            uint8_t literals = p[1];
+            p += 2;
+            for (uint8_t i = 0; i < literals; i++) {
+                *dst++ ^= *p++;
+            }
+        }
+        p = run_end;
+    }
+}
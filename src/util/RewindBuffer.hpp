@@ -0,0 +1,76 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+/**
+ * A ring of machine snapshots, one per frame, within a memory budget.
+ *
+ * Every keyframe_interval frames (or when a delta would be large, or the
+ * snapshot changes size) the whole snapshot is kept as a keyframe. Frames in
+ * between are stored as the XOR against their keyframe, run-length encoded,
+ * for only the 256-byte pages that differ from it. Any frame decodes from
+ * its keyframe alone. When over budget, the oldest keyframe and its frames
+ * are dropped together.
+ */
+class RewindBuffer {
+public:
+    RewindBuffer(size_t budget_bytes, int keyframe_interval = 60);
+
+    void push(const std::vector<uint8_t> &state);
+
+    /**
+     * Decode the newest frame into state and drop it from the ring. The
+     * oldest frame is never dropped, so holding rewind parks there.
+     * Returns false if the ring is empty.
+     */
+    bool step_back(std::vector<uint8_t> &state);
+
+    void clear();
+    size_t size() const { return entries.size(); }
+    size_t memory_used() const { return used; }
+
+protected:
+    static const size_t PAGE = 256;
+
+    struct entry_t {
+        std::shared_ptr<const std::vector<uint8_t>> key;
+        std::vector<uint8_t> delta;     // empty for the keyframe itself
+        bool is_key;
+    };
+
+    std::deque<entry_t> entries;
+    size_t budget;
+    size_t used = 0;
+    int keyframe_interval;
+    int since_key = 0;
+    int keys = 0;
+    std::vector<uint8_t> scratch;   // encode target, reused so a push makes one allocation
+
+    void push_key(const std::vector<uint8_t> &state);
+    void drop_oldest_group();
+    size_t entry_size(const entry_t &e) const;
+
+    static void encode(const uint8_t *key, const uint8_t *state, size_t size, std::vector<uint8_t> &out);
+    static void decode(const uint8_t *key, size_t size, const std::vector<uint8_t> &delta, uint8_t *out);
+};
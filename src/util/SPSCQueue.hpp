@@ -0,0 +1,53 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Lock-free ring for exactly one producer thread and one consumer thread.
+ * Holds up to N-1 items; N must be a power of two.
+ */
+template <typename T, size_t N>
+class SPSCQueue {
+    static_assert((N & (N - 1)) == 0, "SPSCQueue size must be a power of two");
+
+public:
+    bool push(const T &item) {
+        size_t head = write_pos.load(std::memory_order_relaxed);
+        size_t next = (head + 1) & (N - 1);
+        if (next == read_pos.load(std::memory_order_acquire)) return false; // full
+        items[head] = item;
+        write_pos.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item) {
+        size_t tail = read_pos.load(std::memory_order_relaxed);
+        if (tail == write_pos.load(std::memory_order_acquire)) return false; // empty
+        item = items[tail];
+        read_pos.store((tail + 1) & (N - 1), std::memory_order_release);
+        return true;
+    }
+
+protected:
+    T items[N];
+    std::atomic<size_t> write_pos{0};
+    std::atomic<size_t> read_pos{0};
+};
@@ -0,0 +1,128 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+
+#include "util/Snapshot.hpp"
+
+void SnapshotWriter::begin(uint32_t platform_id) {
+    buf.clear();
+    snapshot_file_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SNAPSHOT_MAGIC, 4);
+    hdr.version = SNAPSHOT_FORMAT_VERSION;
+    hdr.platform_id = platform_id;
+    put(hdr);
+}
+
+void SnapshotWriter::begin_chunk(const char *tag, uint16_t version, uint8_t instance) {
+    snapshot_chunk_header_t ch;
+    memcpy(ch.tag, tag, 4);
+    ch.version = version;
+    ch.instance = instance;
+    ch.reserved = 0;
+    ch.length = 0;
+    chunk_start = buf.size();
+    put(ch);
+}
+
+void SnapshotWriter::end_chunk() {
+    uint32_t length = (uint32_t)(buf.size() - chunk_start - sizeof(snapshot_chunk_header_t));
+    memcpy(buf.data() + chunk_start + offsetof(snapshot_chunk_header_t, length), &length, sizeof(length));
+}
+
+void SnapshotWriter::put_string(const std::string &s) {
+    put((uint32_t)s.size());
+    put(s.data(), s.size());
+}
+
+bool SnapshotWriter::save_file(const std::string &filename) const {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        printf("Failed to open snapshot file: %s\n", filename.c_str());
+        return false;
+    }
+    file.write((const char *)buf.data(), buf.size());
+    return (bool)file;
+}
+
+bool SnapshotReader::open(const uint8_t *data, size_t size) {
+    chunks.clear();
+    pos = end = nullptr;
+
+    snapshot_file_header_t hdr;
+    if (size < sizeof(hdr)) return false;
+    memcpy(&hdr, data, sizeof(hdr));
+    if (memcmp(hdr.magic, SNAPSHOT_MAGIC, 4) != 0 || hdr.version != SNAPSHOT_FORMAT_VERSION) return false;
+    platform = hdr.platform_id;
+
+    size_t off = sizeof(hdr);
+    while (off + sizeof(snapshot_chunk_header_t) <= size) {
+        snapshot_chunk_header_t ch;
+        memcpy(&ch, data + off, sizeof(ch));
+        off += sizeof(ch);
+        if (ch.length > size - off) return false;
+
+        chunk_index_t ci;
+        memcpy(ci.tag, ch.tag, 4);
+        ci.version = ch.version;
+        ci.instance = ch.instance;
+        ci.data = data + off;
+        ci.length = ch.length;
+        chunks.push_back(ci);
+        off += ch.length;
+    }
+    return off == size;
+}
+
+bool SnapshotReader::load_file(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        printf("Failed to open snapshot file: %s\n", filename.c_str());
+        return false;
+    }
+    storage.resize((size_t)file.tellg());
+    file.seekg(0);
+    if (!file.read((char *)storage.data(), storage.size()) || !open(storage.data(), storage.size())) {
+        printf("Not a snapshot file: %s\n", filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotReader::find(const char *tag, uint8_t instance, uint16_t *version) {
+    for (const chunk_index_t &ci : chunks) {
+        if (memcmp(ci.tag, tag, 4) == 0 && ci.instance == instance) {
+            pos = ci.data;
+            end = ci.data + ci.length;
+            if (version) *version = ci.version;
+            return true;
+        }
+    }
+    pos = end = nullptr;
+    return false;
+}
+
+bool SnapshotReader::get_string(std::string &s) {
+    uint32_t len;
+    if (!get(len) || len > remaining()) return false;
+    s.assign((const char *)pos, len);
+    pos += len;
+    return true;
+}
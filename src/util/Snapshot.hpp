@@ -0,0 +1,137 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Machine snapshot container.
+ *
+ *   header:  "GS2S" magic, uint32 format version, uint32 platform id, uint32 reserved
+ *   chunks:  char tag[4], uint16 version, uint8 instance, uint8 reserved, uint32 length, data
+ *
+ * Each device writes its own chunk(s), tagged with a fourcc and, for slot
+ * cards, the slot number as instance. A chunk's version belongs to the
+ * device that wrote it; readers skip chunks they don't know. Values are
+ * host byte order, so snapshots move between builds on the same kind of host.
+ */
+
+#define SNAPSHOT_MAGIC "GS2S"
+#define SNAPSHOT_FORMAT_VERSION 1
+
+struct snapshot_file_header_t {
+    char magic[4];
+    uint32_t version;
+    uint32_t platform_id;
+    uint32_t reserved;
+};
+
+struct snapshot_chunk_header_t {
+    char tag[4];
+    uint16_t version;
+    uint8_t instance;
+    uint8_t reserved;
+    uint32_t length;
+};
+
+class SnapshotWriter {
+public:
+    /**
+     * Start a new snapshot. The buffer keeps its capacity between snapshots,
+     * so a writer that is reused does not allocate once it has grown.
+     */
+    void begin(uint32_t platform_id);
+
+    void begin_chunk(const char *tag, uint16_t version, uint8_t instance = 0);
+    void end_chunk();
+
+    inline void put(const void *src, size_t len) {
+        size_t at = buf.size();
+        buf.resize(at + len);
+        memcpy(buf.data() + at, src, len);
+    }
+    template <typename T> inline void put(const T &v) { put(&v, sizeof(T)); }
+    void put_string(const std::string &s);
+
+    const std::vector<uint8_t> &data() const { return buf; }
+    size_t size() const { return buf.size(); }
+
+    bool save_file(const std::string &filename) const;
+
+protected:
+    std::vector<uint8_t> buf;
+    size_t chunk_start = 0;
+};
+
+class SnapshotReader {
+public:
+    /**
+     * Check the header and index the chunks. The data must outlive the reader.
+     */
+    bool open(const uint8_t *data, size_t size);
+
+    /**
+     * Read a whole snapshot file into the reader and open it.
+     */
+    bool load_file(const std::string &filename);
+
+    uint32_t platform_id() const { return platform; }
+
+    /**
+     * Position the read cursor at the start of a chunk. Returns false if the
+     * snapshot has no such chunk.
+     */
+    bool find(const char *tag, uint8_t instance = 0, uint16_t *version = nullptr);
+
+    /**
+     * All get()s return false, and copy nothing, once they'd run past the end of the chunk.
+     */
+    inline bool get(void *dst, size_t len) {
+        if (len > (size_t)(end - pos)) return false;
+        memcpy(dst, pos, len);
+        pos += len;
+        return true;
+    }
+    template <typename T> inline bool get(T &v) { return get(&v, sizeof(T)); }
+    bool get_string(std::string &s);
+    inline bool skip(size_t len) {
+        if (len > (size_t)(end - pos)) return false;
+        pos += len;
+        return true;
+    }
+
+    size_t remaining() const { return end - pos; }
+
+protected:
+    struct chunk_index_t {
+        char tag[4];
+        uint16_t version;
+        uint8_t instance;
+        const uint8_t *data;
+        uint32_t length;
+    };
+
+    std::vector<uint8_t> storage;   // only used by load_file
+    std::vector<chunk_index_t> chunks;
+    uint32_t platform = 0;
+    const uint8_t *pos = nullptr;
+    const uint8_t *end = nullptr;
+};
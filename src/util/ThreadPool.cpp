@@ -0,0 +1,67 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "util/ThreadPool.hpp"
+
+ThreadPool::ThreadPool(unsigned int num_threads) {
+    if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0) num_threads = 1;
+    for (unsigned int i = 0; i < num_threads; i++) {
+        workers.emplace_back(&ThreadPool::worker, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (auto &t : workers) t.join();
+}
+
+void ThreadPool::enqueue(Job job) {
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        jobs.push_back(std::move(job));
+    }
+    work_ready.notify_one();
+}
+
+void ThreadPool::wait_idle() {
+    std::unique_lock<std::mutex> lk(lock);
+    idle.wait(lk, [this]() { return jobs.empty() && busy == 0; });
+}
+
+void ThreadPool::worker() {
+    std::unique_lock<std::mutex> lk(lock);
+    while (true) {
+        work_ready.wait(lk, [this]() { return stopping || !jobs.empty(); });
+        if (jobs.empty()) break; // stopping, and nothing left to do.
+
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        busy++;
+        lk.unlock();
+
+        job();
+
+        lk.lock();
+        busy--;
+        if (jobs.empty() && busy == 0) idle.notify_all();
+    }
+}
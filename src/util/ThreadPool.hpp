@@ -0,0 +1,60 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * A fixed set of worker threads pulling jobs off a shared queue.
+ * Jobs must not throw.
+ */
+class ThreadPool {
+public:
+    using Job = std::function<void()>;
+
+    /**
+     * num_threads == 0 means one per host core.
+     */
+    ThreadPool(unsigned int num_threads = 0);
+    ~ThreadPool();
+
+    void enqueue(Job job);
+
+    /**
+     * Block until the queue is empty and every worker is idle.
+     */
+    void wait_idle();
+
+    unsigned int size() { return (unsigned int)workers.size(); }
+
+protected:
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+    std::mutex lock;
+    std::condition_variable work_ready;
+    std::condition_variable idle;
+    unsigned int busy = 0;
+    bool stopping = false;
+
+    void worker();
+};
@@ -0,0 +1,133 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "util/Timeline.hpp"
+
+#ifdef GS2_TIMELINE
+
+/**
+ * One thread's events. Only that thread writes: it fills the slot, then
+ * publishes it by bumping head. The writer copies up to head and afterwards
+ * drops anything the thread may have lapped while it was copying.
+ */
+struct timeline_buffer_t {
+    std::atomic<uint64_t> head{0};
+    std::atomic<const char *> thread_name{nullptr};
+    int tid = 0;
+    timeline_event_t events[TIMELINE_EVENTS];
+};
+
+static std::mutex buffers_lock;
+static std::vector<timeline_buffer_t *> buffers;  // kept for the life of the process, so a finished thread's events can still be written
+static thread_local timeline_buffer_t *thread_buffer = nullptr;
+
+static const std::chrono::steady_clock::time_point timeline_epoch = std::chrono::steady_clock::now();
+
+static timeline_buffer_t *get_thread_buffer() {
+    if (!thread_buffer) {
+        thread_buffer = new timeline_buffer_t();
+        std::lock_guard<std::mutex> lock(buffers_lock);
+        thread_buffer->tid = (int)buffers.size() + 1;
+        buffers.push_back(thread_buffer);
+    }
+    return thread_buffer;
+}
+
+uint64_t timeline_now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - timeline_epoch).count();
+}
+
+void timeline_record(const char *name, uint64_t start_ns, uint64_t duration_ns) {
+    timeline_buffer_t *b = get_thread_buffer();
+    uint64_t head = b->head.load(std::memory_order_relaxed);
+    timeline_event_t &e = b->events[head & (TIMELINE_EVENTS - 1)];
+    e.name = name;
+    e.start_ns = start_ns;
+    e.duration_ns = duration_ns;
+    b->head.store(head + 1, std::memory_order_release);
+}
+
+void timeline_thread_name(const char *name) {
+    get_thread_buffer()->thread_name.store(name, std::memory_order_relaxed);
+}
+
+bool timeline_write(const std::string &path) {
+    FILE *f = fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "Could not open timeline file %s\n", path.c_str());
+        return false;
+    }
+
+    std::vector<timeline_buffer_t *> threads;
+    {
+        std::lock_guard<std::mutex> lock(buffers_lock);
+        threads = buffers;
+    }
+
+    std::vector<timeline_event_t> events;
+    uint64_t count = 0;
+    fprintf(f, "{\"traceEvents\":[\n");
+    for (timeline_buffer_t *b : threads) {
+        const char *thread_name = b->thread_name.load(std::memory_order_relaxed);
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            count ? ",\n" : "", b->tid, thread_name ? thread_name : "thread");
+        count++;
+
+        uint64_t head = b->head.load(std::memory_order_acquire);
+        uint64_t first = head > TIMELINE_EVENTS ? head - TIMELINE_EVENTS : 0;
+        events.clear();
+        for (uint64_t i = first; i < head; i++) {
+            events.push_back(b->events[i & (TIMELINE_EVENTS - 1)]);
+        }
+        uint64_t lapped = b->head.load(std::memory_order_acquire);
+        uint64_t valid = lapped > TIMELINE_EVENTS ? lapped - TIMELINE_EVENTS : 0;
+
+        for (uint64_t i = (valid > first ? valid - first : 0); i < events.size(); i++) {
+            const timeline_event_t &e = events[i];
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%" PRIu64 ".%03u,\"dur\":%" PRIu64 ".%03u}",
+                e.name, b->tid, e.start_ns / 1000, (unsigned)(e.start_ns % 1000), e.duration_ns / 1000, (unsigned)(e.duration_ns % 1000));
+        }
+    }
+    fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(f);
+    return true;
+}
+
+#else
+
+uint64_t timeline_now_ns() {
+    return 0;
+}
+
+void timeline_record(const char *name, uint64_t start_ns, uint64_t duration_ns) {
+}
+
+void timeline_thread_name(const char *name) {
+}
+
+bool timeline_write(const std::string &path) {
+    fprintf(stderr, "This build has no timeline (configure with -DGS2_TIMELINE=ON)\n");
+    return false;
+}
+
+#endif
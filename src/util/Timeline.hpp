@@ -0,0 +1,66 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * Host-side timeline of the frame loop, for chrome://tracing or Perfetto.
+ * TIMELINE_SCOPE("name") times the rest of the enclosing block. Each thread
+ * records into its own ring of the last TIMELINE_EVENTS events without
+ * locking, and timeline_write() saves them all as Chrome trace JSON.
+ *
+ * Only built with GS2_TIMELINE (cmake -DGS2_TIMELINE=ON). Otherwise
+ * TIMELINE_SCOPE() and TIMELINE_THREAD() expand to nothing.
+ */
+#ifdef GS2_TIMELINE
+#define TIMELINE_CONCAT2(A, B) A##B
+#define TIMELINE_CONCAT(A, B) TIMELINE_CONCAT2(A, B)
+#define TIMELINE_SCOPE(NAME) TimelineScope TIMELINE_CONCAT(timeline_scope_, __LINE__)(NAME)
+#define TIMELINE_THREAD(NAME) timeline_thread_name(NAME)
+#else
+#define TIMELINE_SCOPE(NAME)
+#define TIMELINE_THREAD(NAME)
+#endif
+
+#define TIMELINE_EVENTS (1 << 17)
+
+struct timeline_event_t {
+    const char *name;       // must be a string literal: only the pointer is kept
+    uint64_t start_ns;
+    uint64_t duration_ns;
+};
+
+uint64_t timeline_now_ns();
+void timeline_record(const char *name, uint64_t start_ns, uint64_t duration_ns);
+void timeline_thread_name(const char *name);
+
+/** Save every thread's events. Returns false if the file can't be written or this build has no timeline. */
+bool timeline_write(const std::string &path);
+
+class TimelineScope {
+public:
+    TimelineScope(const char *name) : name(name), start_ns(timeline_now_ns()) {}
+    ~TimelineScope() { timeline_record(name, start_ns, timeline_now_ns() - start_ns); }
+
+protected:
+    const char *name;
+    uint64_t start_ns;
+};
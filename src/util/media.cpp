@@ -27,6 +27,7 @@
 #include "devices/diskii/diskii_fmt.hpp"
 #include "devices/diskii/diskii.hpp"
 #include "strndup.h"
+#include "util/ChunkedImage.hpp"
 
 /**
  * First goal:
@@ -180,6 +181,7 @@ int display_media_descriptor(media_descriptor& md) {
     std::cout << "<> Media Descriptor: " << md.filename << std::endl;
     std::cout << "  Media Type: " << get_media_type_name(md.media_type) << std::endl;
     std::cout << "  Interleave: " << get_interleave_name(md.interleave) << std::endl;
+    std::cout << "  Container: " << (md.container == CONTAINER_CHUNKED ? "CHUNKED" : "FLAT") << std::endl;
     std::cout << "  Block Size: " << md.block_size << std::endl;
     std::cout << "  Block Count: " << md.block_count << std::endl;
     std::cout << "  File Size: " << md.file_size << std::endl;
@@ -286,16 +288,16 @@ bool isFileReadOnly(const std::string& filePath) {
     #endif
 }
 
-int identify_media(media_descriptor& md) {
+int identify_media(media_descriptor& md, bool quiet) {
     if (isFileReadOnly(md.filename)) md.write_protected = true;
     else md.write_protected = false;
     if (compare_suffix(md.filename, ".2mg")) {
         format_2mg_t hdr;
         if (read_2mg_header(hdr, md.filename) != 0) {
-            std::cerr << "Failed to read 2MG header: " << md.filename << std::endl;
+            if (!quiet) std::cerr << "Failed to read 2MG header: " << md.filename << std::endl;
             return -1;
         }
-        display_2mg_header(hdr);
+        if (!quiet) display_2mg_header(hdr);
 
         if (hdr.image_format == 0x00000000) { // DOS 3.3 Sector Order. Only ever 143k disks.
             md.interleave = INTERLEAVE_DO;
@@ -313,7 +315,7 @@ int identify_media(media_descriptor& md) {
             md.interleave = INTERLEAVE_NONE;
             md.media_type = MEDIA_PRENYBBLE;
         } else {
-            std::cerr << "Unknown image format: " << hdr.image_format << std::endl;
+            if (!quiet) std::cerr << "Unknown image format: " << hdr.image_format << std::endl;
             return -1;
         }
         md.file_size = get_file_size(md.filename);
@@ -338,7 +340,7 @@ int identify_media(media_descriptor& md) {
         // if file size is not 140K, then error.
         md.file_size = get_file_size(md.filename);
         if (md.file_size != 560 * 256) {
-            std::cerr << "File size is not 140K: " << md.filename << std::endl;
+            if (!quiet) std::cerr << "File size is not 140K: " << md.filename << std::endl;
             return -1;
         }
         md.block_size = 256;
@@ -365,6 +367,21 @@ int identify_media(media_descriptor& md) {
         md.data_offset = 0;
         //md.write_protected = false /*true*/;
         md.dos33_volume = 0x01; // might want to try to snag this from the DOS33 VTOC
+    } else if (compare_suffix(md.filename, ".gsc")) {
+        gsc_header_t hdr;
+        if (!ChunkedImage::read_header(md.filename, hdr)) {
+            if (!quiet) std::cerr << "Failed to read GSC header: " << md.filename << std::endl;
+            return -1;
+        }
+        md.media_type = MEDIA_BLK;
+        md.container = CONTAINER_CHUNKED;
+        md.file_size = get_file_size(md.filename);
+        md.block_size = hdr.block_size;
+        md.block_count = hdr.block_count;
+        md.data_size = (uint64_t)hdr.block_size * hdr.block_count;
+        md.interleave = INTERLEAVE_NONE;
+        md.data_offset = 0; // blocks are addressed through the chunk index.
+        if (hdr.flags & GSC_FLAG_LOCKED) md.write_protected = true;
     } else if (compare_suffix(md.filename, ".nib")) {
         md.media_type = MEDIA_PRENYBBLE;
         md.file_size = get_file_size(md.filename);
@@ -374,7 +391,7 @@ int identify_media(media_descriptor& md) {
         md.interleave = INTERLEAVE_NONE;
         md.data_offset = 0;
     } else {
-        std::cerr << "Unknown media type: " << md.filename << std::endl;
+        if (!quiet) std::cerr << "Unknown media type: " << md.filename << std::endl;
         return -1;
     }
     md.filestub = extract_filename(md.filename);
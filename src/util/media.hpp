@@ -95,6 +95,16 @@ typedef enum media_type_t {
     MEDIA_BLK, /* generic block image */
 } media_type_t;
 
+/**
+ * How the blocks are laid out in the host file. Flat images are one
+ * contiguous run of blocks starting at data_offset; chunked images are
+ * .gsc containers (see util/ChunkedImage.hpp).
+ */
+typedef enum media_container_t {
+    CONTAINER_FLAT,
+    CONTAINER_CHUNKED,
+} media_container_t;
+
 //typedef uint8_t nibblized_image_t[0x1A00 * 35];
 
 typedef struct media_descriptor {
@@ -105,6 +115,7 @@ typedef struct media_descriptor {
     FILE *fp = nullptr;
     media_type_t media_type = MEDIA_BLK;
     media_interleave_t interleave = INTERLEAVE_NONE;
+    media_container_t container = CONTAINER_FLAT;
     nibblized_disk_t* nibblized = nullptr;
     uint64_t data_offset = 0;
     uint16_t block_size = 0;
@@ -115,6 +126,15 @@ typedef struct media_descriptor {
     uint16_t dos33_volume = 254;
 } media_descriptor;
 
-int identify_media(media_descriptor& md);
+/**
+ * Fill in md from the file named in md.filename. Returns 0 on success.
+ * quiet keeps it from printing the 2MG header and its complaints, for callers
+ * (like the media indexer) that look at many files at once.
+ */
+int identify_media(media_descriptor& md, bool quiet = false);
 int display_media_descriptor(media_descriptor& md);
 int display_2mg_header(format_2mg_t& hdr);
+
+bool compare_suffix(const std::string& filename, const char* suffix);
+const char * get_media_type_name(media_type_t media_type);
+const char * get_interleave_name(media_interleave_t interleave);
@@ -36,16 +36,29 @@ int Mounts::register_drive(drive_type_t drive_type, uint64_t key) {
     return 0;
 }
 
+/**
+ * While an input recording replays, media changes come from the recording.
+ */
+bool Mounts::live_change_blocked() {
+    if (input_log && input_log->is_replaying() && !input_log->is_applying()) {
+        std::cerr << "Media can't be changed while replaying recorded input" << std::endl;
+        return true;
+    }
+    return false;
+}
+
 int Mounts::mount_media(disk_mount_t disk_mount) {
+    if (live_change_blocked()) return false;
 
     std::cout << "Mounting disk " << disk_mount.filename << " in slot " << disk_mount.slot << " drive " << disk_mount.drive << std::endl;
     media_descriptor * media = new media_descriptor();
     media->filename = disk_mount.filename;
-    if (identify_media(*media) != 0) {
+    if ((media_index == nullptr || !media_index->fill_descriptor(*media)) && identify_media(*media) != 0) {
         std::cerr << "Failed to identify media " << disk_mount.filename << std::endl;
         return false;
     }
     display_media_descriptor(*media);
+    changes++;
 
     uint64_t key = (disk_mount.slot << 8) | disk_mount.drive;
     mounted_media[key].media = media;
@@ -66,6 +79,7 @@ int Mounts::mount_media(disk_mount_t disk_mount) {
         std::cerr << "Invalid slot. Expected 5 or 6" << std::endl;
     }
 
+    if (input_log) input_log->record(cpu->cycles, INPUT_MOUNT, key, disk_mount.filename);
     return key;
 }
 
@@ -75,6 +89,9 @@ int Mounts::unmount_media(uint64_t key, unmount_action_t action) {
     if (it == mounted_media.end()) {
         return false; // not mounted.
     }
+    if (live_change_blocked()) return false;
+    changes++;
+    if (input_log) input_log->record(cpu->cycles, INPUT_UNMOUNT, key);
     if (it->second.drive_type == DRIVE_TYPE_DISKII) {
         uint8_t slot = key >> 8;
         uint8_t drive = key & 0xFF;
@@ -85,6 +102,8 @@ int Mounts::unmount_media(uint64_t key, unmount_action_t action) {
         unmount_diskII(cpu, slot, drive);
         return true;
     } else if (it->second.drive_type == DRIVE_TYPE_PRODOS_BLOCK) {
+        // block writes are cached; push them to the image before letting go of it.
+        flush_pdblock2(cpu, key);
         unmount_pdblock2(cpu, key);
         return true;
     }
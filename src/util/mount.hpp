@@ -21,6 +21,8 @@
 
 #include "cpu.hpp"
 #include "media.hpp"
+#include "util/InputLog.hpp"
+#include "util/MediaIndex.hpp"
 #include <string>
 
 typedef struct {
@@ -58,11 +60,17 @@ enum unmount_action_t {
 class Mounts {
 protected:
     cpu_state *cpu;
+    InputLog *input_log;
 
     std::unordered_map<uint64_t, drive_media_t> mounted_media;
 
+    bool live_change_blocked();
+
 public:
-    Mounts(cpu_state *cpux) : cpu(cpux) {}
+    uint64_t changes = 0; // bumped on every mount and unmount; machine history can't be replayed across one
+    MediaIndex *media_index = nullptr; // if set, unchanged images are described from it instead of re-read
+
+    Mounts(cpu_state *cpux, InputLog *input_log = nullptr) : cpu(cpux), input_log(input_log) {}
     int mount_media(disk_mount_t disk_mount);
     int unmount_media(uint64_t key, unmount_action_t action);
     drive_status_t media_status(uint64_t key);
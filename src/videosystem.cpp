@@ -3,16 +3,27 @@
 #include "videosystem.hpp"
 #include "display/DisplayBase.hpp"
 #include "ui/Clipboard.hpp"
+#include "util/Timeline.hpp"
 
 video_system_t::video_system_t(computer_t *computer) {
 
+    this->computer = computer;
+    event_queue = computer->event_queue;
+
+    // headless: displays still render into their buffers, but nothing is ever shown.
+    if (computer->headless) {
+        window = nullptr;
+        renderer = nullptr;
+        active_display = nullptr;
+        return;
+    }
+
     //SDL_SetHint(SDL_HINT_RENDER_DRIVER, "opengl");
     //SDL_SetHint(SDL_HINT_RENDER_VSYNC, "1");
     if (!SDL_Init(SDL_INIT_VIDEO)) {
         fprintf(stderr, "Error initializing SDL: %s\n", SDL_GetError());
     }
 
-    this->computer = computer;
     clip = new ClipboardImage();
 
     display_color_engine = DM_ENGINE_NTSC;
@@ -20,7 +31,6 @@ video_system_t::video_system_t(computer_t *computer) {
     display_pixel_mode = DM_PIXEL_FUZZ;
 
     display_fullscreen_mode = DISPLAY_WINDOWED_MODE;
-    event_queue = computer->event_queue;
 
     int window_width = (BASE_WIDTH + border_width*2) * SCALE_X;
     int window_height = (BASE_HEIGHT + border_height*2) * SCALE_Y;
@@ -111,14 +121,26 @@ video_system_t::~video_system_t() {
     if (renderer) SDL_DestroyRenderer(renderer);
     if (window) SDL_DestroyWindow(window);
     if (clip) delete clip;
-    SDL_Quit();
+    // headless machines share the process with others; the app quits SDL.
+    if (!computer->headless) SDL_Quit();
 }
 
 void video_system_t::present() {
+    if (!renderer) return;
     SDL_RenderPresent(renderer);
 }
 
+/**
+ * Time between refreshes of the display the window is on, 60Hz if that's unknown.
+ */
+uint64_t video_system_t::refresh_interval_ns() {
+    const SDL_DisplayMode *mode = window ? SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(window)) : nullptr;
+    if (mode == nullptr || mode->refresh_rate <= 0.0f) return 16666667;
+    return (uint64_t)(1000000000.0 / mode->refresh_rate);
+}
+
 void video_system_t::render_frame(SDL_Texture *texture, float offset) {
+    if (!renderer) return;
     float w,h;
     SDL_GetTextureSize(texture, &w, &h);
     float nw = w, nh = h;
@@ -152,6 +174,7 @@ void video_system_t::render_frame(SDL_Texture *texture, float offset) {
 }
 
 void video_system_t::clear() {
+    if (!renderer) return;
     SDL_RenderClear(renderer);
 }
 
@@ -250,15 +273,14 @@ void video_system_t::set_full_frame_redraw() {
 
 
 void video_system_t::send_engine_message() {
-    static char buffer[256];
     const char *display_color_engine_names[] = {
         "NTSC",
         "RGB",
         "Monochrome"
     };
 
-    snprintf(buffer, sizeof(buffer), "Display Engine Set to %s", display_color_engine_names[display_color_engine]);
-    event_queue->addEvent(new Event(EVENT_SHOW_MESSAGE, 0, buffer));
+    snprintf(message, sizeof(message), "Display Engine Set to %s", display_color_engine_names[display_color_engine]);
+    event_queue->addEvent(new Event(EVENT_SHOW_MESSAGE, 0, message));
 }
 
 void video_system_t::toggle_display_engine() {
@@ -311,8 +333,12 @@ void video_system_t::set_active_display (int id) {
     active_display = find_display(id);
 }
 
+/**
+ * Run the active display over this frame's video data, into its buffer.
+ * Touches no SDL state, so it runs on the emulation thread (or headless).
+ */
 void video_system_t::update_display() {
-    clear(); // clear the backbuffer.
+    TIMELINE_SCOPE("update_display");
     //printf("Update display: %p\n", active_display); fflush(stdout);
     active_display->update_display(computer->cpu);
     /*
@@ -322,3 +348,17 @@ void video_system_t::update_display() {
     */
 }
 
+void video_system_t::capture_frame(display_frame_t &frame) {
+    frame.display = active_display;
+    const RGBA_t *pixels = active_display->get_pixels();
+    frame.pixels.assign(pixels, pixels + active_display->get_width() * active_display->get_height());
+}
+
+/**
+ * Draw a captured frame into the backbuffer. Main thread only.
+ */
+void video_system_t::show_frame(const display_frame_t &frame) {
+    clear(); // clear the backbuffer.
+    frame.display->render(frame.pixels.data());
+}
+
@@ -3,6 +3,7 @@
 #include <SDL3/SDL.h>
 #include <functional>
 #include <map>
+#include <vector>
 #include "computer.hpp"
 #include "util/EventQueue.hpp"
 #include "ui/Clipboard.hpp"
@@ -42,6 +43,12 @@ typedef enum {
 } display_pixel_mode_t;
 
 
+/** A finished frame of a display's pixels, on its way from the emulation thread to the window. */
+struct display_frame_t {
+    Display *display = nullptr;
+    std::vector<RGBA_t> pixels;
+};
+
 struct video_system_t {
     computer_t *computer;
     Display * active_display;
@@ -65,6 +72,8 @@ struct video_system_t {
 
     bool force_full_frame_redraw = false;
 
+    char message[256]; // text for EVENT_SHOW_MESSAGE; the event keeps the pointer
+
     ClipboardImage *clip = nullptr;
 
     /*
@@ -90,6 +99,7 @@ struct video_system_t {
     void render_frame(SDL_Texture *texture, float offset);
     void clear();
     void present();
+    uint64_t refresh_interval_ns();
     void display_capture_mouse(bool capture);
     void raise();
     void raise(SDL_Window *window);
@@ -107,6 +117,8 @@ struct video_system_t {
     Display * get_active_display ();
     void set_active_display (int id);
     void update_display();
+    void capture_frame(display_frame_t &frame);
+    void show_frame(const display_frame_t &frame);
 
     //RGBA_t get_mono_color() { return mono_color_table[display_mono_color]; };
 };